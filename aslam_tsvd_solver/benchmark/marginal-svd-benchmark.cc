@@ -0,0 +1,74 @@
+// Benchmarks the marginal SVD backends on reduced systems of growing size.
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <vector>
+
+#include <Eigen/Core>
+
+#include "aslam-tsvd-solver/marginal-svd.h"
+
+using aslam::backend::MarginalSvd;
+using aslam::backend::MarginalSvdBackend;
+
+namespace {
+
+/// Returns the mean wall time [s] of an SVD over a number of runs
+double timeSvd(const Eigen::MatrixXd& A, MarginalSvdBackend backend,
+    size_t num_runs, MarginalSvd* svd) {
+  const auto start = std::chrono::steady_clock::now();
+  for (size_t run = 0; run < num_runs; ++run)
+    aslam::backend::computeMarginalSvd(A, backend, false, svd);
+  return std::chrono::duration<double>(
+      std::chrono::steady_clock::now() - start).count() / num_runs;
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  if (argc > 2) {
+    std::cerr << "Usage: " << argv[0] << " [max_theta_size]" << std::endl;
+    return -1;
+  }
+  const std::ptrdiff_t max_size = argc > 1 ? std::atol(argv[1]) : 500;
+  const std::vector<MarginalSvdBackend> backends = {
+      MarginalSvdBackend::kFixedSize, MarginalSvdBackend::kJacobi,
+      MarginalSvdBackend::kDivideAndConquer,
+      MarginalSvdBackend::kNormalEquations, MarginalSvdBackend::kAuto};
+
+  std::cout << std::setw(6) << "theta";
+  for (const MarginalSvdBackend backend : backends)
+    std::cout << std::setw(14) << marginalSvdBackendToString(backend);
+  std::cout << std::setw(8) << "auto" << std::setw(14) << "max sv error"
+      << std::endl;
+  const std::vector<std::ptrdiff_t> sizes = {3, 6, 10, 20, 50, 100, 200, 500};
+  for (const std::ptrdiff_t n : sizes) {
+    if (n > max_size)
+      break;
+    // stacked reduced rows of a few batches, with a rank deficiency
+    Eigen::MatrixXd A = Eigen::MatrixXd::Random(2 * n, n);
+    if (n > 1)
+      A.col(n - 1) = A.col(0);
+    const size_t num_runs = std::max<size_t>(1, 200000 / (n * n * n));
+
+    MarginalSvd reference;
+    aslam::backend::computeMarginalSvd(A, MarginalSvdBackend::kJacobi, false,
+        &reference);
+    double max_error = 0.0;
+    std::cout << std::setw(6) << n;
+    for (const MarginalSvdBackend backend : backends) {
+      MarginalSvd svd;
+      std::cout << std::setw(14) << timeSvd(A, backend, num_runs, &svd);
+      max_error = std::max(max_error, (svd.singular_values -
+          reference.singular_values).cwiseAbs().maxCoeff() /
+          reference.singular_values(0));
+    }
+    std::cout << std::setw(8) << marginalSvdBackendToString(
+        aslam::backend::selectMarginalSvdBackend(n)) << std::setw(14)
+        << max_error << std::endl;
+  }
+  return 0;
+}
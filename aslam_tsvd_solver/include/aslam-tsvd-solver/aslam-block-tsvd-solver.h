@@ -0,0 +1,139 @@
+#ifndef ASLAM_BACKEND_ASLAM_BLOCK_TSVD_SOLVER_H
+#define ASLAM_BACKEND_ASLAM_BLOCK_TSVD_SOLVER_H
+
+#include <condition_variable>
+#include <cstddef>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <Eigen/Core>
+
+#include "aslam-tsvd-solver/aslam-tsvd-solver.h"
+
+namespace aslam {
+namespace backend {
+/** The class AslamBlockTruncatedSvdSolver computes the Gauss-Newton steps of
+ *  problems whose nuisance columns split into independent blocks, e.g., the
+ *  batches of an incremental calibration problem. Each block is QR-factorized
+ *  on its own thread, the reduced rows of the marginalized columns are
+ *  stacked, and the truncated SVD runs on this small system. The marginal
+ *  analysis is left to AslamTruncatedSvdSolver, and so is the analysis of the
+ *  scaled system, analyzeScaledSystem() re-runs the sparse solve.
+ */
+class AslamBlockTruncatedSvdSolver : public AslamTruncatedSvdSolver {
+ public:
+  /// Constructor with options structure and number of threads (0: all cores)
+  AslamBlockTruncatedSvdSolver(const Options& options = Options(),
+      size_t numThreads = 0);
+  /// Constructor with property tree configuration and number of threads
+  AslamBlockTruncatedSvdSolver(const sm::PropertyTree& config,
+      size_t numThreads = 0);
+  /// Copy constructor
+  AslamBlockTruncatedSvdSolver(const AslamBlockTruncatedSvdSolver& other) =
+      delete;
+  /// Copy assignment operator
+  AslamBlockTruncatedSvdSolver& operator= (
+      const AslamBlockTruncatedSvdSolver& other) = delete;
+  /// Move constructor
+  AslamBlockTruncatedSvdSolver(AslamBlockTruncatedSvdSolver&& other) =
+      delete;
+  /// Move assignment operator
+  AslamBlockTruncatedSvdSolver& operator= (
+      AslamBlockTruncatedSvdSolver&& other) = delete;
+  /// Destructor
+  virtual ~AslamBlockTruncatedSvdSolver();
+
+  /// Solve the system of equations assuming things have been set
+  virtual bool solveSystem(Eigen::VectorXd& dx) override;
+  /// Runs the sparse solver if the last step was solved block-wise, which
+  /// costs a full sparse solve
+  virtual bool analyzeScaledSystem() override;
+
+  virtual std::string name() const override {
+    return std::string("marginal_block_qr_svd");
+  }
+
+  /// Returns the number of threads (0: all cores)
+  size_t getNumThreads() const;
+  /// Sets the number of threads (0: all cores)
+  void setNumThreads(size_t numThreads);
+  /// Returns the number of independent nuisance blocks of the last solve
+  size_t getNumBlocks() const;
+  /// Returns the SVD rank of the last block-wise solve
+  std::ptrdiff_t getBlockSVDRank() const;
+  /// Returns the SVD tolerance of the last block-wise solve
+  double getBlockSVDTolerance() const;
+
+ protected:
+  /// Rows of J and nuisance columns of an independent block
+  struct Block {
+    /// Rows of J
+    std::vector<std::ptrdiff_t> rows;
+    /// Nuisance columns of J
+    std::vector<std::ptrdiff_t> cols;
+  };
+  /// Factorization of the nuisance columns of a block
+  struct BlockFactor {
+    /// Triangular factor of the nuisance columns, rank by rank
+    Eigen::MatrixXd R;
+    /// Column permutation of the nuisance columns
+    Eigen::VectorXi permutation;
+    /// Top rows of Q^T [J_theta e]
+    Eigen::MatrixXd top;
+    /// Reduced rows of [J_theta e], at most as many as its columns
+    Eigen::MatrixXd reduced;
+  };
+
+  /// Splits the nuisance columns into blocks linked by the rows of J
+  void partition(const cholmod_sparse& Jt);
+  /// Factorizes the nuisance columns of a block
+  void factorizeBlock(const cholmod_sparse& Jt, const Eigen::VectorXd& scaling,
+      double qrTolerance, const Block& block, BlockFactor& factor) const;
+  /// Runs a function on all blocks with the configured number of threads
+  template <typename F> void forEachBlock(F function);
+  /// Runs the current job of the pool whenever a new one is posted
+  void runPoolThread(size_t index, size_t generation);
+
+  /// Number of threads (0: all cores)
+  size_t num_threads_;
+  /// Independent blocks, the rows without nuisance columns last
+  std::vector<Block> blocks_;
+  /// Index of each nuisance column in its block
+  std::vector<std::ptrdiff_t> local_cols_;
+  /// Structure of the Jacobian transpose the partition was computed for
+  StructurePattern partition_structure_;
+  /// True if the partition matches partition_structure_
+  bool has_partition_;
+  /// SVD rank of the last block-wise solve
+  std::ptrdiff_t block_svd_rank_;
+  /// SVD tolerance of the last block-wise solve
+  double block_svd_tolerance_;
+  /// True if the last step was solved block-wise
+  bool last_solve_blocked_;
+  /// Threads of the pool, started on demand and kept across solves
+  std::vector<std::thread> pool_;
+  /// Mutex protecting the job of the pool
+  std::mutex pool_mutex_;
+  /// Signals a new job or the end of the pool
+  std::condition_variable pool_job_posted_;
+  /// Signals that the pool threads finished the job
+  std::condition_variable pool_job_done_;
+  /// Job of the pool, valid while pool_num_busy_ is positive
+  const std::function<void()>* pool_job_;
+  /// Incremented for every posted job
+  size_t pool_generation_;
+  /// Number of pool threads taking part in the job
+  size_t pool_num_active_;
+  /// Number of pool threads still running the job
+  size_t pool_num_busy_;
+  /// True once the pool threads must return
+  bool pool_stop_;
+};
+
+}  // namespace backend
+}  // namespace aslam
+
+#endif // ASLAM_BACKEND_ASLAM_BLOCK_TSVD_SOLVER_H
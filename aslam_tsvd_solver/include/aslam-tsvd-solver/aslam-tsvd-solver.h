@@ -2,17 +2,23 @@
 #define ASLAM_CALIBRATION_CORE_LINEAR_SOLVER_H
 
 #include <cstddef>
+#include <memory>
 #include <string>
+#include <utility>
 #include <vector>
 
 #include <aslam/backend/CompressedColumnJacobianTransposeBuilder.hpp>
+#include <aslam/backend/CompressedColumnMatrix.hpp>
 #include <aslam/backend/LinearSystemSolver.hpp>
 #include <Eigen/Core>
 
 #include <truncated-svd-solver/tsvd-solver.h>
 #include <truncated-svd-solver/tsvd-solver-options.h>
 
+#include "aslam-tsvd-solver/marginal-svd.h"
+
 template<typename Entry> struct SuiteSparseQR_factorization;
+struct cholmod_sparse;
 
 namespace sm {
 class PropertyTree;
@@ -22,7 +28,6 @@ namespace aslam {
 namespace backend {
 class DesignVariable;
 class ErrorTerm;
-template<typename I> class CompressedColumnMatrix;
 }
 
 namespace backend {
@@ -34,6 +39,15 @@ class AslamTruncatedSvdSolver
       public truncated_svd_solver::TruncatedSvdSolver {
  public:
   typedef truncated_svd_solver::TruncatedSvdSolverOptions Options;
+  /// Accumulated wall time [s] and number of calls of the solver phases
+  struct Timings {
+    double build_system;
+    double solve_system;
+    double analyze_marginal;
+    size_t num_build_system;
+    size_t num_solve_system;
+    size_t num_analyze_marginal;
+  };
   /// Constructor with options structure
   AslamTruncatedSvdSolver(const Options& options = Options());
   /// Constructor with property tree configuration
@@ -57,14 +71,64 @@ class AslamTruncatedSvdSolver
   virtual bool solveSystem(Eigen::VectorXd& dx) override;
   /// Helper function for dog leg implementation / steepest descent solution
   virtual double rhsJtJrhs() override;
+  /// Returns true if buildSystem() computes the gradient J^T e
+  bool isGradientRequired() const;
+  /// Sets whether buildSystem() computes the gradient J^T e, which only the
+  /// trust region policies other than Gauss-Newton use
+  void setGradientRequired(bool gradientRequired);
 
   virtual std::string name() const override {
     return std::string("marginal_spqr_svd");
   }
 
+  /// Analyzes the marginal of the columns from the marginalization index on:
+  /// a QR factorization eliminates the nuisance columns and the reduced R
+  /// goes through computeMarginalSvd() on the configured backend
   bool analyzeMarginal();
   const aslam::backend::CompressedColumnMatrix<std::ptrdiff_t>&
       getJacobianTranspose() const;
+  /// Sets the current Jacobian transpose, with its error terms and design
+  /// variables, and the marginalization index aside in O(1)
+  void stashJacobianTranspose();
+  /// Swaps the stashed Jacobian transpose back and frees the current one,
+  /// false if nothing is stashed
+  bool restoreJacobianTranspose();
+  /// Frees the stashed Jacobian transpose
+  void clearStashedJacobianTranspose();
+  /// Returns true if a Jacobian transpose is stashed
+  bool hasStashedJacobianTranspose() const;
+  /// Returns the accumulated timings, measured on a monotonic clock
+  const Timings& getTimings() const;
+  /// Resets the accumulated timings
+  void resetTimings();
+  /// Returns the number of factorizations kept for other structures, they
+  /// are reused when their exact pattern comes back
+  size_t getSymbolicCacheCapacity() const;
+  /// Sets the number of factorizations kept for other structures
+  void setSymbolicCacheCapacity(size_t capacity);
+  /// Returns the number of structures whose symbolic factorization was reused
+  size_t getNumSymbolicCacheHits() const;
+  /// Frees the symbolic factorizations kept for other structures
+  void clearSymbolicCache();
+  /// Returns the memory in bytes held by the factorizations kept for other
+  /// structures
+  size_t getSymbolicCacheMemoryUsage() const;
+  /// Returns the current memory usage in bytes, without the factorizations
+  /// kept for other structures
+  size_t getMemoryUsage() const;
+  /// Makes the analysis getters describe the scaled system of the last solve,
+  /// without the rows of the diagonal conditioner if they damped it
+  virtual bool analyzeScaledSystem();
+  /// Returns the diagonal of the covariance from the SVD factors, O(n r)
+  Eigen::VectorXd getCovarianceDiagonal() const;
+  /// Returns the covariance block of the rows and columns [start, start +
+  /// size) from the SVD factors, O(size^2 r)
+  Eigen::MatrixXd getCovarianceBlock(std::ptrdiff_t start,
+      std::ptrdiff_t size) const;
+  /// Returns the backend of the dense SVDs on the marginalized columns
+  MarginalSvdBackend getMarginalSvdBackend() const;
+  /// Sets the backend of the dense SVDs on the marginalized columns
+  void setMarginalSvdBackend(MarginalSvdBackend backend);
 
  protected:
   /// Initialize the matrix structure for the problem
@@ -72,10 +136,84 @@ class AslamTruncatedSvdSolver
       const std::vector<aslam::backend::DesignVariable*>& dvs,
       const std::vector<aslam::backend::ErrorTerm*>& errors,
       bool use_diagonal_conditioner);
+  /// Refreshes the cached Jacobian from its transpose, nullptr on failure,
+  /// with the rows of the diagonal conditioner appended if conditioned
+  cholmod_sparse* updateJacobian(bool conditioned);
+  /// Solves with the current factorization and accounts for its memory
+  void solveFactorized(cholmod_sparse* J, cholmod_dense* e,
+      Eigen::VectorXd& dx);
+  /// Pattern of the Jacobian transpose a factorization was computed for
+  struct StructurePattern {
+    /// Number of rows of the Jacobian transpose
+    size_t num_rows;
+    /// Number of columns of the Jacobian transpose
+    size_t num_cols;
+    /// Marginalization index
+    std::ptrdiff_t marg_start_index;
+    /// True if the conditioner rows are appended
+    bool conditioned;
+    /// Column pointers of the Jacobian transpose
+    std::vector<std::ptrdiff_t> col_ptrs;
+    /// Row indices of the Jacobian transpose
+    std::vector<std::ptrdiff_t> row_indices;
+  };
+  /// Factorization kept for another structure
+  struct CachedFactorization {
+    /// Structure of the factorization
+    StructurePattern pattern;
+    /// Factorization
+    SuiteSparseQR_factorization<double>* factor;
+    /// Memory held by the factorization in bytes
+    size_t memory_usage;
+  };
+  /// Returns true if the current Jacobian transpose has the given structure,
+  /// the row indices are only compared once everything else matches
+  bool matchesStructure(const StructurePattern& pattern,
+      const cholmod_sparse& Jt) const;
+  /// Copies the structure of a Jacobian transpose into a pattern
+  void assignStructure(const cholmod_sparse& Jt,
+      StructurePattern* pattern) const;
+  /// Keeps the current factorization aside and takes the one matching the
+  /// current Jacobian transpose, if any
+  void switchSymbolicFactorization();
+  /// Frees the oldest factorizations kept above the capacity
+  void trimSymbolicCache();
 
- private:
-  aslam::backend::CompressedColumnJacobianTransposeBuilder<std::ptrdiff_t>
-    jacobian_builder_;
+  typedef aslam::backend::CompressedColumnJacobianTransposeBuilder<
+      std::ptrdiff_t> JacobianBuilder;
+  /// Builder of the current Jacobian transpose
+  std::unique_ptr<JacobianBuilder> jacobian_builder_;
+  /// Builder set aside by stashJacobianTranspose(), nullptr once freed
+  std::unique_ptr<JacobianBuilder> stashed_jacobian_builder_;
+  /// Marginalization index matching the stashed Jacobian transpose
+  std::ptrdiff_t stashed_marg_start_index_;
+  /// True if a Jacobian transpose is stashed
+  bool has_stashed_jacobian_transpose_;
+  /// True if the steps are damped by the diagonal conditioner
+  bool use_diagonal_conditioner_;
+  /// True if the last solve appended the rows of the diagonal conditioner
+  bool last_solve_conditioned_;
+  /// True if buildSystem() computes the gradient J^T e
+  bool gradient_required_;
+  /// Error vector padded with the zero targets of the conditioner rows
+  Eigen::VectorXd conditioned_e_;
+  /// Accumulated timings of the solver phases
+  Timings timings_;
+  /// Cached compressed-column Jacobian, reallocated only when it grows
+  cholmod_sparse* jacobian_;
+  /// Structure of the current factorization
+  StructurePattern structure_;
+  /// Memory held by the current factorization in bytes, as retained by the
+  /// solves since it was computed
+  size_t factor_memory_usage_;
+  /// Factorizations of other structures, most recent last
+  std::vector<CachedFactorization> symbolic_cache_;
+  /// Maximum number of factorizations kept for other structures
+  size_t symbolic_cache_capacity_;
+  /// Number of structures whose symbolic factorization was reused
+  size_t num_symbolic_cache_hits_;
+  /// Backend of the dense SVDs on the marginalized columns
+  MarginalSvdBackend marginal_svd_backend_;
 };
 
 }  // namespace backend
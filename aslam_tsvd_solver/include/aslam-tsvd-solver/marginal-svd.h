@@ -0,0 +1,56 @@
+#ifndef ASLAM_BACKEND_MARGINAL_SVD_H
+#define ASLAM_BACKEND_MARGINAL_SVD_H
+
+#include <cstddef>
+#include <string>
+
+#include <Eigen/Core>
+
+namespace aslam {
+namespace backend {
+
+/// Dense SVD backends for the reduced system of the marginalized columns
+enum class MarginalSvdBackend {
+  /// Chosen by the number of columns with selectMarginalSvdBackend()
+  kAuto,
+  /// QR to a stack-allocated square factor, for up to
+  /// kMaxFixedSizeMarginalSvd columns
+  kFixedSize,
+  /// Two-sided Jacobi SVD, the most accurate
+  kJacobi,
+  /// Divide-and-conquer SVD (Jacobi before Eigen 3.3)
+  kDivideAndConquer,
+  /// Eigendecomposition of A^T A, fastest but squares the condition number
+  kNormalEquations
+};
+
+/// Largest number of columns of the fixed-size backend
+const std::ptrdiff_t kMaxFixedSizeMarginalSvd = 6;
+/// Largest number of columns for which kAuto takes the Jacobi SVD
+const std::ptrdiff_t kMaxJacobiMarginalSvd = 16;
+
+/// SVD A = U S V^T with decreasing singular values
+struct MarginalSvd {
+  /// min(rows, cols) singular values
+  Eigen::VectorXd singular_values;
+  /// rows x min(rows, cols) left singular vectors, if requested
+  Eigen::MatrixXd U;
+  /// cols x cols right singular vectors, null space included
+  Eigen::MatrixXd V;
+};
+
+/// Returns the backend kAuto runs for a number of columns
+MarginalSvdBackend selectMarginalSvdBackend(std::ptrdiff_t cols);
+/// Returns the backend of a name (auto, fixed, jacobi, bdc, normal), throws
+/// std::invalid_argument on any other name
+MarginalSvdBackend marginalSvdBackendFromString(const std::string& name);
+/// Returns the name of a backend
+std::string marginalSvdBackendToString(MarginalSvdBackend backend);
+/// Computes the SVD of A with a backend
+void computeMarginalSvd(const Eigen::MatrixXd& A, MarginalSvdBackend backend,
+    bool compute_u, MarginalSvd* svd);
+
+}  // namespace backend
+}  // namespace aslam
+
+#endif // ASLAM_BACKEND_MARGINAL_SVD_H
@@ -0,0 +1,366 @@
+#include "aslam-tsvd-solver/aslam-block-tsvd-solver.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <numeric>
+
+#include <aslam/backend/CompressedColumnMatrix.hpp>
+#include <cholmod.h>
+#include <Eigen/Dense>
+#include <sm/PropertyTree.hpp>
+
+namespace aslam {
+namespace backend {
+
+AslamBlockTruncatedSvdSolver::AslamBlockTruncatedSvdSolver(
+    const Options& options, size_t numThreads)
+    : AslamTruncatedSvdSolver(options),
+      num_threads_(numThreads),
+      has_partition_(false),
+      block_svd_rank_(0),
+      block_svd_tolerance_(-1.0),
+      last_solve_blocked_(false),
+      pool_job_(nullptr),
+      pool_generation_(0),
+      pool_num_active_(0),
+      pool_num_busy_(0),
+      pool_stop_(false) {}
+
+AslamBlockTruncatedSvdSolver::AslamBlockTruncatedSvdSolver(
+    const sm::PropertyTree& config, size_t numThreads)
+    : AslamTruncatedSvdSolver(config),
+      num_threads_(numThreads),
+      has_partition_(false),
+      block_svd_rank_(0),
+      block_svd_tolerance_(-1.0),
+      last_solve_blocked_(false),
+      pool_job_(nullptr),
+      pool_generation_(0),
+      pool_num_active_(0),
+      pool_num_busy_(0),
+      pool_stop_(false) {}
+
+AslamBlockTruncatedSvdSolver::~AslamBlockTruncatedSvdSolver() {
+  {
+    std::lock_guard<std::mutex> lock(pool_mutex_);
+    pool_stop_ = true;
+  }
+  pool_job_posted_.notify_all();
+  for (auto it = pool_.begin(); it != pool_.end(); ++it)
+    it->join();
+}
+
+size_t AslamBlockTruncatedSvdSolver::getNumThreads() const {
+  return num_threads_;
+}
+
+void AslamBlockTruncatedSvdSolver::setNumThreads(size_t numThreads) {
+  num_threads_ = numThreads;
+}
+
+size_t AslamBlockTruncatedSvdSolver::getNumBlocks() const {
+  if (!blocks_.empty() && blocks_.back().cols.empty())
+    return blocks_.size() - 1;
+  return blocks_.size();
+}
+
+std::ptrdiff_t AslamBlockTruncatedSvdSolver::getBlockSVDRank() const {
+  return block_svd_rank_;
+}
+
+double AslamBlockTruncatedSvdSolver::getBlockSVDTolerance() const {
+  return block_svd_tolerance_;
+}
+
+template <typename F>
+void AslamBlockTruncatedSvdSolver::forEachBlock(F function) {
+  const size_t numBlocks = blocks_.size();
+  std::atomic<size_t> nextBlock(0);
+  const std::function<void()> work = [&]() {
+    for (size_t k = nextBlock++; k < numBlocks; k = nextBlock++)
+      function(k);
+  };
+  size_t numThreads = num_threads_ > 0 ? num_threads_ :
+      std::thread::hardware_concurrency();
+  numThreads = std::max<size_t>(1, std::min(numThreads, numBlocks));
+  if (numThreads == 1) {
+    work();
+    return;
+  }
+
+  // the calling thread works along the pool threads
+  while (pool_.size() < numThreads - 1)
+    pool_.push_back(std::thread(&AslamBlockTruncatedSvdSolver::runPoolThread,
+        this, pool_.size(), pool_generation_));
+  {
+    std::lock_guard<std::mutex> lock(pool_mutex_);
+    pool_job_ = &work;
+    pool_num_active_ = numThreads - 1;
+    pool_num_busy_ = numThreads - 1;
+    ++pool_generation_;
+  }
+  pool_job_posted_.notify_all();
+  work();
+  std::unique_lock<std::mutex> lock(pool_mutex_);
+  pool_job_done_.wait(lock, [this]() {return pool_num_busy_ == 0;});
+  pool_job_ = nullptr;
+}
+
+void AslamBlockTruncatedSvdSolver::runPoolThread(size_t index,
+    size_t generation) {
+  std::unique_lock<std::mutex> lock(pool_mutex_);
+  while (true) {
+    pool_job_posted_.wait(lock, [this, generation]() {
+      return pool_stop_ || pool_generation_ != generation;});
+    if (pool_stop_)
+      return;
+    generation = pool_generation_;
+    if (index >= pool_num_active_)
+      continue;
+    const std::function<void()>* job = pool_job_;
+    lock.unlock();
+    (*job)();
+    lock.lock();
+    if (--pool_num_busy_ == 0)
+      pool_job_done_.notify_all();
+  }
+}
+
+void AslamBlockTruncatedSvdSolver::partition(const cholmod_sparse& Jt) {
+  const std::ptrdiff_t j = margStartIndex_;
+  const std::ptrdiff_t numRows = Jt.ncol;
+  const std::ptrdiff_t* p = static_cast<const std::ptrdiff_t*>(Jt.p);
+  const std::ptrdiff_t* i = static_cast<const std::ptrdiff_t*>(Jt.i);
+
+  // link the nuisance columns sharing a row
+  std::vector<std::ptrdiff_t> parent(j);
+  std::iota(parent.begin(), parent.end(), 0);
+  auto find = [&parent](std::ptrdiff_t col) {
+    while (parent[col] != col) {
+      parent[col] = parent[parent[col]];
+      col = parent[col];
+    }
+    return col;
+  };
+  for (std::ptrdiff_t row = 0; row < numRows; ++row) {
+    std::ptrdiff_t root = -1;
+    for (std::ptrdiff_t idx = p[row]; idx < p[row + 1]; ++idx) {
+      if (i[idx] >= j)
+        continue;
+      const std::ptrdiff_t colRoot = find(i[idx]);
+      if (root == -1)
+        root = colRoot;
+      else if (colRoot != root)
+        parent[colRoot] = root;
+    }
+  }
+
+  // assign rows and columns to the blocks, columns without rows stay zero
+  blocks_.clear();
+  Block thetaBlock;
+  std::vector<std::ptrdiff_t> rootBlocks(j, -1);
+  for (std::ptrdiff_t row = 0; row < numRows; ++row) {
+    std::ptrdiff_t col = -1;
+    for (std::ptrdiff_t idx = p[row]; idx < p[row + 1] && col == -1; ++idx)
+      if (i[idx] < j)
+        col = i[idx];
+    if (col == -1) {
+      thetaBlock.rows.push_back(row);
+      continue;
+    }
+    const std::ptrdiff_t root = find(col);
+    if (rootBlocks[root] == -1) {
+      rootBlocks[root] = blocks_.size();
+      blocks_.push_back(Block());
+    }
+    blocks_[rootBlocks[root]].rows.push_back(row);
+  }
+  for (std::ptrdiff_t col = 0; col < j; ++col) {
+    const std::ptrdiff_t block = rootBlocks[find(col)];
+    if (block != -1)
+      blocks_[block].cols.push_back(col);
+  }
+
+  // largest blocks first to balance the threads
+  std::stable_sort(blocks_.begin(), blocks_.end(),
+      [](const Block& a, const Block& b) {
+    return a.rows.size() * a.cols.size() > b.rows.size() * b.cols.size();
+  });
+  local_cols_.assign(j, -1);
+  for (auto it = blocks_.cbegin(); it != blocks_.cend(); ++it)
+    for (size_t k = 0; k < it->cols.size(); ++k)
+      local_cols_[it->cols[k]] = k;
+  if (!thetaBlock.rows.empty())
+    blocks_.push_back(thetaBlock);
+  assignStructure(Jt, &partition_structure_);
+  has_partition_ = true;
+}
+
+void AslamBlockTruncatedSvdSolver::factorizeBlock(const cholmod_sparse& Jt,
+    const Eigen::VectorXd& scaling, double qrTolerance, const Block& block,
+    BlockFactor& factor) const {
+  const std::ptrdiff_t j = margStartIndex_;
+  const std::ptrdiff_t nt = Jt.nrow - j;
+  const std::ptrdiff_t m = block.rows.size();
+  const std::ptrdiff_t nc = block.cols.size();
+  const std::ptrdiff_t* p = static_cast<const std::ptrdiff_t*>(Jt.p);
+  const std::ptrdiff_t* i = static_cast<const std::ptrdiff_t*>(Jt.i);
+  const double* x = static_cast<const double*>(Jt.x);
+
+  // dense copy of the nuisance columns and of [J_theta e]
+  Eigen::MatrixXd A = Eigen::MatrixXd::Zero(m, nc);
+  Eigen::MatrixXd B = Eigen::MatrixXd::Zero(m, nt + 1);
+  for (std::ptrdiff_t r = 0; r < m; ++r) {
+    const std::ptrdiff_t row = block.rows[r];
+    for (std::ptrdiff_t idx = p[row]; idx < p[row + 1]; ++idx) {
+      const std::ptrdiff_t col = i[idx];
+      if (col < j)
+        A(r, local_cols_[col]) = x[idx] * scaling(col);
+      else
+        B(r, col - j) = x[idx] * scaling(col);
+    }
+    B(r, nt) = _e(row);
+  }
+
+  // eliminate the nuisance columns, the rows below their rank only involve
+  // the marginalized columns
+  Eigen::MatrixXd reduced;
+  if (nc > 0) {
+    Eigen::ColPivHouseholderQR<Eigen::MatrixXd> qr(A);
+    const std::ptrdiff_t diagonalSize = std::min(m, nc);
+    std::ptrdiff_t rank = 0;
+    while (rank < diagonalSize &&
+        std::fabs(qr.matrixQR()(rank, rank)) > qrTolerance)
+      ++rank;
+    B.applyOnTheLeft(qr.householderQ().adjoint());
+    factor.R = qr.matrixQR().topLeftCorner(rank, rank).
+        triangularView<Eigen::Upper>();
+    factor.permutation = qr.colsPermutation().indices();
+    factor.top = B.topRows(rank);
+    reduced = B.bottomRows(m - rank);
+  }
+  else
+    reduced = B;
+
+  // compress the reduced rows to a triangle
+  if (reduced.rows() > nt + 1) {
+    Eigen::HouseholderQR<Eigen::MatrixXd> qr(reduced);
+    factor.reduced = qr.matrixQR().topRows(nt + 1).
+        triangularView<Eigen::Upper>();
+  }
+  else
+    factor.reduced = reduced;
+}
+
+bool AslamBlockTruncatedSvdSolver::solveSystem(Eigen::VectorXd& dx) {
+  aslam::backend::CompressedColumnMatrix<std::ptrdiff_t>& Jt =
+    jacobian_builder_->J_transpose();
+  cholmod_sparse Jt_CS;
+  Jt.getView(&Jt_CS);
+  const std::ptrdiff_t j = margStartIndex_;
+  const std::ptrdiff_t n = Jt_CS.nrow;
+  // the partition only depends on the sparsity pattern, which Optimizer2
+  // rebuilds on every optimize()
+  if (j > 0 && j < n && (!has_partition_ ||
+      !matchesStructure(partition_structure_, Jt_CS)))
+    partition(Jt_CS);
+
+  // a single block gains nothing over the sparse solver, and the conditioner
+  // rows are left to it as well
+  last_solve_blocked_ = j > 0 && j < n && getNumBlocks() > 1 &&
+      !use_diagonal_conditioner_;
+  if (!last_solve_blocked_)
+    return AslamTruncatedSvdSolver::solveSystem(dx);
+  last_solve_conditioned_ = false;
+  const auto start = std::chrono::steady_clock::now();
+  const std::ptrdiff_t nt = n - j;
+  const std::ptrdiff_t* i = static_cast<const std::ptrdiff_t*>(Jt_CS.i);
+  const std::ptrdiff_t* p = static_cast<const std::ptrdiff_t*>(Jt_CS.p);
+  const double* x = static_cast<const double*>(Jt_CS.x);
+
+  // column scaling and tolerance as in the sparse solver
+  Eigen::VectorXd norms = Eigen::VectorXd::Zero(n);
+  for (std::ptrdiff_t idx = 0; idx < p[Jt_CS.ncol]; ++idx)
+    norms(i[idx]) += x[idx] * x[idx];
+  norms = norms.cwiseSqrt();
+  Eigen::VectorXd scaling = Eigen::VectorXd::Ones(n);
+  if (tsvd_options_.columnScaling)
+    for (std::ptrdiff_t col = 0; col < n; ++col)
+      if (norms(col) > tsvd_options_.epsNorm)
+        scaling(col) = 1.0 / norms(col);
+  const double maxNorm = j > 0 ?
+      norms.head(j).cwiseProduct(scaling.head(j)).maxCoeff() : 0.0;
+  const double qrTolerance = tsvd_options_.qrTol != -1.0 ?
+      tsvd_options_.qrTol : 20.0 * (Jt_CS.ncol + j) * tsvd_options_.epsQR *
+      maxNorm;
+
+  // eliminate the nuisance columns block by block
+  std::vector<BlockFactor> factors(blocks_.size());
+  forEachBlock([&](size_t k) {
+    factorizeBlock(Jt_CS, scaling, qrTolerance, blocks_[k], factors[k]);
+  });
+
+  // truncated SVD of the stacked reduced rows, the tolerance counts the
+  // rows left by the nuisance ranks as the sparse solver does, not the
+  // compressed ones
+  std::ptrdiff_t numReducedRows = 0;
+  std::ptrdiff_t qrRank = 0;
+  for (auto it = factors.cbegin(); it != factors.cend(); ++it) {
+    numReducedRows += it->reduced.rows();
+    qrRank += it->R.rows();
+  }
+  Eigen::MatrixXd reduced(numReducedRows, nt + 1);
+  std::ptrdiff_t row = 0;
+  for (auto it = factors.cbegin(); it != factors.cend(); ++it) {
+    reduced.middleRows(row, it->reduced.rows()) = it->reduced;
+    row += it->reduced.rows();
+  }
+  MarginalSvd svd;
+  computeMarginalSvd(reduced.leftCols(nt), marginal_svd_backend_, true, &svd);
+  const Eigen::VectorXd& singularValues = svd.singular_values;
+  block_svd_tolerance_ = tsvd_options_.svdTol != -1.0 ?
+      tsvd_options_.svdTol : singularValues.size() > 0 ?
+      std::max<std::ptrdiff_t>(Jt_CS.ncol - qrRank, nt) * singularValues(0) *
+      tsvd_options_.epsSVD : 0.0;
+  std::ptrdiff_t rank = 0;
+  while (rank < singularValues.size() &&
+      singularValues(rank) > block_svd_tolerance_)
+    ++rank;
+  block_svd_rank_ = rank;
+  const Eigen::VectorXd xTheta = svd.V.leftCols(rank) *
+      (svd.U.leftCols(rank).transpose() * reduced.col(nt)).
+      cwiseQuotient(singularValues.head(rank));
+
+  // back-substitute the nuisance columns block by block
+  dx = Eigen::VectorXd::Zero(n);
+  dx.tail(nt) = xTheta;
+  forEachBlock([&](size_t k) {
+    const BlockFactor& factor = factors[k];
+    const std::ptrdiff_t blockRank = factor.R.rows();
+    if (blockRank == 0)
+      return;
+    const Eigen::VectorXd y = factor.R.triangularView<Eigen::Upper>().solve(
+        factor.top.col(nt) - factor.top.leftCols(nt) * xTheta);
+    for (std::ptrdiff_t q = 0; q < blockRank; ++q)
+      dx(blocks_[k].cols[factor.permutation(q)]) = y(q);
+  });
+  dx = dx.cwiseProduct(scaling);
+
+  timings_.solve_system += std::chrono::duration<double>(
+      std::chrono::steady_clock::now() - start).count();
+  ++timings_.num_solve_system;
+  return true;
+}
+
+bool AslamBlockTruncatedSvdSolver::analyzeScaledSystem() {
+  if (!last_solve_blocked_)
+    return AslamTruncatedSvdSolver::analyzeScaledSystem();
+  last_solve_blocked_ = false;
+  Eigen::VectorXd dx;
+  return AslamTruncatedSvdSolver::solveSystem(dx);
+}
+
+}  // namespace backend
+}  // namespace aslam
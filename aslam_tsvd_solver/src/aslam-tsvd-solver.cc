@@ -1,10 +1,15 @@
 #include "aslam-tsvd-solver/aslam-tsvd-solver.h"
 
 #include <algorithm>
+#include <chrono>
 #include <cmath>
+#include <limits>
+#include <utility>
+#include <vector>
 
 #include <aslam/backend/CompressedColumnMatrix.hpp>
 #include <cholmod.h>
+#include <SuiteSparseQR.hpp>
 #include <Eigen/Dense>
 #include <glog/logging.h>
 #include <sm/PropertyTree.hpp>
@@ -14,6 +19,16 @@
 namespace aslam {
 namespace backend {
 
+namespace {
+
+/// Returns the seconds elapsed on the monotonic clock since start
+double secondsSince(const std::chrono::steady_clock::time_point& start) {
+  return std::chrono::duration<double>(
+      std::chrono::steady_clock::now() - start).count();
+}
+
+}  // namespace
+
 AslamTruncatedSvdSolver::Options createTsvdOptionsFromPropertyTree(
     const sm::PropertyTree& config) {
   AslamTruncatedSvdSolver::Options tsvd_options;
@@ -29,30 +44,68 @@ AslamTruncatedSvdSolver::Options createTsvdOptionsFromPropertyTree(
 }
 
 AslamTruncatedSvdSolver::AslamTruncatedSvdSolver(const Options& options)
-    : truncated_svd_solver::TruncatedSvdSolver(options) {}
+    : truncated_svd_solver::TruncatedSvdSolver(options),
+      jacobian_builder_(new JacobianBuilder()),
+      stashed_marg_start_index_(0),
+      has_stashed_jacobian_transpose_(false),
+      use_diagonal_conditioner_(false),
+      last_solve_conditioned_(false),
+      gradient_required_(true),
+      jacobian_(nullptr),
+      factor_memory_usage_(0),
+      symbolic_cache_capacity_(2),
+      num_symbolic_cache_hits_(0),
+      marginal_svd_backend_(MarginalSvdBackend::kAuto) {
+  resetTimings();
+}
 
 AslamTruncatedSvdSolver::AslamTruncatedSvdSolver(const sm::PropertyTree& config)
-    : AslamTruncatedSvdSolver(createTsvdOptionsFromPropertyTree(config)) {}
+    : AslamTruncatedSvdSolver(createTsvdOptionsFromPropertyTree(config)) {
+  symbolic_cache_capacity_ = config.getInt("symbolicCacheCapacity",
+      symbolic_cache_capacity_);
+  marginal_svd_backend_ = marginalSvdBackendFromString(config.getString(
+      "marginalSvdBackend", marginalSvdBackendToString(marginal_svd_backend_)));
+}
 
-AslamTruncatedSvdSolver::~AslamTruncatedSvdSolver() {}
+AslamTruncatedSvdSolver::~AslamTruncatedSvdSolver() {
+  clearSymbolicCache();
+  if (jacobian_ != nullptr)
+    cholmod_l_free_sparse(&jacobian_, &cholmod_);
+}
 
 void AslamTruncatedSvdSolver::buildSystem(size_t numThreads,
                                           bool useMEstimator) {
-  jacobian_builder_.buildSystem(numThreads, useMEstimator);
+  const auto start = std::chrono::steady_clock::now();
+  jacobian_builder_->buildSystem(numThreads, useMEstimator);
+  // gradient J^T e for the trust region policies that use it
+  if (gradient_required_)
+    jacobian_builder_->J_transpose().rightMultiply(_e, _rhs);
+  else
+    _rhs.resize(0);
+  timings_.build_system += secondsSince(start);
+  ++timings_.num_build_system;
 }
 
 bool AslamTruncatedSvdSolver::solveSystem(Eigen::VectorXd& dx) {
-  aslam::backend::CompressedColumnMatrix<std::ptrdiff_t>& Jt =
-    jacobian_builder_.J_transpose();
-  cholmod_sparse Jt_CS;
-  Jt.getView(&Jt_CS);
-  cholmod_sparse* J_CS = cholmod_l_transpose(&Jt_CS, 1, &cholmod_);
+  const auto start = std::chrono::steady_clock::now();
+  const bool conditioned = use_diagonal_conditioner_ &&
+      _diagonalConditioner.size() > 0;
+  cholmod_sparse* J_CS = updateJacobian(conditioned);
   if (J_CS == NULL)
     return false;
   cholmod_dense e_CD;
-  truncated_svd_solver::eigenDenseToCholmodDenseView(_e, &e_CD);
+  if (conditioned) {
+    // the conditioner rows D dx = 0 damp the step as J^T J + D^2 would
+    conditioned_e_.resize(_e.size() + _diagonalConditioner.size());
+    conditioned_e_.head(_e.size()) = _e;
+    conditioned_e_.tail(_diagonalConditioner.size()).setZero();
+    truncated_svd_solver::eigenDenseToCholmodDenseView(conditioned_e_, &e_CD);
+  }
+  else
+    truncated_svd_solver::eigenDenseToCholmodDenseView(_e, &e_CD);
   bool status = true;
-  solve(J_CS, &e_CD, margStartIndex_, dx);
+  solveFactorized(J_CS, &e_CD, dx);
+  last_solve_conditioned_ = conditioned;
   if (tsvd_options_.verbose) {
     std::cout << "SVD rank: " << getSVDRank() << std::endl;
     std::cout << "SVD rank deficiency: " << getSVDRankDeficiency()
@@ -67,41 +120,396 @@ bool AslamTruncatedSvdSolver::solveSystem(Eigen::VectorXd& dx) {
     std::cout << "V-matrix (observability basis, column vectors correspond to singular values)\n" << getMatrixV()
       << std::endl;
   }
-  cholmod_l_free_sparse(&J_CS, &cholmod_);
+  timings_.solve_system += secondsSince(start);
+  ++timings_.num_solve_system;
   return status;
 }
 
 double AslamTruncatedSvdSolver::rhsJtJrhs() {
-  return 0.0;
+  CHECK(gradient_required_) << "rhsJtJrhs() needs the gradient J^T e";
+  Eigen::VectorXd Jrhs;
+  jacobian_builder_->J_transpose().leftMultiply(_rhs, Jrhs);
+  return Jrhs.squaredNorm();
+}
+
+bool AslamTruncatedSvdSolver::isGradientRequired() const {
+  return gradient_required_;
+}
+
+void AslamTruncatedSvdSolver::setGradientRequired(bool gradientRequired) {
+  gradient_required_ = gradientRequired;
 }
 
 void AslamTruncatedSvdSolver::initMatrixStructureImplementation(const
     std::vector<aslam::backend::DesignVariable*>& dvs, const
     std::vector<aslam::backend::ErrorTerm*>& errors, bool
     useDiagonalConditioner) {
-  CHECK(!useDiagonalConditioner) << "useDiagonalConditioner not supported in AslamTruncatedSvdSolver";
+  use_diagonal_conditioner_ = useDiagonalConditioner;
+  // Optimizer2 re-initializes the structure on every optimize(), keep the
+  // symbolic factorization away from clear() and reuse it if it still fits
+  SuiteSparseQR_factorization<double>* factor = factor_;
+  factor_ = nullptr;
   clear();
-  jacobian_builder_.initMatrixStructure(dvs, errors);
+  factor_ = factor;
+  jacobian_builder_->initMatrixStructure(dvs, errors);
+  switchSymbolicFactorization();
 }
 
-bool AslamTruncatedSvdSolver::analyzeMarginal() {
-  aslam::backend::CompressedColumnMatrix<std::ptrdiff_t>& Jt =
-      jacobian_builder_.J_transpose();
+bool AslamTruncatedSvdSolver::matchesStructure(
+    const StructurePattern& pattern, const cholmod_sparse& Jt) const {
+  if (pattern.num_rows != Jt.nrow || pattern.num_cols != Jt.ncol ||
+      pattern.marg_start_index != margStartIndex_ ||
+      pattern.conditioned != use_diagonal_conditioner_ ||
+      pattern.col_ptrs.size() != Jt.ncol + 1)
+    return false;
+  const std::ptrdiff_t* p = static_cast<const std::ptrdiff_t*>(Jt.p);
+  const std::ptrdiff_t* i = static_cast<const std::ptrdiff_t*>(Jt.i);
+  // equal column pointers imply the same number of non-zeros
+  return std::equal(p, p + Jt.ncol + 1, pattern.col_ptrs.begin()) &&
+      std::equal(i, i + p[Jt.ncol], pattern.row_indices.begin());
+}
+
+void AslamTruncatedSvdSolver::switchSymbolicFactorization() {
   cholmod_sparse Jt_CS;
-  Jt.getView(&Jt_CS);
-  truncated_svd_solver::SelfFreeingCholmodPtr<cholmod_sparse> J_CS(
-      cholmod_l_transpose(&Jt_CS, 1, &cholmod_), cholmod_);
+  jacobian_builder_->J_transpose().getView(&Jt_CS);
+  if (factor_ != nullptr && matchesStructure(structure_, Jt_CS)) {
+    ++num_symbolic_cache_hits_;
+    return;
+  }
+  if (factor_ != nullptr) {
+    if (symbolic_cache_capacity_ > 0) {
+      symbolic_cache_.push_back(CachedFactorization());
+      symbolic_cache_.back().pattern = std::move(structure_);
+      symbolic_cache_.back().factor = factor_;
+      symbolic_cache_.back().memory_usage = factor_memory_usage_;
+    }
+    else
+      SuiteSparseQR_free<double>(&factor_, &cholmod_);
+    factor_ = nullptr;
+    factor_memory_usage_ = 0;
+  }
+  for (auto it = symbolic_cache_.begin(); it != symbolic_cache_.end(); ++it)
+    if (matchesStructure(it->pattern, Jt_CS)) {
+      structure_ = std::move(it->pattern);
+      factor_ = it->factor;
+      factor_memory_usage_ = it->memory_usage;
+      symbolic_cache_.erase(it);
+      ++num_symbolic_cache_hits_;
+      break;
+    }
+  trimSymbolicCache();
+  if (factor_ == nullptr)
+    assignStructure(Jt_CS, &structure_);
+}
+
+void AslamTruncatedSvdSolver::assignStructure(const cholmod_sparse& Jt,
+    StructurePattern* pattern) const {
+  const std::ptrdiff_t* p = static_cast<const std::ptrdiff_t*>(Jt.p);
+  const std::ptrdiff_t* i = static_cast<const std::ptrdiff_t*>(Jt.i);
+  pattern->num_rows = Jt.nrow;
+  pattern->num_cols = Jt.ncol;
+  pattern->marg_start_index = margStartIndex_;
+  pattern->conditioned = use_diagonal_conditioner_;
+  pattern->col_ptrs.assign(p, p + Jt.ncol + 1);
+  pattern->row_indices.assign(i, i + p[Jt.ncol]);
+}
+
+void AslamTruncatedSvdSolver::trimSymbolicCache() {
+  while (symbolic_cache_.size() > symbolic_cache_capacity_) {
+    SuiteSparseQR_free<double>(&symbolic_cache_.front().factor, &cholmod_);
+    symbolic_cache_.erase(symbolic_cache_.begin());
+  }
+}
+
+bool AslamTruncatedSvdSolver::analyzeMarginal() {
+  const auto start = std::chrono::steady_clock::now();
+  cholmod_sparse* J_CS = updateJacobian(false);
   if (J_CS == nullptr) {
     return false;
   }
-  truncated_svd_solver::TruncatedSvdSolver::analyzeMarginal(
-      J_CS, margStartIndex_);
+  const std::ptrdiff_t m = J_CS->nrow;
+  const std::ptrdiff_t n = J_CS->ncol;
+  const std::ptrdiff_t j = margStartIndex_;
+  const std::ptrdiff_t nt = n - j;
+
+  // reduced R of the marginalized columns, the rows of Q^T J_theta below the
+  // rank of the QR factorization of the nuisance columns J_psi
+  Eigen::MatrixXd reduced;
+  if (j > 0) {
+    std::vector<SuiteSparse_long> cols(n);
+    for (std::ptrdiff_t col = 0; col < n; ++col)
+      cols[col] = col;
+    cholmod_sparse* J_psi = cholmod_l_submatrix(J_CS, nullptr, -1,
+        cols.data(), j, 1, 1, &cholmod_);
+    cholmod_sparse* J_theta = cholmod_l_submatrix(J_CS, nullptr, -1,
+        cols.data() + j, nt, 1, 1, &cholmod_);
+    if (J_psi == nullptr || J_theta == nullptr) {
+      cholmod_l_free_sparse(&J_psi, &cholmod_);
+      cholmod_l_free_sparse(&J_theta, &cholmod_);
+      return false;
+    }
+    const std::ptrdiff_t* p = static_cast<const std::ptrdiff_t*>(J_psi->p);
+    const double* x = static_cast<const double*>(J_psi->x);
+    double maxNorm = 0.0;
+    for (std::ptrdiff_t col = 0; col < j; ++col)
+      maxNorm = std::max(maxNorm, Eigen::Map<const Eigen::VectorXd>(x + p[col],
+          p[col + 1] - p[col]).norm());
+    qrTolerance_ = tsvd_options_.qrTol != -1.0 ? tsvd_options_.qrTol :
+        20.0 * (m + j) * tsvd_options_.epsQR * maxNorm;
+    // the factorization of the solves is kept for their own structure, this
+    // one only lives for the analysis
+    SuiteSparseQR_factorization<double>* factor =
+        SuiteSparseQR_factorize<double>(SPQR_ORDERING_BEST, qrTolerance_,
+        J_psi, &cholmod_);
+    cholmod_sparse* QtJ_theta = factor != nullptr ?
+        SuiteSparseQR_qmult<double>(SPQR_QTX, factor, J_theta, &cholmod_) :
+        nullptr;
+    cholmod_l_free_sparse(&J_psi, &cholmod_);
+    cholmod_l_free_sparse(&J_theta, &cholmod_);
+    if (QtJ_theta == nullptr) {
+      SuiteSparseQR_free<double>(&factor, &cholmod_);
+      return false;
+    }
+    qrRank_ = factor->rank;
+    qrRankDeficiency_ = j - qrRank_;
+    SuiteSparseQR_free<double>(&factor, &cholmod_);
+    reduced = Eigen::MatrixXd::Zero(m - qrRank_, nt);
+    const std::ptrdiff_t* qp = static_cast<const std::ptrdiff_t*>(
+        QtJ_theta->p);
+    const std::ptrdiff_t* qi = static_cast<const std::ptrdiff_t*>(
+        QtJ_theta->i);
+    const double* qx = static_cast<const double*>(QtJ_theta->x);
+    for (std::ptrdiff_t col = 0; col < nt; ++col)
+      for (std::ptrdiff_t idx = qp[col]; idx < qp[col + 1]; ++idx)
+        if (qi[idx] >= qrRank_)
+          reduced(qi[idx] - qrRank_, col) = qx[idx];
+    cholmod_l_free_sparse(&QtJ_theta, &cholmod_);
+  }
+  else {
+    qrRank_ = 0;
+    qrRankDeficiency_ = 0;
+    qrTolerance_ = -1.0;
+    reduced = Eigen::MatrixXd::Zero(m, n);
+    const std::ptrdiff_t* p = static_cast<const std::ptrdiff_t*>(J_CS->p);
+    const std::ptrdiff_t* i = static_cast<const std::ptrdiff_t*>(J_CS->i);
+    const double* x = static_cast<const double*>(J_CS->x);
+    for (std::ptrdiff_t col = 0; col < n; ++col)
+      for (std::ptrdiff_t idx = p[col]; idx < p[col + 1]; ++idx)
+        reduced(i[idx], col) = x[idx];
+  }
+
+  // truncated SVD of the reduced R on the configured backend, the singular
+  // values are padded to the number of marginalized columns
+  MarginalSvd svd;
+  computeMarginalSvd(reduced, marginal_svd_backend_, true, &svd);
+  singularValues_ = Eigen::VectorXd::Zero(nt);
+  singularValues_.head(svd.singular_values.size()) = svd.singular_values;
+  matrixU_ = std::move(svd.U);
+  matrixV_ = std::move(svd.V);
+  svdTolerance_ = tsvd_options_.svdTol != -1.0 ? tsvd_options_.svdTol :
+      nt > 0 ? std::max<std::ptrdiff_t>(reduced.rows(), nt) *
+      singularValues_(0) * tsvd_options_.epsSVD : 0.0;
+  svdRank_ = 0;
+  while (svdRank_ < nt && singularValues_(svdRank_) > svdTolerance_)
+    ++svdRank_;
+  svdRankDeficiency_ = nt - svdRank_;
+  svGap_ = svdRank_ > 0 && svdRank_ < nt ?
+      singularValues_(svdRank_ - 1) / singularValues_(svdRank_) :
+      std::numeric_limits<double>::infinity();
+  marginalAnalysisTime_ = secondsSince(start);
+  timings_.analyze_marginal += secondsSince(start);
+  ++timings_.num_analyze_marginal;
   return true;
 }
 
+cholmod_sparse* AslamTruncatedSvdSolver::updateJacobian(bool conditioned) {
+  aslam::backend::CompressedColumnMatrix<std::ptrdiff_t>& Jt =
+      jacobian_builder_->J_transpose();
+  cholmod_sparse Jt_CS;
+  Jt.getView(&Jt_CS);
+  // keep the buffer across iterations and batches, the values are always
+  // refreshed since the solver scales the columns in place
+  const size_t numConditionerRows = conditioned ? Jt_CS.nrow : 0;
+  const size_t nnz = cholmod_l_nnz(&Jt_CS, &cholmod_) + numConditionerRows;
+  if (jacobian_ == nullptr || jacobian_->ncol != Jt_CS.nrow ||
+      jacobian_->nzmax < nnz) {
+    if (jacobian_ != nullptr)
+      cholmod_l_free_sparse(&jacobian_, &cholmod_);
+    jacobian_ = cholmod_l_allocate_sparse(Jt_CS.ncol, Jt_CS.nrow, nnz, 1, 1,
+        0, CHOLMOD_REAL, &cholmod_);
+    if (jacobian_ == nullptr)
+      return nullptr;
+  }
+  jacobian_->nrow = Jt_CS.ncol;
+  if (!cholmod_l_transpose_unsym(&Jt_CS, 1, nullptr, nullptr, 0, jacobian_,
+      &cholmod_))
+    return nullptr;
+  if (!conditioned)
+    return jacobian_;
+
+  // append the rows of diag(conditioner) in place, from the last column on
+  // so that no entry is overwritten before it moved
+  if (_diagonalConditioner.size() != static_cast<std::ptrdiff_t>(Jt_CS.nrow))
+    return nullptr;
+  std::ptrdiff_t* p = static_cast<std::ptrdiff_t*>(jacobian_->p);
+  std::ptrdiff_t* i = static_cast<std::ptrdiff_t*>(jacobian_->i);
+  double* x = static_cast<double*>(jacobian_->x);
+  const std::ptrdiff_t m = Jt_CS.ncol;
+  for (std::ptrdiff_t col = Jt_CS.nrow - 1; col >= 0; --col) {
+    const std::ptrdiff_t begin = p[col];
+    const std::ptrdiff_t end = p[col + 1];
+    std::move_backward(i + begin, i + end, i + end + col);
+    std::move_backward(x + begin, x + end, x + end + col);
+    i[end + col] = m + col;
+    x[end + col] = _diagonalConditioner(col);
+    p[col + 1] = end + col + 1;
+  }
+  jacobian_->nrow = m + Jt_CS.nrow;
+  return jacobian_;
+}
+
 const aslam::backend::CompressedColumnMatrix<std::ptrdiff_t>&
   AslamTruncatedSvdSolver::getJacobianTranspose() const {
-  return jacobian_builder_.J_transpose();
+  return jacobian_builder_->J_transpose();
+}
+
+void AslamTruncatedSvdSolver::stashJacobianTranspose() {
+  // swap the whole builders, its error terms and design variables follow the
+  // matrix and nothing is copied
+  if (!stashed_jacobian_builder_)
+    stashed_jacobian_builder_.reset(new JacobianBuilder());
+  std::swap(jacobian_builder_, stashed_jacobian_builder_);
+  stashed_marg_start_index_ = margStartIndex_;
+  has_stashed_jacobian_transpose_ = true;
+}
+
+bool AslamTruncatedSvdSolver::restoreJacobianTranspose() {
+  if (!has_stashed_jacobian_transpose_)
+    return false;
+  std::swap(jacobian_builder_, stashed_jacobian_builder_);
+  margStartIndex_ = stashed_marg_start_index_;
+  switchSymbolicFactorization();
+  // the swapped out builder references the rejected error terms
+  clearStashedJacobianTranspose();
+  return true;
+}
+
+void AslamTruncatedSvdSolver::clearStashedJacobianTranspose() {
+  stashed_jacobian_builder_.reset();
+  has_stashed_jacobian_transpose_ = false;
+}
+
+bool AslamTruncatedSvdSolver::hasStashedJacobianTranspose() const {
+  return has_stashed_jacobian_transpose_;
+}
+
+const AslamTruncatedSvdSolver::Timings&
+    AslamTruncatedSvdSolver::getTimings() const {
+  return timings_;
+}
+
+size_t AslamTruncatedSvdSolver::getSymbolicCacheCapacity() const {
+  return symbolic_cache_capacity_;
+}
+
+void AslamTruncatedSvdSolver::setSymbolicCacheCapacity(size_t capacity) {
+  symbolic_cache_capacity_ = capacity;
+  trimSymbolicCache();
+}
+
+void AslamTruncatedSvdSolver::solveFactorized(cholmod_sparse* J,
+    cholmod_dense* e, Eigen::VectorXd& dx) {
+  // the memory retained by solve() is held by the factorization
+  const size_t memory_inuse = cholmod_.memory_inuse;
+  solve(J, e, margStartIndex_, dx);
+  factor_memory_usage_ = factor_ == nullptr ? 0 : std::max<size_t>(
+      factor_memory_usage_ + cholmod_.memory_inuse, memory_inuse) -
+      memory_inuse;
+}
+
+bool AslamTruncatedSvdSolver::analyzeScaledSystem() {
+  // solveSystem() already left the analysis of the scaled system, unless it
+  // describes the damped system [J; D]
+  if (!last_solve_conditioned_)
+    return true;
+  last_solve_conditioned_ = false;
+
+  // solve the undamped J on its own factorization, the damped one goes to
+  // the symbolic cache and comes back for the next solve
+  use_diagonal_conditioner_ = false;
+  switchSymbolicFactorization();
+  cholmod_sparse* J_CS = updateJacobian(false);
+  if (J_CS != nullptr) {
+    cholmod_dense e_CD;
+    truncated_svd_solver::eigenDenseToCholmodDenseView(_e, &e_CD);
+    Eigen::VectorXd dx;
+    solveFactorized(J_CS, &e_CD, dx);
+  }
+  use_diagonal_conditioner_ = true;
+  switchSymbolicFactorization();
+  return J_CS != nullptr;
+}
+
+Eigen::VectorXd AslamTruncatedSvdSolver::getCovarianceDiagonal() const {
+  // Sigma = V_r S_r^-2 V_r^T, only the scaled row space is formed
+  const std::ptrdiff_t rank = getSVDRank();
+  const Eigen::MatrixXd factor = getMatrixV().leftCols(rank) *
+      getSingularValues().head(rank).cwiseInverse().asDiagonal();
+  return factor.rowwise().squaredNorm();
+}
+
+Eigen::MatrixXd AslamTruncatedSvdSolver::getCovarianceBlock(
+    std::ptrdiff_t start, std::ptrdiff_t size) const {
+  const Eigen::MatrixXd& V = getMatrixV();
+  CHECK(start >= 0 && size >= 0 && start + size <= V.rows())
+      << "covariance block out of bounds";
+  const std::ptrdiff_t rank = getSVDRank();
+  const Eigen::MatrixXd factor = V.block(start, 0, size, rank) *
+      getSingularValues().head(rank).cwiseInverse().asDiagonal();
+  return factor * factor.transpose();
+}
+
+MarginalSvdBackend AslamTruncatedSvdSolver::getMarginalSvdBackend() const {
+  return marginal_svd_backend_;
+}
+
+void AslamTruncatedSvdSolver::setMarginalSvdBackend(
+    MarginalSvdBackend backend) {
+  marginal_svd_backend_ = backend;
+}
+
+size_t AslamTruncatedSvdSolver::getNumSymbolicCacheHits() const {
+  return num_symbolic_cache_hits_;
+}
+
+void AslamTruncatedSvdSolver::clearSymbolicCache() {
+  for (auto it = symbolic_cache_.begin(); it != symbolic_cache_.end(); ++it)
+    SuiteSparseQR_free<double>(&it->factor, &cholmod_);
+  symbolic_cache_.clear();
+}
+
+size_t AslamTruncatedSvdSolver::getSymbolicCacheMemoryUsage() const {
+  size_t memory_usage = 0;
+  for (auto it = symbolic_cache_.cbegin(); it != symbolic_cache_.cend(); ++it)
+    memory_usage += it->memory_usage;
+  return memory_usage;
+}
+
+size_t AslamTruncatedSvdSolver::getMemoryUsage() const {
+  // the cached factorizations would otherwise drive the eviction of batches
+  const size_t memory_usage = TruncatedSvdSolver::getMemoryUsage();
+  const size_t cache_memory_usage = getSymbolicCacheMemoryUsage();
+  return memory_usage > cache_memory_usage ?
+      memory_usage - cache_memory_usage : 0;
+}
+
+void AslamTruncatedSvdSolver::resetTimings() {
+  timings_.build_system = 0.0;
+  timings_.solve_system = 0.0;
+  timings_.analyze_marginal = 0.0;
+  timings_.num_build_system = 0;
+  timings_.num_solve_system = 0;
+  timings_.num_analyze_marginal = 0;
 }
 
 }  // namespace backend
@@ -0,0 +1,157 @@
+#include "aslam-tsvd-solver/marginal-svd.h"
+
+#include <algorithm>
+#include <stdexcept>
+
+#include <Eigen/Dense>
+#include <Eigen/SVD>
+#include <glog/logging.h>
+
+namespace aslam {
+namespace backend {
+
+namespace {
+
+/// Two-sided Jacobi SVD, also the fallback of the other backends
+void jacobiSvd(const Eigen::MatrixXd& A, bool compute_u, MarginalSvd* svd) {
+  const Eigen::JacobiSVD<Eigen::MatrixXd> jacobi(A, Eigen::ComputeFullV |
+      (compute_u ? Eigen::ComputeThinU : 0));
+  svd->singular_values = jacobi.singularValues();
+  svd->V = jacobi.matrixV();
+  if (compute_u)
+    svd->U = jacobi.matrixU();
+}
+
+/// Reduces A to its N x N triangular factor and runs the SVD on the stack
+template <int N>
+void fixedSizeSvd(const Eigen::MatrixXd& A, bool compute_u,
+    MarginalSvd* svd) {
+  typedef Eigen::Matrix<double, N, N> Square;
+  const Eigen::HouseholderQR<Eigen::MatrixXd> qr(A);
+  const Square R = qr.matrixQR().template topRows<N>().template
+      triangularView<Eigen::Upper>();
+  const Eigen::JacobiSVD<Square> jacobi(R, Eigen::ComputeFullV |
+      (compute_u ? Eigen::ComputeFullU : 0));
+  svd->singular_values = jacobi.singularValues();
+  svd->V = jacobi.matrixV();
+  if (compute_u) {
+    svd->U = Eigen::MatrixXd::Zero(A.rows(), N);
+    svd->U.topRows(N) = jacobi.matrixU();
+    svd->U.applyOnTheLeft(qr.householderQ());
+  }
+}
+
+/// Dispatches the fixed-size SVD on the number of columns
+void fixedSizeSvd(const Eigen::MatrixXd& A, bool compute_u,
+    MarginalSvd* svd) {
+  // wide systems are left to the dynamic backend
+  if (A.rows() < A.cols()) {
+    jacobiSvd(A, compute_u, svd);
+    return;
+  }
+  switch (A.cols()) {
+    case 1: fixedSizeSvd<1>(A, compute_u, svd); break;
+    case 2: fixedSizeSvd<2>(A, compute_u, svd); break;
+    case 3: fixedSizeSvd<3>(A, compute_u, svd); break;
+    case 4: fixedSizeSvd<4>(A, compute_u, svd); break;
+    case 5: fixedSizeSvd<5>(A, compute_u, svd); break;
+    case 6: fixedSizeSvd<6>(A, compute_u, svd); break;
+    default: jacobiSvd(A, compute_u, svd); break;
+  }
+}
+
+/// Divide-and-conquer SVD
+void divideAndConquerSvd(const Eigen::MatrixXd& A, bool compute_u,
+    MarginalSvd* svd) {
+#if EIGEN_VERSION_AT_LEAST(3, 3, 0)
+  const Eigen::BDCSVD<Eigen::MatrixXd> bdc(A, Eigen::ComputeFullV |
+      (compute_u ? Eigen::ComputeThinU : 0));
+  svd->singular_values = bdc.singularValues();
+  svd->V = bdc.matrixV();
+  if (compute_u)
+    svd->U = bdc.matrixU();
+#else
+  jacobiSvd(A, compute_u, svd);
+#endif
+}
+
+/// Eigendecomposition of A^T A, the singular values below sqrt(eps) times
+/// the largest one are not resolved
+void normalEquationsSvd(const Eigen::MatrixXd& A, bool compute_u,
+    MarginalSvd* svd) {
+  const Eigen::SelfAdjointEigenSolver<Eigen::MatrixXd> es(
+      A.transpose() * A);
+  const std::ptrdiff_t n = A.cols();
+  const std::ptrdiff_t k = std::min<std::ptrdiff_t>(A.rows(), n);
+  svd->singular_values = es.eigenvalues().reverse().head(k).cwiseMax(0.0).
+      cwiseSqrt();
+  svd->V = es.eigenvectors().rowwise().reverse();
+  if (compute_u) {
+    svd->U = A * svd->V.leftCols(k);
+    for (std::ptrdiff_t i = 0; i < k; ++i)
+      if (svd->singular_values(i) > 0.0)
+        svd->U.col(i) /= svd->singular_values(i);
+      else
+        svd->U.col(i).setZero();
+  }
+}
+
+}  // namespace
+
+MarginalSvdBackend selectMarginalSvdBackend(std::ptrdiff_t cols) {
+  if (cols <= kMaxFixedSizeMarginalSvd)
+    return MarginalSvdBackend::kFixedSize;
+  else if (cols <= kMaxJacobiMarginalSvd)
+    return MarginalSvdBackend::kJacobi;
+  else
+    return MarginalSvdBackend::kDivideAndConquer;
+}
+
+MarginalSvdBackend marginalSvdBackendFromString(const std::string& name) {
+  if (name == "auto")
+    return MarginalSvdBackend::kAuto;
+  else if (name == "fixed")
+    return MarginalSvdBackend::kFixedSize;
+  else if (name == "jacobi")
+    return MarginalSvdBackend::kJacobi;
+  else if (name == "bdc")
+    return MarginalSvdBackend::kDivideAndConquer;
+  else if (name == "normal")
+    return MarginalSvdBackend::kNormalEquations;
+  throw std::invalid_argument("Unknown marginal SVD backend: " + name);
+}
+
+std::string marginalSvdBackendToString(MarginalSvdBackend backend) {
+  switch (backend) {
+    case MarginalSvdBackend::kAuto: return "auto";
+    case MarginalSvdBackend::kFixedSize: return "fixed";
+    case MarginalSvdBackend::kJacobi: return "jacobi";
+    case MarginalSvdBackend::kDivideAndConquer: return "bdc";
+    case MarginalSvdBackend::kNormalEquations: return "normal";
+  }
+  return "auto";
+}
+
+void computeMarginalSvd(const Eigen::MatrixXd& A, MarginalSvdBackend backend,
+    bool compute_u, MarginalSvd* svd) {
+  CHECK_NOTNULL(svd);
+  if (backend == MarginalSvdBackend::kAuto)
+    backend = selectMarginalSvdBackend(A.cols());
+  switch (backend) {
+    case MarginalSvdBackend::kFixedSize:
+      fixedSizeSvd(A, compute_u, svd);
+      break;
+    case MarginalSvdBackend::kDivideAndConquer:
+      divideAndConquerSvd(A, compute_u, svd);
+      break;
+    case MarginalSvdBackend::kNormalEquations:
+      normalEquationsSvd(A, compute_u, svd);
+      break;
+    default:
+      jacobiSvd(A, compute_u, svd);
+      break;
+  }
+}
+
+}  // namespace backend
+}  // namespace aslam
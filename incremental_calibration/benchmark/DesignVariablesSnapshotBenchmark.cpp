@@ -0,0 +1,87 @@
+/******************************************************************************
+ * Copyright (C) 2013 by Jerome Maye                                          *
+ * jerome.maye@gmail.com                                                      *
+ ******************************************************************************/
+
+/** \file DesignVariablesSnapshotBenchmark.cpp
+    \brief This file benchmarks the DesignVariablesSnapshot class against a
+           map-based saving/restoring of the design variables.
+  */
+
+#include <cstdlib>
+#include <iostream>
+#include <unordered_map>
+#include <vector>
+
+#include <boost/shared_ptr.hpp>
+#include <boost/make_shared.hpp>
+
+#include <Eigen/Core>
+
+#include "aslam/calibration/core/DesignVariablesSnapshot.h"
+#include "aslam/calibration/data-structures/VectorDesignVariable.h"
+#include "aslam/calibration/base/Timestamp.h"
+
+using namespace aslam::calibration;
+
+/// Spline coefficient design variable type
+typedef VectorDesignVariable<4> Coefficient;
+
+int main(int argc, char** argv) {
+  if (argc > 3) {
+    std::cerr << "Usage: " << argv[0] << " [num_coefficients] [num_runs]"
+      << std::endl;
+    return -1;
+  }
+  const size_t numCoefficients = argc > 1 ? std::atol(argv[1]) : 1000000;
+  const size_t numRuns = argc > 2 ? std::atol(argv[2]) : 10;
+
+  // coefficients are grouped by 4 as in a cubic spline segment
+  std::vector<boost::shared_ptr<Coefficient> > coefficients;
+  DesignVariablesSnapshot::DesignVariablesP designVariables;
+  const size_t numDV = numCoefficients / 4;
+  coefficients.reserve(numDV);
+  designVariables.reserve(numDV);
+  for (size_t i = 0; i < numDV; ++i) {
+    coefficients.push_back(boost::make_shared<Coefficient>(
+      Coefficient::Container::Constant(i)));
+    designVariables.push_back(coefficients.back().get());
+  }
+  std::cout << "design variables: " << numDV << ", coefficients: "
+    << 4 * numDV << ", runs: " << numRuns << std::endl;
+
+  // map-based backup
+  std::unordered_map<aslam::backend::DesignVariable*, Eigen::MatrixXd> backup;
+  double mapSave = 0;
+  double mapRestore = 0;
+  for (size_t run = 0; run < numRuns; ++run) {
+    double timeStart = Timestamp::now();
+    for (auto it = designVariables.cbegin(); it != designVariables.cend();
+        ++it)
+      (*it)->getParameters(backup[*it]);
+    mapSave += Timestamp::now() - timeStart;
+    timeStart = Timestamp::now();
+    for (auto it = backup.cbegin(); it != backup.cend(); ++it)
+      it->first->setParameters(it->second);
+    mapRestore += Timestamp::now() - timeStart;
+  }
+
+  // contiguous snapshot
+  DesignVariablesSnapshot snapshot;
+  double snapshotSave = 0;
+  double snapshotRestore = 0;
+  for (size_t run = 0; run < numRuns; ++run) {
+    double timeStart = Timestamp::now();
+    snapshot.save(designVariables);
+    snapshotSave += Timestamp::now() - timeStart;
+    timeStart = Timestamp::now();
+    snapshot.restore();
+    snapshotRestore += Timestamp::now() - timeStart;
+  }
+
+  std::cout << "map: save " << mapSave / numRuns << " [s], restore "
+    << mapRestore / numRuns << " [s]" << std::endl;
+  std::cout << "snapshot: save " << snapshotSave / numRuns << " [s], restore "
+    << snapshotRestore / numRuns << " [s]" << std::endl;
+  return 0;
+}
@@ -0,0 +1,133 @@
+/******************************************************************************
+ * Copyright (C) 2013 by Jerome Maye                                          *
+ * jerome.maye@gmail.com                                                      *
+ ******************************************************************************/
+
+/** \file IncrementalOptimizationProblemBenchmark.cpp
+    \brief This file benchmarks the error terms indexing of the
+           IncrementalOptimizationProblem class.
+  */
+
+#include <cstdlib>
+#include <iostream>
+#include <vector>
+
+#include <boost/shared_ptr.hpp>
+#include <boost/make_shared.hpp>
+
+#include <aslam/backend/ErrorTerm.hpp>
+#include <aslam/backend/JacobianContainer.hpp>
+
+#include "aslam/calibration/core/IncrementalOptimizationProblem.h"
+#include "aslam/calibration/core/OptimizationProblem.h"
+#include "aslam/calibration/data-structures/VectorDesignVariable.h"
+#include "aslam/calibration/base/Timestamp.h"
+
+class DummyErrorTerm :
+  public aslam::backend::ErrorTermFs<3> {
+public:
+  DummyErrorTerm() = default;
+  DummyErrorTerm(const DummyErrorTerm& other) = delete;
+  DummyErrorTerm& operator = (const DummyErrorTerm& other) = delete;
+  virtual ~DummyErrorTerm() {};
+protected:
+  virtual double evaluateErrorImplementation() {
+    return 0;
+  };
+  virtual void evaluateJacobiansImplementation(
+    aslam::backend::JacobianContainer& J) {};
+};
+
+using namespace aslam::calibration;
+
+/// Reference lookup walking all the batches, as done before the offsets index
+const aslam::backend::ErrorTerm* linearErrorTerm(const
+    IncrementalOptimizationProblem::OptimizationProblemsSP& batches,
+    size_t idx) {
+  size_t idxRunning = 0;
+  for (auto it = batches.cbegin(); it != batches.cend(); ++it) {
+    const size_t batchSize = (*it)->numErrorTerms();
+    if ((idxRunning + batchSize) > idx)
+      return (*it)->errorTerm(idx - idxRunning);
+    idxRunning += batchSize;
+  }
+  return nullptr;
+}
+
+/// Reference error terms count summing over all the batches
+size_t linearNumErrorTerms(const
+    IncrementalOptimizationProblem::OptimizationProblemsSP& batches) {
+  size_t numErrorTerms = 0;
+  for (auto it = batches.cbegin(); it != batches.cend(); ++it)
+    numErrorTerms += (*it)->numErrorTerms();
+  return numErrorTerms;
+}
+
+int main(int argc, char** argv) {
+  if (argc > 3) {
+    std::cerr << "Usage: " << argv[0] << " [num_batches] [num_error_terms]"
+      << std::endl;
+    return -1;
+  }
+  const size_t numBatches = argc > 1 ? std::atol(argv[1]) : 10000;
+  const size_t numErrorTerms = argc > 2 ? std::atol(argv[2]) : 10;
+
+  // build the incremental problem, all batches share a calibration variable
+  IncrementalOptimizationProblem incProblem;
+  auto theta = boost::make_shared<VectorDesignVariable<3> >();
+  theta->setActive(true);
+  double timeStart = Timestamp::now();
+  for (size_t i = 0; i < numBatches; ++i) {
+    auto batch = boost::make_shared<OptimizationProblem>();
+    auto x = boost::make_shared<VectorDesignVariable<3> >();
+    x->setActive(true);
+    batch->addDesignVariable(x, 0);
+    batch->addDesignVariable(theta, 1);
+    for (size_t j = 0; j < numErrorTerms; ++j)
+      batch->addErrorTerm(boost::make_shared<DummyErrorTerm>());
+    incProblem.add(batch);
+  }
+  std::cout << "batches: " << numBatches << ", error terms: "
+    << incProblem.numErrorTerms() << std::endl;
+  std::cout << "add: " << Timestamp::now() - timeStart << " [s]" << std::endl;
+
+  // sweep over all error terms with the offsets index
+  const size_t numET = incProblem.numErrorTerms();
+  size_t checksum = 0;
+  timeStart = Timestamp::now();
+  for (size_t i = 0; i < numET; ++i)
+    checksum += incProblem.errorTerm(i) != nullptr;
+  const double indexedSweep = Timestamp::now() - timeStart;
+
+  // sweep over all error terms walking the batches
+  const auto batches = incProblem.getOptimizationProblems();
+  timeStart = Timestamp::now();
+  for (size_t i = 0; i < numET; ++i)
+    checksum += linearErrorTerm(batches, i) != nullptr;
+  const double linearSweep = Timestamp::now() - timeStart;
+
+  // repeated error terms counts
+  timeStart = Timestamp::now();
+  for (size_t i = 0; i < numBatches; ++i)
+    checksum += incProblem.numErrorTerms();
+  const double indexedCount = Timestamp::now() - timeStart;
+  timeStart = Timestamp::now();
+  for (size_t i = 0; i < numBatches; ++i)
+    checksum += linearNumErrorTerms(batches);
+  const double linearCount = Timestamp::now() - timeStart;
+
+  // evict the oldest batches one by one
+  timeStart = Timestamp::now();
+  for (size_t i = 0; i + 1 < numBatches; ++i)
+    incProblem.remove(0);
+  const double removeOldest = Timestamp::now() - timeStart;
+
+  std::cout << "errorTerm() sweep: indexed " << indexedSweep << " [s], linear "
+    << linearSweep << " [s]" << std::endl;
+  std::cout << "numErrorTerms() x " << numBatches << ": indexed "
+    << indexedCount << " [s], linear " << linearCount << " [s]" << std::endl;
+  std::cout << "remove(0) x " << numBatches - 1 << ": " << removeOldest
+    << " [s], " << incProblem.getNumRemovalSteps() << " steps" << std::endl;
+  std::cout << "checksum: " << checksum << std::endl;
+  return 0;
+}
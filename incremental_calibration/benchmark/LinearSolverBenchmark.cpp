@@ -0,0 +1,228 @@
+/******************************************************************************
+ * Copyright (C) 2013 by Jerome Maye                                          *
+ * jerome.maye@gmail.com                                                      *
+ ******************************************************************************/
+
+/** \file LinearSolverBenchmark.cpp
+    \brief This file benchmarks the phases of AslamTruncatedSvdSolver on
+           synthetic block-sparse calibration problems.
+  */
+
+#include <algorithm>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <limits>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include <boost/shared_ptr.hpp>
+#include <boost/make_shared.hpp>
+
+#include <Eigen/Core>
+
+#include <aslam/backend/ErrorTerm.hpp>
+#include <aslam/backend/JacobianContainer.hpp>
+#include <aslam/backend/Optimizer2Options.hpp>
+#include <aslam/backend/Optimizer2.hpp>
+#include <aslam/backend/GaussNewtonTrustRegionPolicy.hpp>
+
+#include <aslam-tsvd-solver/aslam-tsvd-solver.h>
+
+#include "aslam/calibration/core/OptimizationProblem.h"
+#include "aslam/calibration/data-structures/VectorDesignVariable.h"
+#include "aslam/calibration/base/Timestamp.h"
+
+using namespace aslam::calibration;
+using namespace aslam::backend;
+
+/// Linear solver type
+typedef AslamTruncatedSvdSolver LinearSolver;
+/// Nuisance design variable type
+typedef VectorDesignVariable<3> Nuisance;
+/// Calibration design variable type
+typedef VectorDesignVariable<Eigen::Dynamic> Calibration;
+
+/** The class LinearErrorTerm measures y = A psi + B theta for a nuisance
+    variable psi of a batch and the calibration parameters theta.
+  */
+class LinearErrorTerm :
+  public aslam::backend::ErrorTermFs<3> {
+public:
+  /// Constructor
+  LinearErrorTerm(Nuisance* psi, Calibration* theta, const Eigen::Matrix3d& A,
+      const Eigen::MatrixXd& B, const Eigen::Vector3d& y) :
+      _psi(psi),
+      _theta(theta),
+      _A(A),
+      _B(B),
+      _y(y) {
+    setInvR(Eigen::Matrix3d::Identity());
+    setDesignVariables(psi, theta);
+  }
+
+protected:
+  /// Evaluate the error term and return the weighted squared error
+  virtual double evaluateErrorImplementation() {
+    setError(_y - _A * _psi->getValue() - _B * _theta->getValue());
+    return evaluateChiSquaredError();
+  }
+  /// Evaluate the Jacobians
+  virtual void evaluateJacobiansImplementation(
+      aslam::backend::JacobianContainer& jacobians) {
+    jacobians.add(_psi, -_A);
+    jacobians.add(_theta, -_B);
+  }
+
+  /// Nuisance variable
+  Nuisance* _psi;
+  /// Calibration parameters
+  Calibration* _theta;
+  /// Jacobian of the nuisance variable
+  Eigen::Matrix3d _A;
+  /// Jacobian of the calibration parameters
+  Eigen::MatrixXd _B;
+  /// Measurement
+  Eigen::Vector3d _y;
+};
+
+/// Minimum, mean, and maximum of a phase over the runs
+struct PhaseStatistics {
+  /// Constructor
+  PhaseStatistics() :
+      min(std::numeric_limits<double>::infinity()),
+      mean(0.0),
+      max(0.0) {
+  }
+  /// Adds a run
+  void add(double time, size_t numRuns) {
+    min = std::min(min, time);
+    max = std::max(max, time);
+    mean += time / numRuns;
+  }
+  /// Writes the statistics as a JSON object
+  std::string toJson() const {
+    std::stringstream stream;
+    stream << "{\"min\":" << min << ",\"mean\":" << mean << ",\"max\":"
+      << max << "}";
+    return stream.str();
+  }
+  /// Minimum [s]
+  double min;
+  /// Mean [s]
+  double mean;
+  /// Maximum [s]
+  double max;
+};
+
+int main(int argc, char** argv) {
+  if (argc > 7) {
+    std::cerr << "Usage: " << argv[0] << " [num_batches] [nuisance_per_batch]"
+      " [theta_dim] [rank_deficiency] [num_runs] [output_file]" << std::endl;
+    return -1;
+  }
+  const size_t numBatches = argc > 1 ? std::atol(argv[1]) : 100;
+  const size_t nuisancePerBatch = argc > 2 ? std::atol(argv[2]) : 50;
+  const size_t thetaDim = argc > 3 ? std::atol(argv[3]) : 10;
+  const size_t rankDeficiency = std::min(thetaDim / 2,
+    argc > 4 ? static_cast<size_t>(std::atol(argv[4])) : 1);
+  const size_t numRuns = argc > 5 ? std::atol(argv[5]) : 5;
+  const std::string outputFile = argc > 6 ? argv[6] : "";
+
+  // the batches share theta only, the last columns of theta copy the first
+  // ones to leave rankDeficiency unobservable directions
+  auto problem = boost::make_shared<OptimizationProblem>();
+  auto theta = boost::make_shared<Calibration>(
+    Calibration::Container::Zero(thetaDim));
+  theta->setActive(true);
+  problem->addDesignVariable(theta, 1);
+  std::vector<boost::shared_ptr<Nuisance> > nuisances;
+  nuisances.reserve(numBatches * nuisancePerBatch);
+  const size_t numMeasurements = 2;
+  for (size_t b = 0; b < numBatches; ++b)
+    for (size_t k = 0; k < nuisancePerBatch; ++k) {
+      nuisances.push_back(boost::make_shared<Nuisance>());
+      nuisances.back()->setActive(true);
+      problem->addDesignVariable(nuisances.back(), 0);
+      for (size_t m = 0; m < numMeasurements; ++m) {
+        Eigen::MatrixXd B = Eigen::MatrixXd::Random(3, thetaDim);
+        B.rightCols(rankDeficiency) = B.leftCols(rankDeficiency);
+        problem->addErrorTerm(boost::make_shared<LinearErrorTerm>(
+          nuisances.back().get(), theta.get(), Eigen::Matrix3d::Random(), B,
+          Eigen::Vector3d::Random()));
+      }
+    }
+  problem->setGroupsOrdering({0, 1});
+
+  // the problem is linear, a single Gauss-Newton step solves it
+  auto linearSolver = boost::make_shared<LinearSolver>();
+  Optimizer2Options options;
+  options.maxIterations = 1;
+  options.verbose = false;
+  options.linearSystemSolver = linearSolver;
+  options.trustRegionPolicy =
+    boost::make_shared<GaussNewtonTrustRegionPolicy>();
+  Optimizer2 optimizer(options);
+  optimizer.setProblem(problem);
+  linearSolver->setMargStartIndex(problem->getGroupDim(0));
+
+  PhaseStatistics buildSystem;
+  PhaseStatistics solveSystem;
+  PhaseStatistics analyzeMarginal;
+  size_t solvePeakMemoryUsage = 0;
+  size_t analyzePeakMemoryUsage = 0;
+  double solveNumFlops = 0.0;
+  double analyzeNumFlops = 0.0;
+  for (size_t run = 0; run < numRuns; ++run) {
+    theta->setValue(Calibration::Container::Zero(thetaDim));
+    for (auto it = nuisances.begin(); it != nuisances.end(); ++it)
+      (*it)->setValue(Nuisance::Container::Zero());
+    linearSolver->resetTimings();
+    optimizer.optimize();
+    const LinearSolver::Timings& timings = linearSolver->getTimings();
+    buildSystem.add(timings.build_system /
+      std::max<size_t>(timings.num_build_system, 1), numRuns);
+    solveSystem.add(timings.solve_system /
+      std::max<size_t>(timings.num_solve_system, 1), numRuns);
+    solvePeakMemoryUsage = std::max(solvePeakMemoryUsage,
+      linearSolver->getPeakMemoryUsage());
+    solveNumFlops = linearSolver->getNumFlops();
+    const double timeStart = Timestamp::now();
+    linearSolver->analyzeMarginal();
+    analyzeMarginal.add(Timestamp::now() - timeStart, numRuns);
+    analyzePeakMemoryUsage = std::max(analyzePeakMemoryUsage,
+      linearSolver->getPeakMemoryUsage());
+    analyzeNumFlops = linearSolver->getNumFlops();
+  }
+
+  std::stringstream json;
+  json << "{\"numBatches\":" << numBatches
+    << ",\"nuisancePerBatch\":" << nuisancePerBatch
+    << ",\"thetaDim\":" << thetaDim
+    << ",\"rankDeficiency\":" << rankDeficiency
+    << ",\"numRuns\":" << numRuns
+    << ",\"rows\":" << 3 * numMeasurements * nuisances.size()
+    << ",\"cols\":" << problem->getTotalDim()
+    << ",\"svdRank\":" << linearSolver->getSVDRank()
+    << ",\"qrRank\":" << linearSolver->getQRRank()
+    << ",\"buildSystem\":" << buildSystem.toJson()
+    << ",\"solveSystem\":" << solveSystem.toJson()
+    << ",\"analyzeMarginal\":" << analyzeMarginal.toJson()
+    << ",\"solvePeakMemoryUsage\":" << solvePeakMemoryUsage
+    << ",\"analyzePeakMemoryUsage\":" << analyzePeakMemoryUsage
+    << ",\"solveNumFlops\":" << solveNumFlops
+    << ",\"analyzeNumFlops\":" << analyzeNumFlops << "}";
+  std::cout << json.str() << std::endl;
+
+  // one JSON object per line, so that runs accumulate in the same file
+  if (!outputFile.empty()) {
+    std::ofstream stream(outputFile.c_str(), std::ios::app);
+    if (!stream.is_open()) {
+      std::cerr << "Cannot open " << outputFile << std::endl;
+      return -1;
+    }
+    stream << json.str() << std::endl;
+  }
+  return 0;
+}
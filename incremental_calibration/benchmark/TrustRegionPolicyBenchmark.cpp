@@ -0,0 +1,205 @@
+/******************************************************************************
+ * Copyright (C) 2013 by Jerome Maye                                          *
+ * jerome.maye@gmail.com                                                      *
+ ******************************************************************************/
+
+/** \file TrustRegionPolicyBenchmark.cpp
+    \brief This file benchmarks the trust-region policies of Optimizer2 with
+           AslamTruncatedSvdSolver on a badly initialized time-delay problem.
+  */
+
+#include <cmath>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <boost/shared_ptr.hpp>
+#include <boost/make_shared.hpp>
+
+#include <Eigen/Core>
+
+#include <aslam/backend/ErrorTerm.hpp>
+#include <aslam/backend/Optimizer2Options.hpp>
+#include <aslam/backend/Optimizer2.hpp>
+#include <aslam/backend/GaussNewtonTrustRegionPolicy.hpp>
+#include <aslam/backend/LevenbergMarquardtTrustRegionPolicy.hpp>
+#include <aslam/backend/DogLegTrustRegionPolicy.hpp>
+
+#include <aslam-tsvd-solver/aslam-tsvd-solver.h>
+
+#include "aslam/calibration/core/OptimizationProblem.h"
+#include "aslam/calibration/data-structures/VectorDesignVariable.h"
+#include "aslam/calibration/statistics/NormalDistribution.h"
+#include "aslam/calibration/base/Timestamp.h"
+
+using namespace aslam::calibration;
+using namespace aslam::backend;
+
+/// Reference signal seen by the sensor with a time delay
+double signal(double t) {
+  return std::sin(t) + 0.5 * std::sin(2.3 * t);
+}
+
+/// Derivative of the reference signal
+double signalDerivative(double t) {
+  return std::cos(t) + 1.15 * std::cos(2.3 * t);
+}
+
+/** The class ErrorTermTimeDelay measures y = a s(t - d) + b, with the scale
+    and time delay (a, d) as calibration parameters and the offset b as a
+    nuisance parameter of the segment.
+  */
+class ErrorTermTimeDelay :
+  public aslam::backend::ErrorTermFs<1> {
+public:
+  /// Constructor
+  ErrorTermTimeDelay(VectorDesignVariable<2>* theta,
+      VectorDesignVariable<1>* offset, double t, double y, double sigma2) :
+      _theta(theta),
+      _offset(offset),
+      _t(t),
+      _y(y) {
+    setInvR(Eigen::Matrix<double, 1, 1>::Constant(1.0 / sigma2));
+    setDesignVariables(theta, offset);
+  }
+
+protected:
+  /// Evaluate the error term and return the weighted squared error
+  virtual double evaluateErrorImplementation() {
+    const double a = _theta->getValue()(0);
+    const double d = _theta->getValue()(1);
+    error_t error;
+    error(0) = _y - (a * signal(_t - d) + _offset->getValue()(0));
+    setError(error);
+    return evaluateChiSquaredError();
+  }
+  /// Evaluate the Jacobians
+  virtual void evaluateJacobiansImplementation(
+      aslam::backend::JacobianContainer& jacobians) {
+    const double a = _theta->getValue()(0);
+    const double d = _theta->getValue()(1);
+    Eigen::Matrix<double, 1, 2> Htheta;
+    Htheta(0, 0) = -signal(_t - d);
+    Htheta(0, 1) = a * signalDerivative(_t - d);
+    jacobians.add(_theta, Htheta);
+    jacobians.add(_offset, -Eigen::Matrix<double, 1, 1>::Identity());
+  }
+
+  /// Calibration parameters (a, d)
+  VectorDesignVariable<2>* _theta;
+  /// Offset of the segment
+  VectorDesignVariable<1>* _offset;
+  /// Measurement time
+  double _t;
+  /// Measurement
+  double _y;
+};
+
+/// Result of a policy run
+struct Result {
+  /// Number of iterations
+  size_t iterations;
+  /// Final cost
+  double JFinal;
+  /// Wall time [s]
+  double time;
+  /// Estimated calibration parameters
+  Eigen::Vector2d theta;
+};
+
+/// Builds the problem from scratch and optimizes it with the given policy
+Result run(const boost::shared_ptr<TrustRegionPolicy>& policy,
+    const std::vector<std::vector<double> >& times,
+    const std::vector<std::vector<double> >& measurements,
+    const Eigen::Vector2d& thetaHat, double sigma2) {
+  auto problem = boost::make_shared<OptimizationProblem>();
+  auto theta = boost::make_shared<VectorDesignVariable<2> >(thetaHat);
+  theta->setActive(true);
+  problem->addDesignVariable(theta, 1);
+  std::vector<boost::shared_ptr<VectorDesignVariable<1> > > offsets;
+  offsets.reserve(times.size());
+  for (size_t s = 0; s < times.size(); ++s) {
+    offsets.push_back(boost::make_shared<VectorDesignVariable<1> >(
+      Eigen::Matrix<double, 1, 1>::Zero()));
+    offsets.back()->setActive(true);
+    problem->addDesignVariable(offsets.back(), 0);
+    for (size_t k = 0; k < times[s].size(); ++k)
+      problem->addErrorTerm(boost::make_shared<ErrorTermTimeDelay>(
+        theta.get(), offsets.back().get(), times[s][k], measurements[s][k],
+        sigma2));
+  }
+  problem->setGroupsOrdering({0, 1});
+
+  Optimizer2Options options;
+  options.maxIterations = 100;
+  options.convergenceDeltaJ = 1e-9;
+  options.convergenceDeltaX = 1e-9;
+  options.verbose = false;
+  options.linearSystemSolver = boost::make_shared<AslamTruncatedSvdSolver>();
+  options.trustRegionPolicy = policy;
+  Optimizer2 optimizer(options);
+  optimizer.setProblem(problem);
+  optimizer.getSolver<AslamTruncatedSvdSolver>()->setMargStartIndex(
+    problem->getGroupDim(0));
+
+  Result result;
+  const double timeStart = Timestamp::now();
+  const SolutionReturnValue srv = optimizer.optimize();
+  result.time = Timestamp::now() - timeStart;
+  result.iterations = srv.iterations;
+  result.JFinal = srv.JFinal;
+  result.theta = theta->getValue();
+  return result;
+}
+
+int main(int argc, char** argv) {
+  if (argc > 4) {
+    std::cerr << "Usage: " << argv[0]
+      << " [num_segments] [segment_size] [initial_delay]" << std::endl;
+    return -1;
+  }
+  const size_t numSegments = argc > 1 ? std::atol(argv[1]) : 100;
+  const size_t segmentSize = argc > 2 ? std::atol(argv[2]) : 100;
+  const double initialDelay = argc > 3 ? std::atof(argv[3]) : 1.0;
+
+  // simulate the segments, each with its own offset
+  const Eigen::Vector2d theta(1.5, 0.1);
+  const double sigma2 = 1e-4;
+  const double T = 0.01;
+  std::vector<std::vector<double> > times(numSegments);
+  std::vector<std::vector<double> > measurements(numSegments);
+  for (size_t s = 0; s < numSegments; ++s) {
+    const double offset = NormalDistribution<1>(0.0, 1.0).getSample();
+    times[s].reserve(segmentSize);
+    measurements[s].reserve(segmentSize);
+    for (size_t k = 0; k < segmentSize; ++k) {
+      const double t = (s * segmentSize + k) * T;
+      times[s].push_back(t);
+      measurements[s].push_back(theta(0) * signal(t - theta(1)) + offset +
+        NormalDistribution<1>(0.0, sigma2).getSample());
+    }
+  }
+  const Eigen::Vector2d thetaHat(1.0, initialDelay);
+  std::cout << "segments: " << numSegments << ", segment size: "
+    << segmentSize << ", true: " << theta.transpose() << ", guess: "
+    << thetaHat.transpose() << std::endl;
+
+  std::vector<std::pair<std::string, boost::shared_ptr<TrustRegionPolicy> > >
+    policies;
+  policies.push_back(std::make_pair("gauss-newton",
+    boost::make_shared<GaussNewtonTrustRegionPolicy>()));
+  policies.push_back(std::make_pair("levenberg-marquardt",
+    boost::make_shared<LevenbergMarquardtTrustRegionPolicy>()));
+  policies.push_back(std::make_pair("dog-leg",
+    boost::make_shared<DogLegTrustRegionPolicy>()));
+  for (auto it = policies.cbegin(); it != policies.cend(); ++it) {
+    const Result result = run(it->second, times, measurements, thetaHat,
+      sigma2);
+    std::cout << it->first << ": iterations " << result.iterations
+      << ", JFinal " << result.JFinal << ", time " << result.time
+      << " [s], estimate " << result.theta.transpose() << std::endl;
+  }
+  return 0;
+}
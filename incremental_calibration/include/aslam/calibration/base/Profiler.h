@@ -0,0 +1,217 @@
+/******************************************************************************
+ * Copyright (C) 2013 by Jerome Maye                                          *
+ * jerome.maye@gmail.com                                                      *
+ ******************************************************************************/
+
+/** \file Profiler.h
+    \brief This file defines the Profiler class, which collects per-phase
+           timings on a monotonic clock.
+  */
+
+#ifndef ASLAM_CALIBRATION_BASE_PROFILER_H
+#define ASLAM_CALIBRATION_BASE_PROFILER_H
+
+#include <cstddef>
+
+#include <deque>
+#include <map>
+#include <mutex>
+#include <string>
+#include <vector>
+
+/// Declares a scoped phase or runs a statement when profiling is compiled in
+#ifdef ASLAM_CALIBRATION_PROFILING
+#define ASLAM_CALIBRATION_PROFILE(statement) statement
+#define ASLAM_CALIBRATION_PROFILE_CONCAT_IMPL(a, b) a##b
+#define ASLAM_CALIBRATION_PROFILE_CONCAT(a, b) \
+  ASLAM_CALIBRATION_PROFILE_CONCAT_IMPL(a, b)
+#define ASLAM_CALIBRATION_PROFILE_PHASE(profiler, name) \
+  aslam::calibration::Profiler::ScopedPhase \
+  ASLAM_CALIBRATION_PROFILE_CONCAT(scopedPhase, __LINE__)(profiler, name)
+#else
+#define ASLAM_CALIBRATION_PROFILE(statement)
+#define ASLAM_CALIBRATION_PROFILE_PHASE(profiler, name)
+#endif
+
+namespace aslam {
+  namespace calibration {
+
+    /** The class Profiler collects the durations of named phases. It keeps
+        a rolling window of durations per phase for histograms and a bounded
+        list of events that can be exported as a Chrome trace.
+        \brief Per-phase profiler
+      */
+    class Profiler {
+    public:
+      /** \name Types definitions
+        @{
+        */
+      /// Timed occurrence of a phase
+      struct Event {
+        /// Phase name
+        std::string phase;
+        /// Start time on the monotonic clock [s]
+        double start;
+        /// Duration [s]
+        double duration;
+      };
+      /// Histogram of durations
+      struct Histogram {
+        /// Bin edges [s], one more than the counts
+        std::vector<double> edges;
+        /// Number of durations per bin
+        std::vector<size_t> counts;
+      };
+      /// Statistics of a phase
+      struct PhaseStatistics {
+        /// Number of occurrences
+        size_t count;
+        /// Total duration [s]
+        double total;
+        /// Minimum duration [s]
+        double min;
+        /// Maximum duration [s]
+        double max;
+        /// Mean duration over the rolling window [s]
+        double windowMean;
+        /// Histogram over the rolling window
+        Histogram histogram;
+      };
+      /// Durations of the phases of one batch [s]
+      typedef std::map<std::string, double> PhaseTimes;
+      /// Records a phase over its scope
+      class ScopedPhase {
+      public:
+        /// Starts the phase
+        ScopedPhase(Profiler& profiler, const char* phase);
+        /// Copy constructor
+        ScopedPhase(const ScopedPhase& other) = delete;
+        /// Copy assignment operator
+        ScopedPhase& operator = (const ScopedPhase& other) = delete;
+        /// Ends the phase
+        ~ScopedPhase();
+      private:
+        /// Profiler receiving the phase
+        Profiler& _profiler;
+        /// Phase name
+        const char* _phase;
+        /// Start time [s]
+        double _start;
+      };
+      /// Collects the phase times of a batch over its scope
+      class ScopedBatch {
+      public:
+        /// Starts the batch
+        ScopedBatch(Profiler& profiler);
+        /// Copy constructor
+        ScopedBatch(const ScopedBatch& other) = delete;
+        /// Copy assignment operator
+        ScopedBatch& operator = (const ScopedBatch& other) = delete;
+        /// Ends the batch if end() was not called
+        ~ScopedBatch();
+        /// Ends the batch and returns its phase times
+        PhaseTimes end();
+      private:
+        /// Profiler collecting the batch
+        Profiler& _profiler;
+        /// True once the batch has ended
+        bool _ended;
+      };
+      /** @}
+        */
+
+      /** \name Constructors/destructor
+        @{
+        */
+      /// Constructs profiler with window size and maximum number of events
+      Profiler(size_t windowSize = 1000, size_t maxNumEvents = 100000);
+      /// Copy constructor
+      Profiler(const Profiler& other) = delete;
+      /// Copy assignment operator
+      Profiler& operator = (const Profiler& other) = delete;
+      /// Move constructor
+      Profiler(Profiler&& other) = delete;
+      /// Move assignment operator
+      Profiler& operator = (Profiler&& other) = delete;
+      /// Destructor
+      virtual ~Profiler();
+      /** @}
+        */
+
+      /** \name Methods
+        @{
+        */
+      /// Returns the time on the monotonic clock [s]
+      static double now();
+      /// Records a phase
+      void record(const std::string& phase, double start, double duration);
+      /// Starts collecting the phase times of a new batch, batches nest and
+      /// the phases of an inner batch also count in the outer ones
+      void beginBatch();
+      /// Ends the innermost batch and returns its phase times
+      PhaseTimes endBatch();
+      /// Writes the events in the Chrome trace event format
+      void writeChromeTrace(const std::string& filename) const;
+      /// Forgets all the recorded phases
+      void clear();
+      /** @}
+        */
+
+      /** \name Accessors
+        @{
+        */
+      /// Returns the names of the recorded phases
+      std::vector<std::string> getPhases() const;
+      /// Returns the statistics of a phase
+      PhaseStatistics getPhaseStatistics(const std::string& phase) const;
+      /// Returns the recorded events
+      std::vector<Event> getEvents() const;
+      /// Returns the size of the rolling window
+      size_t getWindowSize() const;
+      /** @}
+        */
+
+    protected:
+      /** \name Protected types
+        @{
+        */
+      /// Accumulated durations of a phase
+      struct Phase {
+        /// Number of occurrences
+        size_t count;
+        /// Total duration [s]
+        double total;
+        /// Minimum duration [s]
+        double min;
+        /// Maximum duration [s]
+        double max;
+        /// Rolling window of durations [s]
+        std::deque<double> window;
+      };
+      /** @}
+        */
+
+      /** \name Protected members
+        @{
+        */
+      /// Size of the rolling window
+      size_t _windowSize;
+      /// Maximum number of kept events
+      size_t _maxNumEvents;
+      /// Accumulated durations per phase
+      std::map<std::string, Phase> _phases;
+      /// Recorded events, oldest first
+      std::deque<Event> _events;
+      /// Phase times of the open batches, innermost last
+      std::vector<PhaseTimes> _batchesPhaseTimes;
+      /// Mutex protecting the records
+      mutable std::mutex _mutex;
+      /** @}
+        */
+
+    };
+
+  }
+}
+
+#endif // ASLAM_CALIBRATION_BASE_PROFILER_H
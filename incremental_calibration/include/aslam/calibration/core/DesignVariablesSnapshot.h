@@ -0,0 +1,135 @@
+/******************************************************************************
+ * Copyright (C) 2013 by Jerome Maye                                          *
+ * jerome.maye@gmail.com                                                      *
+ ******************************************************************************/
+
+/** \file DesignVariablesSnapshot.h
+    \brief This file defines the DesignVariablesSnapshot class, which saves
+           and restores the parameters of design variables.
+  */
+
+#ifndef ASLAM_CALIBRATION_CORE_DESIGN_VARIABLES_SNAPSHOT_H
+#define ASLAM_CALIBRATION_CORE_DESIGN_VARIABLES_SNAPSHOT_H
+
+#include <cstddef>
+#include <vector>
+
+#include <Eigen/Core>
+
+namespace aslam {
+  namespace backend {
+
+    class DesignVariable;
+
+  }
+  namespace calibration {
+
+    /** The class DesignVariablesSnapshot saves and restores the parameters of
+        design variables. The parameters are packed into a single contiguous
+        buffer with an offset table. The memory is kept across snapshots, such
+        that saving and restoring the same variables does not allocate. Since
+        the design variables take their parameters as a dense matrix, a
+        scratch matrix is kept per parameters shape and filled through a map
+        of the buffer.
+        \brief Design variables snapshot
+      */
+    class DesignVariablesSnapshot {
+    public:
+      /** \name Types definitions
+        @{
+        */
+      /// Design variable type
+      typedef aslam::backend::DesignVariable DesignVariable;
+      /// Container for design variables (pointer)
+      typedef std::vector<DesignVariable*> DesignVariablesP;
+      /// Snapshot entry of a design variable
+      struct Entry {
+        /// Design variable (null if forgotten)
+        DesignVariable* designVariable;
+        /// Offset of the parameters in the buffer
+        size_t offset;
+        /// Number of rows of the parameters
+        Eigen::MatrixXd::Index rows;
+        /// Number of columns of the parameters
+        Eigen::MatrixXd::Index cols;
+        /// Index of the scratch matrix of this shape
+        size_t transferIdx;
+      };
+      /// Container for snapshot entries
+      typedef std::vector<Entry> Entries;
+      /// Self type
+      typedef DesignVariablesSnapshot Self;
+      /** @}
+        */
+
+      /** \name Constructors/destructor
+        @{
+        */
+      /// Default constructor
+      DesignVariablesSnapshot();
+      /// Copy constructor
+      DesignVariablesSnapshot(const Self& other) = delete;
+      /// Copy assignment operator
+      DesignVariablesSnapshot& operator = (const Self& other) = delete;
+      /// Move constructor
+      DesignVariablesSnapshot(Self&& other) = delete;
+      /// Move assignment operator
+      DesignVariablesSnapshot& operator = (Self&& other) = delete;
+      /// Destructor
+      virtual ~DesignVariablesSnapshot();
+      /** @}
+        */
+
+      /** \name Methods
+        @{
+        */
+      /// Saves the parameters of the design variables
+      void save(const DesignVariablesP& designVariables);
+      /// Appends the parameters of a design variable, returns its index
+      size_t add(DesignVariable* designVariable);
+      /// Forgets a design variable, it will not be restored
+      void forget(size_t idx);
+      /// Restores the parameters of the design variables
+      void restore();
+      /// Clears the snapshot, memory is kept for the next one
+      void clear();
+      /** @}
+        */
+
+      /** \name Accessors
+        @{
+        */
+      /// Returns the snapshot entries
+      const Entries& getEntries() const;
+      /// Returns the number of design variables in the snapshot
+      size_t getNumDesignVariables() const;
+      /// Returns the number of saved parameters
+      size_t getNumParameters() const;
+      /// Returns the saved parameters
+      const std::vector<double>& getParameters() const;
+      /** @}
+        */
+
+    protected:
+      /** \name Protected members
+        @{
+        */
+      /// Snapshot entries
+      Entries _entries;
+      /// Contiguous buffer for the parameters
+      std::vector<double> _parameters;
+      /// Temporary for reading parameters
+      Eigen::MatrixXd _transfer;
+      /// Scratch matrices for restoring parameters, one per shape
+      std::vector<Eigen::MatrixXd> _transfers;
+      /// Index of the last scratch matrix used in add()
+      size_t _lastTransferIdx;
+      /** @}
+        */
+
+    };
+
+  }
+}
+
+#endif // ASLAM_CALIBRATION_CORE_DESIGN_VARIABLES_SNAPSHOT_H
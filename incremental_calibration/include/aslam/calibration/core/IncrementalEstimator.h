@@ -12,25 +12,40 @@
 #define ASLAM_CALIBRATION_CORE_INCREMENTAL_ESTIMATOR_H
 
 #include <cstddef>
+#include <cstdint>
 
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <future>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <aslam-tsvd-solver/aslam-block-tsvd-solver.h>
 #include <aslam-tsvd-solver/aslam-tsvd-solver.h>
 #include <aslam/backend/Optimizer2Options.hpp>
 #include <boost/shared_ptr.hpp>
 #include <Eigen/Core>
 
+#include "aslam/calibration/base/Profiler.h"
+
 namespace sm {
   class PropertyTree;
 }
 
 namespace aslam {
   namespace backend {
-    class GaussNewtonTrustRegionPolicy;
+    class DesignVariable;
+    class TrustRegionPolicy;
     class Optimizer2;
     template<typename I> class CompressedColumnMatrix;
   }
 
   namespace calibration {
     typedef aslam::backend::AslamTruncatedSvdSolver LinearSolver;
+    typedef aslam::backend::AslamBlockTruncatedSvdSolver BlockLinearSolver;
     typedef aslam::backend::AslamTruncatedSvdSolver::Options
         LinearSolverOptions;
     class OptimizationProblem;
@@ -55,24 +70,128 @@ namespace aslam {
       /// Self type
       typedef IncrementalEstimator Self;
       /// Trust region type
-      typedef aslam::backend::GaussNewtonTrustRegionPolicy TrustRegionPolicy;
+      typedef aslam::backend::TrustRegionPolicy TrustRegionPolicy;
+      /// Trust region type (shared pointer)
+      typedef boost::shared_ptr<TrustRegionPolicy> TrustRegionPolicySP;
       /// Optimizer type
       typedef aslam::backend::Optimizer2 Optimizer;
       /// Optimizer options type
       typedef aslam::backend::Optimizer2Options OptimizerOptions;
       /// Optimizer type (shared_ptr)
       typedef boost::shared_ptr<Optimizer> OptimizerSP;
+      /// Immutable shared matrix
+      typedef boost::shared_ptr<const Eigen::MatrixXd> MatrixSP;
+      /// Immutable shared vector
+      typedef boost::shared_ptr<const Eigen::VectorXd> VectorSP;
+      /// Quantities of the marginal system reported by the estimator
+      enum Output {
+        /// Basis for the unobservable subspace
+        OutputNobsBasis = 1 << 0,
+        /// Basis for the observable subspace
+        OutputObsBasis = 1 << 1,
+        /// Covariance of theta
+        OutputSigma2Theta = 1 << 2,
+        /// Covariance of theta_obs
+        OutputSigma2ThetaObs = 1 << 3,
+        /// Singular values
+        OutputSingularValues = 1 << 4,
+        /// Scaled counterparts of the requested quantities, with block
+        /// elimination they cost a sparse solve after every optimization
+        OutputScaled = 1 << 5,
+        /// All the quantities
+        OutputAll = (1 << 6) - 1
+      };
+      /// Back-pressure policy when the batch queue is full
+      enum class QueuePolicy {
+        /// Block the submitter until the queue has room
+        Block,
+        /// Drop the oldest queued batch
+        DropOldest,
+        /// Drop the submitted batch
+        DropNewest
+      };
+      /// Trust region policy of the optimizer
+      enum class TrustRegion {
+        /// Gauss-Newton steps, the gradient is not computed
+        GaussNewton,
+        /// Levenberg-Marquardt damping
+        LevenbergMarquardt,
+        /// Powell's dog leg
+        DogLeg
+      };
+      /// Selection among competing candidate batches
+      enum class CandidateSelection {
+        /// Test the candidates in turn by decreasing approximate information
+        /// gain, until one of them is accepted
+        MostInformative,
+        /// Test all the candidates with a positive gain together, each of
+        /// them receives the joint return value of this single test
+        Combined
+      };
       /// Options for the incremental estimator
       struct Options {
         Options() :
             infoGainDelta(0.2),
             checkValidity(false),
+            saveActiveOnly(true),
+            preScreen(false),
+            preScreenMargin(0.1),
+            maxNumBatches(0),
+            maxMemoryUsage(0),
+            queueCapacity(16),
+            queuePolicy(QueuePolicy::Block),
+            trustRegion(TrustRegion::GaussNewton),
+            numCandidateThreads(0),
+            blockElimination(false),
+            numSolverThreads(0),
+            incrementalMarginal(false),
+            refactorizationPeriod(5),
+            outputs(OutputAll),
             verbose(false) {
         }
         /// Information gain delta
         double infoGainDelta;
         /// Check validity of the solution
         bool checkValidity;
+        /// Only save the design variables the optimizer updates (active ones)
+        bool saveActiveOnly;
+        /// Reject batches on their approximate information gain first
+        bool preScreen;
+        /// Safety margin added to the approximate information gain
+        double preScreenMargin;
+        /// Maximum number of batches kept in the problem (0: unbounded),
+        /// requires OutputObsBasis and OutputSingularValues
+        size_t maxNumBatches;
+        /// Linear solver memory budget in bytes (0: unbounded), requires
+        /// OutputObsBasis and OutputSingularValues
+        size_t maxMemoryUsage;
+        /// Capacity of the queue of submitted batches (0: unbounded)
+        size_t queueCapacity;
+        /// Back-pressure policy when the batch queue is full
+        QueuePolicy queuePolicy;
+        /// Trust region policy of the optimizer
+        TrustRegion trustRegion;
+        /// Threads evaluating candidate batches (0: hardware concurrency)
+        size_t numCandidateThreads;
+        /// Eliminate the nuisance variables batch by batch in parallel, leave
+        /// OutputScaled out of the outputs to keep the gain since the scaled
+        /// quantities re-run the sparse solver after every optimization
+        bool blockElimination;
+        /// Threads of the block elimination (0: hardware concurrency)
+        size_t numSolverThreads;
+        /// Update the marginal factor with the reduced rows of a new batch
+        /// instead of analyzing the whole marginal system, which approximates
+        /// it, batches sharing nuisance variables are always analyzed fully;
+        /// the optimization still runs on the whole problem, only the QR and
+        /// SVD of the marginal analysis are saved
+        bool incrementalMarginal;
+        /// Maximum number of incremental updates between two full analyses,
+        /// the approximation error grows with it
+        size_t refactorizationPeriod;
+        /// Mask of the reported quantities, pre-screening, eviction, and
+        /// incremental updates need the observable basis and singular values,
+        /// which are also enough for the covariance diagonal and blocks
+        unsigned int outputs;
         /// Verbosity of the estimator
         bool verbose;
       };
@@ -80,6 +199,20 @@ namespace aslam {
       struct ReturnValue {
         /// True if the batch was accepted
         bool batchAccepted;
+        /// True if the batch was rejected by the pre-screening
+        bool batchScreened;
+        /// True if the batch was dropped from the queue without processing
+        bool batchDropped;
+        /// True if the marginal system was updated incrementally since the
+        /// last full analysis, the old batches then keep their linearization
+        /// point and the ranks of J_psi are summed batch by batch
+        bool marginalApproximate;
+        /// Number of batches evicted to keep the problem within its bounds
+        size_t numEvictedBatches;
+        /// Memory usage before eviction in bytes
+        size_t memoryUsageBeforeEviction;
+        /// Memory usage after eviction in bytes
+        size_t memoryUsageAfterEviction;
         /// Information gain
         double informationGain;
         /// Numerical rank of J_psi
@@ -95,25 +228,25 @@ namespace aslam {
         /// QR tolerance used for this batch
         double qrTolerance;
         /// Orthonormal basis for the unobservable subspace of theta
-        Eigen::MatrixXd nobsBasis;
+        MatrixSP nobsBasis;
         /// Orthonormal basis for the unobservable subspace of scaled theta
-        Eigen::MatrixXd nobsBasisScaled;
+        MatrixSP nobsBasisScaled;
         /// Orthonormal basis for the observable subspace of theta
-        Eigen::MatrixXd obsBasis;
+        MatrixSP obsBasis;
         /// Orthonormal basis for the observable subspace of theta
-        Eigen::MatrixXd obsBasisScaled;
+        MatrixSP obsBasisScaled;
         /// Covariance of theta
-        Eigen::MatrixXd sigma2Theta;
+        MatrixSP sigma2Theta;
         /// Covariance of scaled theta
-        Eigen::MatrixXd sigma2ThetaScaled;
+        MatrixSP sigma2ThetaScaled;
         /// Covariance of theta_obs
-        Eigen::MatrixXd sigma2ThetaObs;
+        MatrixSP sigma2ThetaObs;
         /// Covariance of scaled theta_obs
-        Eigen::MatrixXd sigma2ThetaObsScaled;
+        MatrixSP sigma2ThetaObsScaled;
         /// Singular values of A_theta
-        Eigen::VectorXd singularValues;
+        VectorSP singularValues;
         /// Singular values of scaled A_theta
-        Eigen::VectorXd singularValuesScaled;
+        VectorSP singularValuesScaled;
         /// Number of iterations
         size_t numIterations;
         /// Cost function at start
@@ -122,6 +255,27 @@ namespace aslam {
         double JFinal;
         /// Elapsed time for processing this batch [s]
         double elapsedTime;
+        /// Time spent per phase, filled when profiling is compiled in [s]
+        Profiler::PhaseTimes phaseTimes;
+      };
+      /// Checkpoint format version
+      static const uint32_t checkpointVersion = 2;
+      /// Statistics of the queue of submitted batches
+      struct QueueStatistics {
+        /// Number of submitted batches
+        size_t numSubmitted;
+        /// Number of processed batches
+        size_t numProcessed;
+        /// Number of dropped batches
+        size_t numDropped;
+        /// Current queue depth
+        size_t queueDepth;
+        /// Maximum queue depth reached
+        size_t maxQueueDepth;
+        /// Mean latency from submission to result [s]
+        double meanLatency;
+        /// Maximum latency from submission to result [s]
+        double maxLatency;
       };
       /** @}
         */
@@ -151,14 +305,31 @@ namespace aslam {
       /** \name Methods
         @{
         */
-      /// Adds a measurement batch to the estimator
+      /// Adds a measurement batch, which must not be modified afterwards
       ReturnValue addBatch(const BatchSP& batch, bool force = false);
+      /// Tests competing candidate batches and adds the selected ones, the
+      /// candidates sharing non-calibration design variables are estimated
+      /// sequentially
+      std::vector<ReturnValue> addBatches(const std::vector<BatchSP>& batches,
+        CandidateSelection selection = CandidateSelection::MostInformative);
       /// Removes a measurement batch from the estimator
       void removeBatch(size_t idx);
       /// Removes a measurement batch from the estimator
       void removeBatch(const BatchSP& batch);
       /// Re-runs the optimizer
       ReturnValue reoptimize();
+      /// Queues a measurement batch for the worker thread
+      std::future<ReturnValue> submitBatch(const BatchSP& batch,
+        bool force = false);
+      /// Waits until all the submitted batches have been processed
+      void waitForBatches();
+      /// Saves the calibration and its marginal system to a binary file
+      void saveCheckpoint(const std::string& filename) const;
+      /// Restores a checkpoint on the given calibration design variables,
+      /// which must match the saved ones in order and dimensions
+      void loadCheckpoint(const std::string& filename, const
+        std::vector<boost::shared_ptr<aslam::backend::DesignVariable> >&
+        designVariables);
       /** @}
         */
 
@@ -185,6 +356,14 @@ namespace aslam {
       size_t getMargGroupId() const;
       /// Returns the last information gain
       double getInformationGain() const;
+      /// Returns the number of batches rejected by the pre-screening
+      size_t getNumScreenedBatches() const;
+      /// Returns the statistics of the queue of submitted batches
+      QueueStatistics getQueueStatistics() const;
+      /// Returns the profiler
+      const Profiler& getProfiler() const;
+      /// Returns the profiler
+      Profiler& getProfiler();
       /// Returns the current Jacobian transpose if available
       const aslam::backend::CompressedColumnMatrix<std::ptrdiff_t>&
         getJacobianTranspose() const;
@@ -208,6 +387,14 @@ namespace aslam {
       const Eigen::MatrixXd& getSigma2Theta(bool scaled = false) const;
       /// Returns the covariance of theta_obs
       const Eigen::MatrixXd& getSigma2ThetaObs(bool scaled = false) const;
+      /// Returns the diagonal of the covariance of theta, from the observable
+      /// basis and singular values if the covariance is not reported
+      Eigen::VectorXd getSigma2ThetaDiagonal(bool scaled = false) const;
+      /// Returns the covariance block of theta over [start, start + size),
+      /// from the observable basis and singular values if the covariance is
+      /// not reported
+      Eigen::MatrixXd getSigma2ThetaBlock(size_t start, size_t size,
+        bool scaled = false) const;
       /// Returns the singular values of A_theta
       const Eigen::VectorXd& getSingularValues(bool scaled = false) const;
       /// Returns the peak memory usage in bytes
@@ -239,6 +426,54 @@ namespace aslam {
       void orderMarginalizedDesignVariables();
       /// Restores the linear solver
       void restoreLinearSolver();
+      /// Adds batches, optimizes, and keeps them if they are informative
+      ReturnValue testBatches(const std::vector<BatchSP>& batches, bool force,
+        double timeStart);
+      /// Linearizes a batch and returns its reduced rows on theta
+      bool getBatchFactor(OptimizationProblem* batch, Eigen::MatrixXd& factor,
+        std::ptrdiff_t& rankPsi, std::ptrdiff_t& rankPsiDeficiency) const;
+      /// Linearizes a batch and returns its marginal information on theta
+      bool getBatchInformation(OptimizationProblem* batch,
+        Eigen::MatrixXd& information) const;
+      /// Updates the marginal analysis with the reduced rows of a batch
+      bool updateMarginal(OptimizationProblem* batch, ReturnValue& ret,
+        double& svLog2Sum) const;
+      /// Returns the current marginal information on theta
+      Eigen::MatrixXd getMarginalInformation() const;
+      /// Returns F such that the covariance of theta is F F^T
+      Eigen::MatrixXd getSigma2ThetaFactor(bool scaled) const;
+      /// Returns the log2 sum of the singular values behind an information
+      double getSingularValuesLog2Sum(const Eigen::MatrixXd& information,
+        std::ptrdiff_t& rankTheta) const;
+      /// Approximates the information gain of a batch without optimizing
+      bool estimateInformationGain(const BatchSP& batch,
+        double& informationGain, std::ptrdiff_t& rankTheta) const;
+      /// Throws if the options ask for bounds the outputs cannot enforce
+      void checkOptions() const;
+      /// Returns true if the problem exceeds its number or memory bound
+      bool isBoundExceeded() const;
+      /// Evicts the least informative batches until the bounds are met
+      size_t evictBatches(const std::vector<BatchSP>& batches);
+      /// Computes the requested quantities of the scaled system
+      void computeScaledOutputs(ReturnValue& ret) const;
+      /// Computes the requested quantities of the marginal system
+      void computeOutputs(ReturnValue& ret) const;
+      /// Creates the trust region policy and tells the solver if the policy
+      /// needs the gradient
+      static TrustRegionPolicySP createTrustRegionPolicy(TrustRegion
+        trustRegion, LinearSolver& linearSolver);
+      /// Returns the shared empty matrix of unrequested quantities
+      static const MatrixSP& getEmptyMatrix();
+      /// Returns the shared empty vector of unrequested quantities
+      static const VectorSP& getEmptyVector();
+      /// Returns the return value of a batch rejected without optimizing
+      ReturnValue getRejectedReturnValue() const;
+      /// Returns the return value of a batch dropped from the queue
+      static ReturnValue getDroppedReturnValue();
+      /// Processes the submitted batches in the worker thread
+      void processBatches();
+      /// Records the solver phases run since the given solver timings
+      void recordSolverPhases(const LinearSolver::Timings& timings);
       /** @}
         */
 
@@ -258,25 +493,25 @@ namespace aslam {
       /// Sum of the log2 of the singular values of A_theta (up to rankTheta)
       double _svLog2Sum;
       /// Orthonormal basis for the unobservable subspace of theta
-      Eigen::MatrixXd _nobsBasis;
+      MatrixSP _nobsBasis;
       /// Orthonormal basis for the unobservable subspace of scaled theta
-      Eigen::MatrixXd _nobsBasisScaled;
+      MatrixSP _nobsBasisScaled;
       /// Orthonormal basis for the observable subspace of theta
-      Eigen::MatrixXd _obsBasis;
+      MatrixSP _obsBasis;
       /// Orthonormal basis for the observable subspace of scaled theta
-      Eigen::MatrixXd _obsBasisScaled;
+      MatrixSP _obsBasisScaled;
       /// Covariance of theta
-      Eigen::MatrixXd _sigma2Theta;
+      MatrixSP _sigma2Theta;
       /// Covariance of scaled theta
-      Eigen::MatrixXd _sigma2ThetaScaled;
+      MatrixSP _sigma2ThetaScaled;
       /// Covariance of theta_obs
-      Eigen::MatrixXd _sigma2ThetaObs;
+      MatrixSP _sigma2ThetaObs;
       /// Covariance of scaled theta_obs
-      Eigen::MatrixXd _sigma2ThetaObsScaled;
+      MatrixSP _sigma2ThetaObsScaled;
       /// Singular values of A_theta
-      Eigen::VectorXd _singularValues;
+      VectorSP _singularValues;
       /// Singular values of scaled A_theta
-      Eigen::VectorXd _singularValuesScaled;
+      VectorSP _singularValuesScaled;
       /// Tolerance for SVD
       double _svdTolerance;
       /// Tolerance for QR
@@ -299,6 +534,47 @@ namespace aslam {
       double _initialCost;
       /// Final cost
       double _finalCost;
+      /// Number of batches rejected by the pre-screening
+      size_t _numScreenedBatches;
+      /// Number of incremental updates since the last full analysis
+      size_t _numIncrementalUpdates;
+      /// Submitted batch waiting for the worker thread
+      struct QueuedBatch {
+        /// Batch to add
+        BatchSP batch;
+        /// Force the batch in
+        bool force;
+        /// Submission time on the monotonic clock
+        std::chrono::steady_clock::time_point submitTime;
+        /// Result of the batch
+        std::promise<ReturnValue> result;
+      };
+      /// Queue of submitted batches
+      std::deque<QueuedBatch> _batchQueue;
+      /// Mutex protecting the queue and its statistics
+      mutable std::mutex _queueMutex;
+      /// Signaled when a batch is queued or the worker must stop
+      std::condition_variable _queueNotEmpty;
+      /// Signaled when a batch leaves the queue
+      std::condition_variable _queueNotFull;
+      /// Signaled when the worker has processed a batch
+      std::condition_variable _batchProcessed;
+      /// True while the worker processes a batch
+      bool _processingBatch;
+      /// True when the worker must stop
+      bool _stopWorker;
+      /// Number of submitters blocked on a full queue
+      size_t _numBlockedSubmitters;
+      /// Signaled when a blocked submitter leaves submitBatch()
+      std::condition_variable _submitterReleased;
+      /// Worker thread, started with the first submitted batch
+      std::thread _worker;
+      /// Statistics of the queue
+      QueueStatistics _queueStatistics;
+      /// Sum of the latencies of the processed batches [s]
+      double _totalLatency;
+      /// Profiler of the estimation phases
+      Profiler _profiler;
       /** @}
         */
 
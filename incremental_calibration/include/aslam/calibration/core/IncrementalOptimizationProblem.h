@@ -21,6 +21,9 @@
 
 #include <aslam/backend/OptimizationProblemBase.hpp>
 
+#include "aslam/calibration/core/DesignVariablesSnapshot.h"
+#include "aslam/calibration/data-structures/FenwickTree.h"
+
 namespace aslam {
   namespace backend {
 
@@ -33,7 +36,15 @@ namespace aslam {
     class OptimizationProblem;
 
     /** The class IncrementalOptimizationProblem implements a container for
-        optimization problems.
+        optimization problems. The error terms and design variables of an
+        optimization problem are indexed when it is added: a problem must not
+        gain or lose error terms or design variables while it is stored,
+        remove it and add it again instead. Removed problems and design
+        variables leave tombstones behind that are skipped through binary
+        indexed trees, and a container is compacted once it holds more
+        tombstones than entries. A removal thus only visits the removed
+        problem, in amortized time. The indices are updated by the modifiers,
+        so that the constant accessors can be called concurrently.
         \brief Incremental optimization problem
       */
     class IncrementalOptimizationProblem :
@@ -50,16 +61,46 @@ namespace aslam {
       typedef OptimizationProblemsSP::iterator OptimizationProblemsSPIt;
       /// Optimization problem container constant iteraror (shared pointer)
       typedef OptimizationProblemsSP::const_iterator OptimizationProblemsSPCIt;
+      /// Optimization problem (pointer) to index container
+      typedef std::unordered_map<const OptimizationProblem*, size_t>
+        OptimizationProblemsPIdx;
       /// Design variable type
       typedef aslam::backend::DesignVariable DesignVariable;
+      /// Bookkeeping information of a design variable
+      struct DesignVariableInfo {
+        /// Number of optimization problems referencing the design variable
+        size_t count;
+        /// Group ID of the design variable
+        size_t groupId;
+        /// Slot of the design variable in its group
+        size_t groupIdx;
+        /// Dimension accounted for in the group (0 if inactive)
+        size_t dim;
+        /// Index of the design variable in the snapshot
+        size_t snapshotIdx;
+      };
       /// Design variable (pointer) to count, group ID container
-      typedef std::unordered_map<const DesignVariable*,
-        std::pair<size_t, size_t> > DesignVariablesPCountId;
+      typedef std::unordered_map<const DesignVariable*, DesignVariableInfo>
+        DesignVariablesPCountId;
       /// Container for design variables (pointer)
       typedef std::vector<const DesignVariable*> DesignVariablesP;
       /// Container for design variable groups
       typedef std::unordered_map<size_t, DesignVariablesP>
         DesignVariablePGroups;
+      /// Design variables of a group, removed ones are left as null tombstones
+      struct DesignVariablesGroup {
+        /// Slots of the design variables
+        DesignVariablesP slots;
+        /// Marks the live slots for positional lookups
+        FenwickTree<size_t> live;
+        /// Number of tombstones in the slots
+        size_t numRemoved = 0;
+      };
+      /// Container for design variable groups with tombstones
+      typedef std::unordered_map<size_t, DesignVariablesGroup>
+        DesignVariablesGroupsSlots;
+      /// Container for design variables (pointer) in solver order
+      typedef std::vector<DesignVariable*> OrderedDesignVariablesP;
       /// Error term type
       typedef aslam::backend::ErrorTerm ErrorTerm;
       typedef aslam::backend::ScalarNonSquaredErrorTerm ScalarNonSquaredErrorTerm;
@@ -68,9 +109,11 @@ namespace aslam {
       typedef boost::shared_ptr<ErrorTerm> ErrorTermSP;
       /// Container for error terms (shared pointer)
       typedef std::vector<ErrorTermSP> ErrorTermsSP;
-      /// Container for design variables saving/restoring
-      typedef std::unordered_map<DesignVariable*, Eigen::MatrixXd>
-        DesignVariablesBackup;
+      /// Error term (pointer) to owning optimization problem container
+      typedef std::unordered_map<const ErrorTerm*, const OptimizationProblem*>
+        ErrorTermsPBatch;
+      /// Container for the dimensions of the groups
+      typedef std::unordered_map<size_t, size_t> GroupsDims;
       /// Self type
       typedef IncrementalOptimizationProblem Self;
       /** @}
@@ -97,21 +140,26 @@ namespace aslam {
       /** \name Methods
         @{
         */
-      /// Inserts an optimization problem
+      /// Inserts an optimization problem, frozen until it is removed
       void add(const OptimizationProblemSP& problem);
-      /// Removes an optimization problem
+      /// Removes an optimization problem, preserving the order of the others
       void remove(const OptimizationProblemsSPIt& problemIt);
-      /// Removes an optimization problem
+      /// Removes an optimization problem, preserving the order of the others
       void remove(size_t idx);
-      /// Removes an optimization problem
+      /// Removes an optimization problem, preserving the order of the others
       void remove(const OptimizationProblemSP& problem);
       /// Permutes the design variables in a group
       void permuteDesignVariables(const std::vector<size_t>& permutation,
         size_t groupId);
       /// Permutes the optimization problems
       void permuteOptimizationProblems(const std::vector<size_t>& permutation);
-      /// Saves the state of the design variables
-      void saveDesignVariables();
+      /// Activates or deactivates a design variable and updates dimensions
+      void setDesignVariableActive(DesignVariable* designVariable,
+        bool active);
+      /// Recomputes the groups dimensions after external activation changes
+      void updateGroupsDims();
+      /// Saves the state of the (active) design variables
+      void saveDesignVariables(bool activeOnly = false);
       /// Restores the state of the design variables
       void restoreDesignVariables();
       /// Clears the content of the problem
@@ -125,33 +173,33 @@ namespace aslam {
       /// Returns the number of stored optimization problems
       size_t getNumOptimizationProblems() const;
       /// Returns an optimization problem from an iterator
-      const OptimizationProblem* getOptimizationProblem(const
-        OptimizationProblemsSPCIt& problemIt) const;
-      /// Returns an optimization problem from an iterator
       OptimizationProblem* getOptimizationProblem(const
         OptimizationProblemsSPIt& problemIt);
       /// Returns an optimization problem from an index
       const OptimizationProblem* getOptimizationProblem(size_t idx) const;
       /// Returns an optimization problem from an index
       OptimizationProblem* getOptimizationProblem(size_t idx);
-      /// Returns an iterator to an optimization problem
+      /// Returns an iterator to an optimization problem, compacts first
       OptimizationProblemsSPIt getOptimizationProblem(const
          OptimizationProblemSP& problem);
-      /// Returns the begin iterator for problems
+      /// Returns the begin iterator for problems, compacts first
       OptimizationProblemsSPIt getOptimizationProblemBegin();
-      /// Returns the end iterator for problems
+      /// Returns the end iterator for problems, compacts first
       OptimizationProblemsSPIt getOptimizationProblemEnd();
-      /// Returns the optimization problems
-      const OptimizationProblemsSP& getOptimizationProblems() const;
+      /// Returns the optimization problems, built in O(B)
+      OptimizationProblemsSP getOptimizationProblems() const;
+      /// Checks if an optimization problem is in the problem
+      bool isOptimizationProblemInProblem(const OptimizationProblem* problem)
+        const;
       /// Checks if a design variable is in the problem
       bool isDesignVariableInProblem(const DesignVariable* designVariable)
         const;
       /// Checks if an error term is in the problem
       bool isErrorTermInProblem(const ErrorTerm* errorTerm) const;
-      /// Returns the design variables groups
-      const DesignVariablePGroups& getDesignVariablesGroups() const;
+      /// Returns the design variables groups, built in O(N)
+      DesignVariablePGroups getDesignVariablesGroups() const;
       /// Returns the design variables associated with a group
-      const DesignVariablesP& getDesignVariablesGroup(size_t groupId) const;
+      DesignVariablesP getDesignVariablesGroup(size_t groupId) const;
       /// Returns the error terms of an optimization problem
       const ErrorTermsSP& getErrorTerms(size_t idx) const;
       /// Returns the number of groups
@@ -160,12 +208,18 @@ namespace aslam {
       void setGroupsOrdering(const std::vector<size_t>& groupsOrdering);
       /// Returns the groups ordering
       const std::vector<size_t>& getGroupsOrdering() const;
+      /// Returns the design variables in solver order, built in O(N)
+      OrderedDesignVariablesP getOrderedDesignVariables() const;
       /// Returns the group id of a design variable
       size_t getGroupId(const DesignVariable* designVariable) const;
-      /// Returns the dimension of a group
+      /// Returns the dimension of the active design variables in a group
       size_t getGroupDim(size_t groupId) const;
+      /// Returns the dimension of all the active design variables
+      size_t getTotalDim() const;
       /// Checks if a group is in the problem
       bool isGroupInProblem(size_t groupId) const;
+      /// Returns the number of entries visited by the removals
+      size_t getNumRemovalSteps() const;
       /** @}
         */
 
@@ -191,8 +245,21 @@ namespace aslam {
         std::set<ErrorTerm*>& outErrorSet);
       /// Returns the group id an index falls in
       void getGroupId(size_t idx, size_t& groupId, size_t& idxGroup) const;
-      /// Returns the error term index in a batch from a global index
-      void getErrorIdx(size_t idx, size_t& batchIdx, size_t& idxBatch) const;
+      /// Rebuilds the groups positions and offsets from the groups ordering
+      void updateGroupsOffsets();
+      /// Throws if the dimension of a design variable missed an activation
+      void checkDesignVariableDim(const DesignVariable* designVariable,
+        const DesignVariableInfo& info) const;
+      /// Returns the error term index in a batch slot from a global index
+      void getErrorIdx(size_t idx, size_t& slot, size_t& idxBatch) const;
+      /// Returns the slot of an optimization problem from its index
+      size_t getOptimizationProblemSlot(size_t idx) const;
+      /// Removes the optimization problem stored in a slot
+      void removeSlot(size_t slot);
+      /// Drops the tombstones of the optimization problems
+      void compactOptimizationProblems();
+      /// Drops the tombstones of a design variables group
+      void compactDesignVariablesGroup(DesignVariablesGroup& group);
 
       /// \brief the number of non-squared error terms in this optimization problem
       virtual size_t numNonSquaredErrorTermsImplementation() const{ return 0;}
@@ -210,16 +277,40 @@ namespace aslam {
       /** \name Protected members
         @{
         */
-      /// Optimization problems shared pointers
+      /// Optimization problems shared pointers, null when removed
       OptimizationProblemsSP _optimizationProblems;
+      /// Marks the live optimization problems slots
+      FenwickTree<size_t> _optimizationProblemsLive;
+      /// Number of tombstones in the optimization problems
+      size_t _numRemovedOptimizationProblems;
+      /// Slot of the optimization problems in the container
+      OptimizationProblemsPIdx _optimizationProblemsIdx;
       /// Design variable pointers counts and group ID
       DesignVariablesPCountId _designVariablesCounts;
       /// Storage for the design variables pointers in groups
-      DesignVariablePGroups _designVariables;
+      DesignVariablesGroupsSlots _designVariables;
       /// Groups ordering
       std::vector<size_t> _groupsOrdering;
-      /// Backup for design variables
-      DesignVariablesBackup _designVariablesBackup;
+      /// Dimensions of the active design variables in the groups
+      GroupsDims _groupsDims;
+      /// Dimension of all the active design variables
+      size_t _totalDim;
+      /// Snapshot of the design variables
+      DesignVariablesSnapshot _designVariablesSnapshot;
+      /// Position of the groups in the groups ordering
+      std::unordered_map<size_t, size_t> _groupsPositions;
+      /// Design variables of the groups in the groups ordering
+      std::vector<const DesignVariablesGroup*> _orderedGroups;
+      /// Index of the first design variable of each group in solver order
+      std::vector<size_t> _groupsOffsets;
+      /// Error term pointers to their owning optimization problem
+      ErrorTermsPBatch _errorTermsBatches;
+      /// Number of error terms of the optimization problems slots
+      FenwickTree<size_t> _errorTermsCounts;
+      /// Number of error terms in the problem
+      size_t _numErrorTerms;
+      /// Number of entries visited by the removals
+      size_t _numRemovalSteps;
       /** @}
         */
 
@@ -22,6 +22,8 @@
 
 #include <aslam/backend/OptimizationProblemBase.hpp>
 
+#include "aslam/calibration/core/DesignVariablesSnapshot.h"
+
 namespace aslam {
   namespace backend {
 
@@ -46,8 +48,15 @@ namespace aslam {
       typedef aslam::backend::DesignVariable DesignVariable;
       /// Design variable type (shared pointer)
       typedef boost::shared_ptr<DesignVariable> DesignVariableSP;
+      /// Bookkeeping information of a design variable
+      struct DesignVariableInfo {
+        /// Group ID of the design variable
+        size_t groupId;
+        /// Dimension accounted for in the group (0 if inactive)
+        size_t dim;
+      };
       /// Fast lookup container for design variables pointers
-      typedef std::unordered_map<const DesignVariable*, size_t>
+      typedef std::unordered_map<const DesignVariable*, DesignVariableInfo>
         DesignVariablesP;
       /// Error term type
       typedef aslam::backend::ErrorTerm ErrorTerm;
@@ -60,12 +69,13 @@ namespace aslam {
       typedef std::vector<DesignVariableSP> DesignVariablesSP;
       /// Container for error terms (shared pointer)
       typedef std::vector<ErrorTermSP> ErrorTermsSP;
+      /// Container for design variables (pointer) in solver order
+      typedef std::vector<DesignVariable*> OrderedDesignVariablesP;
       /// Container for design variable groups
       typedef std::unordered_map<size_t, DesignVariablesSP>
         DesignVariableSPGroups;
-      /// Container for design variables saving/restoring
-      typedef std::unordered_map<DesignVariable*, Eigen::MatrixXd>
-        DesignVariablesBackup;
+      /// Container for the dimensions of the groups
+      typedef std::unordered_map<size_t, size_t> GroupsDims;
       /// Self type
       typedef OptimizationProblem Self;
       /** @}
@@ -107,8 +117,13 @@ namespace aslam {
       /// Permutes the design variables in a group
       void permuteDesignVariables(const std::vector<size_t>& permutation,
         size_t groupId);
-      /// Saves the state of the design variables
-      void saveDesignVariables();
+      /// Activates or deactivates a design variable and updates dimensions
+      void setDesignVariableActive(DesignVariable* designVariable,
+        bool active);
+      /// Recomputes the groups dimensions after external activation changes
+      void updateGroupsDims();
+      /// Saves the state of the (active) design variables
+      void saveDesignVariables(bool activeOnly = false);
       /// Restores the state of the design variables
       void restoreDesignVariables();
       /// Clears the optimization problem
@@ -131,10 +146,14 @@ namespace aslam {
       void setGroupsOrdering(const std::vector<size_t>& groupsOrdering);
       /// Returns the groups ordering
       const std::vector<size_t>& getGroupsOrdering() const;
+      /// Returns the design variables in solver order, built in O(N)
+      OrderedDesignVariablesP getOrderedDesignVariables() const;
       /// Returns the group id of a design variable
       size_t getGroupId(const DesignVariable* designVariable) const;
-      /// Returns the dimension of a group
+      /// Returns the dimension of the active design variables in a group
       size_t getGroupDim(size_t groupId) const;
+      /// Returns the dimension of all the active design variables
+      size_t getTotalDim() const;
       /// Checks if a group is in the problem
       bool isGroupInProblem(size_t groupId) const;
       /** @}
@@ -162,6 +181,11 @@ namespace aslam {
         std::set<ErrorTerm*>& outErrorSet);
       /// Returns the group id an index falls in
       void getGroupId(size_t idx, size_t& groupId, size_t& idxGroup) const;
+      /// Rebuilds the groups positions and offsets from the groups ordering
+      void updateGroupsOffsets();
+      /// Throws if the dimension of a design variable missed an activation
+      void checkDesignVariableDim(const DesignVariable* designVariable,
+        const DesignVariableInfo& info) const;
 
 
       /// \brief the number of non-squared error terms in this optimization problem
@@ -191,8 +215,18 @@ namespace aslam {
       ErrorTermsSP _errorTerms;
       /// Groups ordering
       std::vector<size_t> _groupsOrdering;
-      /// Backup for design variables
-      DesignVariablesBackup _designVariablesBackup;
+      /// Dimensions of the active design variables in the groups
+      GroupsDims _groupsDims;
+      /// Dimension of all the active design variables
+      size_t _totalDim;
+      /// Snapshot of the design variables
+      DesignVariablesSnapshot _designVariablesSnapshot;
+      /// Position of the groups in the groups ordering
+      std::unordered_map<size_t, size_t> _groupsPositions;
+      /// Design variables of the groups in the groups ordering
+      std::vector<const DesignVariablesSP*> _orderedGroups;
+      /// Index of the first design variable of each group in solver order
+      std::vector<size_t> _groupsOffsets;
       /** @}
         */
 
@@ -0,0 +1,92 @@
+/******************************************************************************
+ * Copyright (C) 2013 by Jerome Maye                                          *
+ * jerome.maye@gmail.com                                                      *
+ ******************************************************************************/
+
+/** \file FenwickTree.h
+    \brief This file defines the FenwickTree class, which implements a binary
+           indexed tree over non-negative values.
+  */
+
+#ifndef ASLAM_CALIBRATION_DATA_FENWICK_TREE_H
+#define ASLAM_CALIBRATION_DATA_FENWICK_TREE_H
+
+#include <cstddef>
+#include <vector>
+
+namespace aslam {
+  namespace calibration {
+
+    /** The class FenwickTree implements a binary indexed tree over a sequence
+        of non-negative values. Updates, prefix sums, and the search of the
+        element a running sum falls in are in O(log n).
+        \brief Binary indexed tree
+      */
+    template <typename T>
+    class FenwickTree {
+    public:
+      /** \name Constructors/destructor
+        @{
+        */
+      /// Default constructor
+      FenwickTree() = default;
+      /// Copy constructor
+      FenwickTree(const FenwickTree& other) = default;
+      /// Copy assignment operator
+      FenwickTree& operator = (const FenwickTree& other) = default;
+      /// Move constructor
+      FenwickTree(FenwickTree&& other) = default;
+      /// Move assignment operator
+      FenwickTree& operator = (FenwickTree&& other) = default;
+      /// Destructor
+      ~FenwickTree() = default;
+      /** @}
+        */
+
+      /** \name Methods
+        @{
+        */
+      /// Clears the tree
+      void clear();
+      /// Builds the tree from values in O(n)
+      void assign(const std::vector<T>& values);
+      /// Appends a value in O(log n)
+      void pushBack(const T& value);
+      /// Adds a value to an element
+      void add(size_t idx, const T& value);
+      /// Subtracts a value from an element, which must stay non-negative
+      void subtract(size_t idx, const T& value);
+      /** @}
+        */
+
+      /** \name Accessors
+        @{
+        */
+      /// Returns the number of elements
+      size_t getSize() const;
+      /// Returns the sum of the first n elements
+      T getPrefixSum(size_t n) const;
+      /// Returns the sum of all the elements
+      T getSum() const;
+      /// Returns the index of the element the running sum value falls in
+      size_t find(const T& value) const;
+      /** @}
+        */
+
+    protected:
+      /** \name Protected members
+        @{
+        */
+      /// Partial sums, element i covers the range (i - lowbit(i), i]
+      std::vector<T> _tree;
+      /** @}
+        */
+
+    };
+
+  }
+}
+
+#include "aslam/calibration/data-structures/FenwickTree.tpp"
+
+#endif // ASLAM_CALIBRATION_DATA_FENWICK_TREE_H
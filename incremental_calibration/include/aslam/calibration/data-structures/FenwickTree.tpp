@@ -0,0 +1,101 @@
+/******************************************************************************
+ * Copyright (C) 2013 by Jerome Maye                                          *
+ * jerome.maye@gmail.com                                                      *
+ ******************************************************************************/
+
+#include "aslam/calibration/exceptions/OutOfBoundException.h"
+
+namespace aslam {
+  namespace calibration {
+
+/******************************************************************************/
+/* Accessors                                                                  */
+/******************************************************************************/
+
+    template <typename T>
+    size_t FenwickTree<T>::getSize() const {
+      return _tree.size();
+    }
+
+    template <typename T>
+    T FenwickTree<T>::getPrefixSum(size_t n) const {
+      if (n > _tree.size())
+        throw OutOfBoundException<size_t>(n, _tree.size(),
+          "index out of bounds", __FILE__, __LINE__, __PRETTY_FUNCTION__);
+      T sum = T();
+      for (size_t i = n; i > 0; i -= i & -i)
+        sum += _tree[i - 1];
+      return sum;
+    }
+
+    template <typename T>
+    T FenwickTree<T>::getSum() const {
+      return getPrefixSum(_tree.size());
+    }
+
+    template <typename T>
+    size_t FenwickTree<T>::find(const T& value) const {
+      // largest n whose prefix sum does not exceed value, by binary lifting
+      size_t step = 1;
+      while (step <= _tree.size() / 2)
+        step <<= 1;
+      size_t n = 0;
+      T remaining = value;
+      for (; step > 0; step >>= 1)
+        if (n + step <= _tree.size() && !(remaining < _tree[n + step - 1])) {
+          n += step;
+          remaining -= _tree[n - 1];
+        }
+      return n;
+    }
+
+/******************************************************************************/
+/* Methods                                                                    */
+/******************************************************************************/
+
+    template <typename T>
+    void FenwickTree<T>::clear() {
+      _tree.clear();
+    }
+
+    template <typename T>
+    void FenwickTree<T>::assign(const std::vector<T>& values) {
+      _tree = values;
+      const size_t size = _tree.size();
+      for (size_t i = 1; i <= size; ++i) {
+        const size_t parent = i + (i & -i);
+        if (parent <= size)
+          _tree[parent - 1] += _tree[i - 1];
+      }
+    }
+
+    template <typename T>
+    void FenwickTree<T>::pushBack(const T& value) {
+      // the new node covers the nodes hanging below it
+      const size_t n = _tree.size() + 1;
+      T node = value;
+      for (size_t i = n - 1; i > n - (n & -n); i -= i & -i)
+        node += _tree[i - 1];
+      _tree.push_back(node);
+    }
+
+    template <typename T>
+    void FenwickTree<T>::add(size_t idx, const T& value) {
+      if (idx >= _tree.size())
+        throw OutOfBoundException<size_t>(idx, _tree.size(),
+          "index out of bounds", __FILE__, __LINE__, __PRETTY_FUNCTION__);
+      for (size_t i = idx + 1; i <= _tree.size(); i += i & -i)
+        _tree[i - 1] += value;
+    }
+
+    template <typename T>
+    void FenwickTree<T>::subtract(size_t idx, const T& value) {
+      if (idx >= _tree.size())
+        throw OutOfBoundException<size_t>(idx, _tree.size(),
+          "index out of bounds", __FILE__, __LINE__, __PRETTY_FUNCTION__);
+      for (size_t i = idx + 1; i <= _tree.size(); i += i & -i)
+        _tree[i - 1] -= value;
+    }
+
+  }
+}
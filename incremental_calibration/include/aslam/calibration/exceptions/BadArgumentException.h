@@ -13,6 +13,7 @@
 
 #include <cstddef>
 
+#include <sstream>
 #include <string>
 
 #include "aslam/calibration/exceptions/Exception.h"
@@ -77,6 +77,8 @@ namespace aslam {
         const Eigen::Matrix<double, Eigen::Dynamic, 1>& responsibilities);
       /// Add points to the estimator
       void addPoints(const Container& points);
+      /// Merge the points of another estimator into this one
+      void merge(const EstimatorML& other);
       /// Reset the estimator
       void reset();
       /** @}
@@ -97,19 +99,29 @@ namespace aslam {
       /** @}
         */
 
+      /** \name Protected methods
+        @{
+        */
+      /// Builds the distribution from the running moments if outdated
+      void updateDistribution() const;
+      /** @}
+        */
+
       /** \name Protected members
         @{
         */
-      /// Estimated distribution
-      NormalDistribution<M> mDistribution;
+      /// Estimated distribution, built on demand
+      mutable NormalDistribution<M> mDistribution;
       /// Number of points in the estimator
       size_t mNumPoints;
       /// Valid flag
-      bool mValid;
-      /// Sum of the values
-      Eigen::Matrix<double, M, 1> mValuesSum;
-      /// Squared sum of the values
-      Eigen::Matrix<double, M, M> mSquaredValuesSum;
+      mutable bool mValid;
+      /// Flag set when the distribution reflects the running moments
+      mutable bool mUpToDate;
+      /// Running mean of the values
+      Eigen::Matrix<double, M, 1> mMean;
+      /// Running sum of squared deviations from the mean
+      Eigen::Matrix<double, M, M> mSquaredDeviationsSum;
       /** @}
         */
 
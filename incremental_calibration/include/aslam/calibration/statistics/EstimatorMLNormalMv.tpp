@@ -15,7 +15,8 @@ namespace aslam {
     template <int M>
     EstimatorML<NormalDistribution<M> >::EstimatorML() :
         mNumPoints(0),
-        mValid(false) {
+        mValid(false),
+        mUpToDate(true) {
     }
 
     template <int M>
@@ -23,8 +24,9 @@ namespace aslam {
         mDistribution(other.mDistribution),
         mNumPoints(other.mNumPoints),
         mValid(other.mValid),
-        mValuesSum(other.mValuesSum),
-        mSquaredValuesSum(other.mSquaredValuesSum) {
+        mUpToDate(other.mUpToDate),
+        mMean(other.mMean),
+        mSquaredDeviationsSum(other.mSquaredDeviationsSum) {
     }
 
     template <int M>
@@ -35,8 +37,9 @@ namespace aslam {
         mDistribution = other.mDistribution;
         mNumPoints = other.mNumPoints;
         mValid = other.mValid;
-        mValuesSum = other.mValuesSum;
-        mSquaredValuesSum = other.mSquaredValuesSum;
+        mUpToDate = other.mUpToDate;
+        mMean = other.mMean;
+        mSquaredDeviationsSum = other.mSquaredDeviationsSum;
       }
       return *this;
     }
@@ -56,6 +59,7 @@ namespace aslam {
     template <int M>
     void EstimatorML<NormalDistribution<M> >::write(std::ostream& stream)
         const {
+      updateDistribution();
       stream << "distribution: " << std::endl << mDistribution << std::endl
         << "number of points: " << mNumPoints << std::endl
         << "valid: " << mValid;
@@ -81,12 +85,14 @@ namespace aslam {
 
     template <int M>
     bool EstimatorML<NormalDistribution<M> >::getValid() const {
+      updateDistribution();
       return mValid;
     }
 
     template <int M>
     const NormalDistribution<M>&
         EstimatorML<NormalDistribution<M> >::getDistribution() const {
+      updateDistribution();
       return mDistribution;
     }
 
@@ -94,29 +100,23 @@ namespace aslam {
     void EstimatorML<NormalDistribution<M> >::reset() {
       mNumPoints = 0;
       mValid = false;
+      mUpToDate = true;
     }
 
     template <int M>
     void EstimatorML<NormalDistribution<M> >::addPoint(const Point& point) {
       if (mNumPoints == 0) {
-        mValuesSum = Eigen::Matrix<double, M, 1>::Zero(point.size());
-        mSquaredValuesSum = Eigen::Matrix<double, M, M>::Zero(point.size(),
+        mMean = Eigen::Matrix<double, M, 1>::Zero(point.size());
+        mSquaredDeviationsSum = Eigen::Matrix<double, M, M>::Zero(point.size(),
           point.size());
       }
       mNumPoints++;
-      mValuesSum += point;
-      mSquaredValuesSum += OuterProduct::compute<double, M>(point);
-      try {
-        mValid = true;
-        const Eigen::Matrix<double, M, 1> mean = mValuesSum / mNumPoints;
-        mDistribution.setMean(mean);
-        mDistribution.setCovariance(mSquaredValuesSum / mNumPoints -
-          OuterProduct::compute<double, M>(mValuesSum) * 2 /
-          (mNumPoints * mNumPoints) + OuterProduct::compute<double, M>(mean));
-      }
-      catch (...) {
-        mValid = false;
-      }
+      // Welford update, the outer product keeps the sum exactly symmetric
+      const Eigen::Matrix<double, M, 1> delta = point - mMean;
+      mMean += delta / static_cast<double>(mNumPoints);
+      mSquaredDeviationsSum += OuterProduct::compute<double, M>(delta) *
+        ((mNumPoints - 1) / static_cast<double>(mNumPoints));
+      mUpToDate = false;
     }
 
     template <int M>
@@ -158,6 +158,42 @@ namespace aslam {
       catch (...) {
         mValid = false;
       }
+      mUpToDate = true;
+    }
+
+    template <int M>
+    void EstimatorML<NormalDistribution<M> >::merge(const EstimatorML& other) {
+      if (other.mNumPoints == 0)
+        return;
+      if (mNumPoints == 0) {
+        *this = other;
+        return;
+      }
+      // pairwise combination of Chan et al.
+      const size_t numPoints = mNumPoints + other.mNumPoints;
+      const Eigen::Matrix<double, M, 1> delta = other.mMean - mMean;
+      mMean += delta * (other.mNumPoints / static_cast<double>(numPoints));
+      mSquaredDeviationsSum += other.mSquaredDeviationsSum +
+        OuterProduct::compute<double, M>(delta) *
+        (mNumPoints / static_cast<double>(numPoints) * other.mNumPoints);
+      mNumPoints = numPoints;
+      mUpToDate = false;
+    }
+
+    template <int M>
+    void EstimatorML<NormalDistribution<M> >::updateDistribution() const {
+      if (mUpToDate)
+        return;
+      mUpToDate = true;
+      try {
+        mValid = true;
+        mDistribution.setMean(mMean);
+        mDistribution.setCovariance(mSquaredDeviationsSum /
+          static_cast<double>(mNumPoints));
+      }
+      catch (...) {
+        mValid = false;
+      }
     }
 
   }
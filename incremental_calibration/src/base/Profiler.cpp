@@ -0,0 +1,206 @@
+/******************************************************************************
+ * Copyright (C) 2013 by Jerome Maye                                          *
+ * jerome.maye@gmail.com                                                      *
+ ******************************************************************************/
+
+#include "aslam/calibration/base/Profiler.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <fstream>
+#include <limits>
+
+#include "aslam/calibration/exceptions/BadArgumentException.h"
+
+namespace aslam {
+  namespace calibration {
+
+/******************************************************************************/
+/* Constructors and Destructor                                                */
+/******************************************************************************/
+
+    Profiler::ScopedPhase::ScopedPhase(Profiler& profiler, const char* phase) :
+        _profiler(profiler),
+        _phase(phase),
+        _start(Profiler::now()) {
+    }
+
+    Profiler::ScopedPhase::~ScopedPhase() {
+      _profiler.record(_phase, _start, Profiler::now() - _start);
+    }
+
+    Profiler::ScopedBatch::ScopedBatch(Profiler& profiler) :
+        _profiler(profiler),
+        _ended(false) {
+      _profiler.beginBatch();
+    }
+
+    Profiler::ScopedBatch::~ScopedBatch() {
+      if (!_ended)
+        _profiler.endBatch();
+    }
+
+    Profiler::Profiler(size_t windowSize, size_t maxNumEvents) :
+        _windowSize(windowSize),
+        _maxNumEvents(maxNumEvents) {
+    }
+
+    Profiler::~Profiler() {
+    }
+
+/******************************************************************************/
+/* Accessors                                                                  */
+/******************************************************************************/
+
+    std::vector<std::string> Profiler::getPhases() const {
+      std::lock_guard<std::mutex> lock(_mutex);
+      std::vector<std::string> phases;
+      phases.reserve(_phases.size());
+      for (auto it = _phases.cbegin(); it != _phases.cend(); ++it)
+        phases.push_back(it->first);
+      return phases;
+    }
+
+    Profiler::PhaseStatistics Profiler::getPhaseStatistics(const std::string&
+        phase) const {
+      std::lock_guard<std::mutex> lock(_mutex);
+      PhaseStatistics statistics;
+      statistics.count = 0;
+      statistics.total = 0.0;
+      statistics.min = 0.0;
+      statistics.max = 0.0;
+      statistics.windowMean = 0.0;
+
+      // decade bins from 1 us to 100 s, with underflow and overflow bins
+      Histogram& histogram = statistics.histogram;
+      histogram.edges.push_back(0.0);
+      for (int exponent = -6; exponent <= 2; ++exponent)
+        histogram.edges.push_back(std::pow(10.0, exponent));
+      histogram.edges.push_back(std::numeric_limits<double>::infinity());
+      histogram.counts.assign(histogram.edges.size() - 1, 0);
+
+      auto it = _phases.find(phase);
+      if (it == _phases.end())
+        return statistics;
+      statistics.count = it->second.count;
+      statistics.total = it->second.total;
+      statistics.min = it->second.min;
+      statistics.max = it->second.max;
+      const std::deque<double>& window = it->second.window;
+      for (auto wit = window.cbegin(); wit != window.cend(); ++wit) {
+        statistics.windowMean += *wit;
+        const size_t bin = std::upper_bound(histogram.edges.cbegin() + 1,
+          histogram.edges.cend() - 1, *wit) - histogram.edges.cbegin() - 1;
+        histogram.counts[bin]++;
+      }
+      if (!window.empty())
+        statistics.windowMean /= window.size();
+      return statistics;
+    }
+
+    std::vector<Profiler::Event> Profiler::getEvents() const {
+      std::lock_guard<std::mutex> lock(_mutex);
+      return std::vector<Event>(_events.cbegin(), _events.cend());
+    }
+
+    size_t Profiler::getWindowSize() const {
+      return _windowSize;
+    }
+
+/******************************************************************************/
+/* Methods                                                                    */
+/******************************************************************************/
+
+    double Profiler::now() {
+      return std::chrono::duration<double>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+    }
+
+    void Profiler::record(const std::string& phase, double start,
+        double duration) {
+      std::lock_guard<std::mutex> lock(_mutex);
+      auto it = _phases.find(phase);
+      if (it == _phases.end()) {
+        Phase& newPhase = _phases[phase];
+        newPhase.count = 0;
+        newPhase.total = 0.0;
+        newPhase.min = duration;
+        newPhase.max = duration;
+        it = _phases.find(phase);
+      }
+      Phase& accumulated = it->second;
+      accumulated.count++;
+      accumulated.total += duration;
+      accumulated.min = std::min(accumulated.min, duration);
+      accumulated.max = std::max(accumulated.max, duration);
+      accumulated.window.push_back(duration);
+      if (accumulated.window.size() > _windowSize)
+        accumulated.window.pop_front();
+      if (_maxNumEvents > 0) {
+        Event event;
+        event.phase = phase;
+        event.start = start;
+        event.duration = duration;
+        _events.push_back(event);
+        if (_events.size() > _maxNumEvents)
+          _events.pop_front();
+      }
+      for (auto it = _batchesPhaseTimes.begin();
+          it != _batchesPhaseTimes.end(); ++it)
+        (*it)[phase] += duration;
+    }
+
+    void Profiler::beginBatch() {
+      std::lock_guard<std::mutex> lock(_mutex);
+      _batchesPhaseTimes.push_back(PhaseTimes());
+    }
+
+    Profiler::PhaseTimes Profiler::endBatch() {
+      std::lock_guard<std::mutex> lock(_mutex);
+      PhaseTimes phaseTimes;
+      if (_batchesPhaseTimes.empty())
+        return phaseTimes;
+      phaseTimes.swap(_batchesPhaseTimes.back());
+      _batchesPhaseTimes.pop_back();
+      return phaseTimes;
+    }
+
+    Profiler::PhaseTimes Profiler::ScopedBatch::end() {
+      if (_ended)
+        return PhaseTimes();
+      _ended = true;
+      return _profiler.endBatch();
+    }
+
+    void Profiler::writeChromeTrace(const std::string& filename) const {
+      std::ofstream stream(filename.c_str());
+      if (!stream.is_open())
+        throw BadArgumentException<std::string>(filename,
+          "Profiler::writeChromeTrace(): cannot open file",
+          __FILE__, __LINE__, __PRETTY_FUNCTION__);
+      std::lock_guard<std::mutex> lock(_mutex);
+      const double origin = _events.empty() ? 0.0 : _events.front().start;
+      stream << "{\"traceEvents\":[";
+      for (auto it = _events.cbegin(); it != _events.cend(); ++it) {
+        if (it != _events.cbegin())
+          stream << ",";
+        stream << "\n{\"name\":\"" << it->phase << "\",\"ph\":\"X\",\"ts\":"
+          << std::llround((it->start - origin) * 1e6) << ",\"dur\":"
+          << std::llround(it->duration * 1e6)
+          << ",\"pid\":0,\"tid\":0}";
+      }
+      stream << "\n],\"displayTimeUnit\":\"ms\"}" << std::endl;
+    }
+
+    void Profiler::clear() {
+      std::lock_guard<std::mutex> lock(_mutex);
+      _phases.clear();
+      _events.clear();
+      for (auto it = _batchesPhaseTimes.begin();
+          it != _batchesPhaseTimes.end(); ++it)
+        it->clear();
+    }
+
+  }
+}
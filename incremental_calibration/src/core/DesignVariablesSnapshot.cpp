@@ -0,0 +1,115 @@
+/******************************************************************************
+ * Copyright (C) 2013 by Jerome Maye                                          *
+ * jerome.maye@gmail.com                                                      *
+ ******************************************************************************/
+
+#include "aslam/calibration/core/DesignVariablesSnapshot.h"
+
+#include <algorithm>
+
+#include <aslam/backend/DesignVariable.hpp>
+
+#include "aslam/calibration/exceptions/NullPointerException.h"
+
+namespace aslam {
+  namespace calibration {
+
+/******************************************************************************/
+/* Constructors and Destructor                                                */
+/******************************************************************************/
+
+    DesignVariablesSnapshot::DesignVariablesSnapshot() :
+        _lastTransferIdx(0) {
+    }
+
+    DesignVariablesSnapshot::~DesignVariablesSnapshot() {
+    }
+
+/******************************************************************************/
+/* Accessors                                                                  */
+/******************************************************************************/
+
+    const DesignVariablesSnapshot::Entries&
+        DesignVariablesSnapshot::getEntries() const {
+      return _entries;
+    }
+
+    size_t DesignVariablesSnapshot::getNumDesignVariables() const {
+      return _entries.size();
+    }
+
+    size_t DesignVariablesSnapshot::getNumParameters() const {
+      return _parameters.size();
+    }
+
+    const std::vector<double>& DesignVariablesSnapshot::getParameters() const {
+      return _parameters;
+    }
+
+/******************************************************************************/
+/* Methods                                                                    */
+/******************************************************************************/
+
+    void DesignVariablesSnapshot::save(const DesignVariablesP&
+        designVariables) {
+      clear();
+      _entries.reserve(designVariables.size());
+      for (auto it = designVariables.cbegin(); it != designVariables.cend();
+          ++it)
+        add(*it);
+    }
+
+    size_t DesignVariablesSnapshot::add(DesignVariable* designVariable) {
+      if (!designVariable)
+        throw NullPointerException("designVariable", __FILE__, __LINE__,
+          __PRETTY_FUNCTION__);
+      designVariable->getParameters(_transfer);
+      Entry entry;
+      entry.designVariable = designVariable;
+      entry.offset = _parameters.size();
+      entry.rows = _transfer.rows();
+      entry.cols = _transfer.cols();
+
+      // size the scratch matrix of this shape once, consecutive entries
+      // mostly share it
+      if (_lastTransferIdx >= _transfers.size() ||
+          _transfers[_lastTransferIdx].rows() != entry.rows ||
+          _transfers[_lastTransferIdx].cols() != entry.cols) {
+        _lastTransferIdx = std::find_if(_transfers.cbegin(),
+          _transfers.cend(), [&entry](const Eigen::MatrixXd& transfer) {
+          return transfer.rows() == entry.rows &&
+            transfer.cols() == entry.cols;}) - _transfers.cbegin();
+        if (_lastTransferIdx == _transfers.size())
+          _transfers.push_back(Eigen::MatrixXd(entry.rows, entry.cols));
+      }
+      entry.transferIdx = _lastTransferIdx;
+
+      _parameters.insert(_parameters.end(), _transfer.data(),
+        _transfer.data() + _transfer.size());
+      _entries.push_back(entry);
+      return _entries.size() - 1;
+    }
+
+    void DesignVariablesSnapshot::forget(size_t idx) {
+      if (idx < _entries.size())
+        _entries[idx].designVariable = nullptr;
+    }
+
+    void DesignVariablesSnapshot::restore() {
+      for (auto it = _entries.cbegin(); it != _entries.cend(); ++it) {
+        if (!it->designVariable)
+          continue;
+        Eigen::MatrixXd& transfer = _transfers[it->transferIdx];
+        transfer = Eigen::Map<const Eigen::MatrixXd>(_parameters.data() +
+          it->offset, it->rows, it->cols);
+        it->designVariable->setParameters(transfer);
+      }
+    }
+
+    void DesignVariablesSnapshot::clear() {
+      _entries.clear();
+      _parameters.clear();
+    }
+
+  }
+}
@@ -6,28 +6,105 @@
 #include "aslam/calibration/core/IncrementalEstimator.h"
 
 #include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <exception>
+#include <fstream>
 #include <utility>
 #include <vector>
 #include <ostream>
+#include <iostream>
+#include <limits>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
 
 #include <aslam-tsvd-solver/aslam-tsvd-solver.h>
+#include <aslam-tsvd-solver/marginal-svd.h>
+#include <aslam/backend/DesignVariable.hpp>
+#include <aslam/backend/ErrorTerm.hpp>
+#include <aslam/backend/DogLegTrustRegionPolicy.hpp>
 #include <aslam/backend/GaussNewtonTrustRegionPolicy.hpp>
+#include <aslam/backend/JacobianContainer.hpp>
+#include <aslam/backend/LevenbergMarquardtTrustRegionPolicy.hpp>
+#include <aslam/backend/MarginalizationPriorErrorTerm.hpp>
 #include <aslam/backend/Optimizer2.hpp>
 #include <boost/make_shared.hpp>
+#include <Eigen/Dense>
 #include <sm/PropertyTree.hpp>
 
 
 #include "aslam/calibration/core/IncrementalOptimizationProblem.h"
+#include "aslam/calibration/core/OptimizationProblem.h"
 #include "aslam/calibration/base/Timestamp.h"
 #include "aslam/calibration/exceptions/InvalidOperationException.h"
+#include "aslam/calibration/exceptions/BadArgumentException.h"
+#include "aslam/calibration/exceptions/OutOfBoundException.h"
 
 namespace aslam {
   namespace calibration {
 
+    namespace {
+
+      /// Magic number of the checkpoint files
+      const char checkpointMagic[4] = {'I', 'C', 'K', 'P'};
+
+      /// Byte-order marker of the checkpoint files
+      const uint64_t checkpointByteOrder = 0x0102030405060708ull;
+
+      /// Writes a plain value to a binary stream
+      template <typename T> void writeBinary(std::ofstream& stream,
+          const T& value) {
+        stream.write(reinterpret_cast<const char*>(&value), sizeof(T));
+      }
+
+      /// Reads a plain value from a binary stream
+      template <typename T> T readBinary(std::ifstream& stream) {
+        T value = T();
+        stream.read(reinterpret_cast<char*>(&value), sizeof(T));
+        return value;
+      }
+
+      /// Writes a dense matrix to a binary stream
+      template <typename M> void writeBinaryMatrix(std::ofstream& stream,
+          const M& matrix) {
+        writeBinary<uint64_t>(stream, matrix.rows());
+        writeBinary<uint64_t>(stream, matrix.cols());
+        const Eigen::MatrixXd values = matrix;
+        stream.write(reinterpret_cast<const char*>(values.data()),
+          sizeof(double) * values.size());
+      }
+
+      /// Reads a dense matrix from a binary stream ending at fileSize
+      Eigen::MatrixXd readBinaryMatrix(std::ifstream& stream,
+          std::streamoff fileSize) {
+        const uint64_t rows = readBinary<uint64_t>(stream);
+        const uint64_t cols = readBinary<uint64_t>(stream);
+        const std::streamoff position = stream.tellg();
+        if (!stream || position < 0 || position > fileSize)
+          return Eigen::MatrixXd();
+        const uint64_t maxSize = (fileSize - position) / sizeof(double);
+        if ((rows > 0 && cols > maxSize / rows) ||
+            (rows == 0 && cols > maxSize) || (cols == 0 && rows > maxSize))
+          throw OutOfBoundException<uint64_t>(rows * cols, maxSize,
+            "readBinaryMatrix(): matrix exceeds the file",
+            __FILE__, __LINE__, __PRETTY_FUNCTION__);
+        Eigen::MatrixXd matrix(rows, cols);
+        stream.read(reinterpret_cast<char*>(matrix.data()),
+          sizeof(double) * matrix.size());
+        return matrix;
+      }
+
+    }
+
 /******************************************************************************/
 /* Constructors and Destructor                                                */
 /******************************************************************************/
 
+    const uint32_t IncrementalEstimator::checkpointVersion;
+
     IncrementalEstimator::IncrementalEstimator(size_t margGroupId,
         const Options& options, const LinearSolverOptions&
         linearSolverOptions, const OptimizerOptions& optimizerOptions) :
@@ -37,6 +114,16 @@ namespace aslam {
         _problem(boost::make_shared<IncrementalOptimizationProblem>()),
         _informationGain(0.0),
         _svLog2Sum(0.0),
+        _nobsBasis(getEmptyMatrix()),
+        _nobsBasisScaled(getEmptyMatrix()),
+        _obsBasis(getEmptyMatrix()),
+        _obsBasisScaled(getEmptyMatrix()),
+        _sigma2Theta(getEmptyMatrix()),
+        _sigma2ThetaScaled(getEmptyMatrix()),
+        _sigma2ThetaObs(getEmptyMatrix()),
+        _sigma2ThetaObsScaled(getEmptyMatrix()),
+        _singularValues(getEmptyVector()),
+        _singularValuesScaled(getEmptyVector()),
         _svdTolerance(0.0),
         _qrTolerance(-1.0),
         _rankTheta(-1),
@@ -47,22 +134,46 @@ namespace aslam {
         _memoryUsage(0),
         _numFlops(0.0),
         _initialCost(0.0),
-        _finalCost(0.0) {
+        _finalCost(0.0),
+        _numScreenedBatches(0),
+        _numIncrementalUpdates(0),
+        _processingBatch(false),
+        _stopWorker(false),
+        _numBlockedSubmitters(0),
+        _queueStatistics(),
+        _totalLatency(0.0) {
       // create linear solver and trust region policy for the optimizer
       OptimizerOptions& optOptions = _optimizer->options();
-      optOptions.linearSystemSolver =
-        boost::make_shared<LinearSolver>(linearSolverOptions);
-      optOptions.trustRegionPolicy = boost::make_shared<TrustRegionPolicy>();
+      boost::shared_ptr<LinearSolver> linearSolver;
+      if (options.blockElimination)
+        linearSolver = boost::make_shared<BlockLinearSolver>(
+          linearSolverOptions, options.numSolverThreads);
+      else
+        linearSolver = boost::make_shared<LinearSolver>(linearSolverOptions);
+      optOptions.linearSystemSolver = linearSolver;
+      optOptions.trustRegionPolicy = createTrustRegionPolicy(
+        options.trustRegion, *linearSolver);
       _optimizer->initializeLinearSolver();
       _optimizer->initializeTrustRegionPolicy();
 
       // attach the problem to the optimizer
       _optimizer->setProblem(_problem);
+      checkOptions();
     }
 
     IncrementalEstimator::IncrementalEstimator(const sm::PropertyTree& config) :
         _informationGain(0.0),
         _svLog2Sum(0.0),
+        _nobsBasis(getEmptyMatrix()),
+        _nobsBasisScaled(getEmptyMatrix()),
+        _obsBasis(getEmptyMatrix()),
+        _obsBasisScaled(getEmptyMatrix()),
+        _sigma2Theta(getEmptyMatrix()),
+        _sigma2ThetaScaled(getEmptyMatrix()),
+        _sigma2ThetaObs(getEmptyMatrix()),
+        _sigma2ThetaObsScaled(getEmptyMatrix()),
+        _singularValues(getEmptyVector()),
+        _singularValuesScaled(getEmptyVector()),
         _svdTolerance(0.0),
         _qrTolerance(-1.0),
         _rankTheta(-1),
@@ -73,10 +184,46 @@ namespace aslam {
         _memoryUsage(0),
         _numFlops(0.0),
         _initialCost(0.0),
-        _finalCost(0.0) {
+        _finalCost(0.0),
+        _numScreenedBatches(0),
+        _numIncrementalUpdates(0),
+        _processingBatch(false),
+        _stopWorker(false),
+        _numBlockedSubmitters(0),
+        _queueStatistics(),
+        _totalLatency(0.0) {
       // create the optimizer, linear solver, and trust region policy
-      boost::shared_ptr<LinearSolver> linearSolver = boost::make_shared<LinearSolver>(sm::PropertyTree(config, "optimizer/linearSolver"));
-      _optimizer = boost::make_shared<Optimizer>(sm::PropertyTree(config, "optimizer"), linearSolver, boost::make_shared<TrustRegionPolicy>());
+      _options.blockElimination = config.getBool("blockElimination",
+        _options.blockElimination);
+      _options.numSolverThreads = config.getInt("numSolverThreads",
+        _options.numSolverThreads);
+      _options.incrementalMarginal = config.getBool("incrementalMarginal",
+        _options.incrementalMarginal);
+      _options.refactorizationPeriod = config.getInt("refactorizationPeriod",
+        _options.refactorizationPeriod);
+      const std::string trustRegion = config.getString("trustRegionPolicy",
+        "gaussNewton");
+      if (trustRegion == "gaussNewton")
+        _options.trustRegion = TrustRegion::GaussNewton;
+      else if (trustRegion == "levenbergMarquardt")
+        _options.trustRegion = TrustRegion::LevenbergMarquardt;
+      else if (trustRegion == "dogLeg")
+        _options.trustRegion = TrustRegion::DogLeg;
+      else
+        throw BadArgumentException<std::string>(trustRegion,
+          "IncrementalEstimator::IncrementalEstimator(): unknown trust region "
+          "policy", __FILE__, __LINE__, __PRETTY_FUNCTION__);
+      boost::shared_ptr<LinearSolver> linearSolver;
+      if (_options.blockElimination)
+        linearSolver = boost::make_shared<BlockLinearSolver>(
+          sm::PropertyTree(config, "optimizer/linearSolver"),
+          _options.numSolverThreads);
+      else
+        linearSolver = boost::make_shared<LinearSolver>(
+          sm::PropertyTree(config, "optimizer/linearSolver"));
+      _optimizer = boost::make_shared<Optimizer>(sm::PropertyTree(config,
+        "optimizer"), linearSolver, createTrustRegionPolicy(
+        _options.trustRegion, *linearSolver));
 
       // create the problem and attach it to the optimizer
       _problem = boost::make_shared<IncrementalOptimizationProblem>();
@@ -87,11 +234,56 @@ namespace aslam {
         _options.infoGainDelta);
       _options.checkValidity = config.getBool("checkValidity",
         _options.checkValidity);
+      _options.saveActiveOnly = config.getBool("saveActiveOnly",
+        _options.saveActiveOnly);
+      _options.preScreen = config.getBool("preScreen", _options.preScreen);
+      _options.preScreenMargin = config.getDouble("preScreenMargin",
+        _options.preScreenMargin);
+      _options.maxNumBatches = config.getInt("maxNumBatches",
+        _options.maxNumBatches);
+      // parsed as a string, byte budgets exceed the range of an int
+      _options.maxMemoryUsage = std::stoull(config.getString("maxMemoryUsage",
+        std::to_string(_options.maxMemoryUsage)));
+      _options.queueCapacity = config.getInt("queueCapacity",
+        _options.queueCapacity);
+      _options.numCandidateThreads = config.getInt("numCandidateThreads",
+        _options.numCandidateThreads);
+      _options.outputs = config.getInt("outputs", _options.outputs);
+      const std::string queuePolicy = config.getString("queuePolicy",
+        "block");
+      if (queuePolicy == "block")
+        _options.queuePolicy = QueuePolicy::Block;
+      else if (queuePolicy == "dropOldest")
+        _options.queuePolicy = QueuePolicy::DropOldest;
+      else if (queuePolicy == "dropNewest")
+        _options.queuePolicy = QueuePolicy::DropNewest;
+      else
+        throw BadArgumentException<std::string>(queuePolicy,
+          "IncrementalEstimator::IncrementalEstimator(): unknown queue policy",
+          __FILE__, __LINE__, __PRETTY_FUNCTION__);
       _options.verbose = config.getBool("verbose", _options.verbose);
       _margGroupId = config.getInt("groupId");
+      checkOptions();
     }
 
-    IncrementalEstimator::~IncrementalEstimator() {}
+    IncrementalEstimator::~IncrementalEstimator() {
+      // stop the worker after its current batch and release the submitters
+      // blocked on a full queue before the members go away
+      {
+        std::unique_lock<std::mutex> lock(_queueMutex);
+        _stopWorker = true;
+        _queueNotFull.notify_all();
+        _submitterReleased.wait(lock, [this]() {
+          return _numBlockedSubmitters == 0;});
+      }
+      _queueNotEmpty.notify_all();
+      if (_worker.joinable())
+        _worker.join();
+
+      // drop the batches still waiting
+      for (auto it = _batchQueue.begin(); it != _batchQueue.end(); ++it)
+        it->result.set_value(getDroppedReturnValue());
+    }
 
 /******************************************************************************/
 /* Accessors                                                                  */
@@ -138,6 +330,28 @@ namespace aslam {
       return _informationGain;
     }
 
+    size_t IncrementalEstimator::getNumScreenedBatches() const {
+      return _numScreenedBatches;
+    }
+
+    IncrementalEstimator::QueueStatistics
+        IncrementalEstimator::getQueueStatistics() const {
+      std::lock_guard<std::mutex> lock(_queueMutex);
+      QueueStatistics statistics = _queueStatistics;
+      statistics.queueDepth = _batchQueue.size();
+      statistics.meanLatency = statistics.numProcessed > 0 ?
+        _totalLatency / statistics.numProcessed : 0.0;
+      return statistics;
+    }
+
+    const Profiler& IncrementalEstimator::getProfiler() const {
+      return _profiler;
+    }
+
+    Profiler& IncrementalEstimator::getProfiler() {
+      return _profiler;
+    }
+
     const aslam::backend::CompressedColumnMatrix<std::ptrdiff_t>&
         IncrementalEstimator::getJacobianTranspose() const {
       return _optimizer->getSolver<LinearSolver>()->getJacobianTranspose();
@@ -182,41 +396,66 @@ namespace aslam {
     const Eigen::MatrixXd& IncrementalEstimator::getNobsBasis(bool scaled)
         const {
       if (scaled)
-        return _nobsBasisScaled;
+        return *_nobsBasisScaled;
       else
-        return _nobsBasis;
+        return *_nobsBasis;
     }
 
     const Eigen::MatrixXd& IncrementalEstimator::getObsBasis(bool scaled)
         const {
       if (scaled)
-        return _obsBasisScaled;
+        return *_obsBasisScaled;
       else
-        return _obsBasis;
+        return *_obsBasis;
     }
 
     const Eigen::MatrixXd& IncrementalEstimator::getSigma2Theta(bool scaled)
         const {
       if (scaled)
-        return _sigma2ThetaScaled;
+        return *_sigma2ThetaScaled;
       else
-        return _sigma2Theta;
+        return *_sigma2Theta;
     }
 
     const Eigen::MatrixXd& IncrementalEstimator::getSigma2ThetaObs(bool scaled)
         const {
       if (scaled)
-        return _sigma2ThetaObsScaled;
+        return *_sigma2ThetaObsScaled;
       else
-        return _sigma2ThetaObs;
+        return *_sigma2ThetaObs;
+    }
+
+    Eigen::VectorXd IncrementalEstimator::getSigma2ThetaDiagonal(bool scaled)
+        const {
+      const Eigen::MatrixXd& sigma2Theta = getSigma2Theta(scaled);
+      if (sigma2Theta.size() > 0)
+        return sigma2Theta.diagonal();
+      return getSigma2ThetaFactor(scaled).rowwise().squaredNorm();
+    }
+
+    Eigen::MatrixXd IncrementalEstimator::getSigma2ThetaBlock(size_t start,
+        size_t size, bool scaled) const {
+      const Eigen::MatrixXd& sigma2Theta = getSigma2Theta(scaled);
+      const Eigen::MatrixXd factor = sigma2Theta.size() > 0 ?
+        Eigen::MatrixXd() : getSigma2ThetaFactor(scaled);
+      const size_t dim = sigma2Theta.size() > 0 ? sigma2Theta.rows() :
+        factor.rows();
+      if (start + size > dim)
+        throw OutOfBoundException<size_t>(start + size, dim,
+          "IncrementalEstimator::getSigma2ThetaBlock(): block exceeds theta",
+          __FILE__, __LINE__, __PRETTY_FUNCTION__);
+      if (sigma2Theta.size() > 0)
+        return sigma2Theta.block(start, start, size, size);
+      return factor.middleRows(start, size) *
+        factor.middleRows(start, size).transpose();
     }
 
     const Eigen::VectorXd& IncrementalEstimator::getSingularValues(bool scaled)
         const {
       if (scaled)
-        return _singularValuesScaled;
+        return *_singularValuesScaled;
       else
-        return _singularValues;
+        return *_singularValues;
     }
 
     double IncrementalEstimator::getInitialCost() const {
@@ -234,49 +473,52 @@ namespace aslam {
     IncrementalEstimator::ReturnValue IncrementalEstimator::reoptimize() {
       // query the time
       const double timeStart = Timestamp::now();
+      ASLAM_CALIBRATION_PROFILE(Profiler::ScopedBatch profiledBatch(_profiler));
 
       // ensure marginalized design variables are well located
       orderMarginalizedDesignVariables();
 
       // set the marginalization index of the linear solver
-      size_t JCols = 0;
-      for (auto it = _problem->getGroupsOrdering().cbegin();
-          it != _problem->getGroupsOrdering().cend(); ++it)
-        JCols += _problem->getGroupDim(*it);
+      const size_t JCols = _problem->getTotalDim();
       const size_t dim = _problem->getGroupDim(_margGroupId);
       auto linearSolver = _optimizer->getSolver<LinearSolver>();
       linearSolver->setMargStartIndex(static_cast<std::ptrdiff_t>(JCols - dim));
 
       // optimize
-      aslam::backend::SolutionReturnValue srv = _optimizer->optimize();
+      ASLAM_CALIBRATION_PROFILE(const LinearSolver::Timings solverTimings =
+        linearSolver->getTimings());
+      aslam::backend::SolutionReturnValue srv;
+      {
+        ASLAM_CALIBRATION_PROFILE_PHASE(_profiler, "optimize");
+        srv = _optimizer->optimize();
+      }
+      ASLAM_CALIBRATION_PROFILE(recordSolverPhases(solverTimings));
 
       // grep the scaled linear system informations
-      if (linearSolver->getOptions().columnScaling) {
-        _singularValuesScaled = linearSolver->getSingularValues();
-        _nobsBasisScaled = linearSolver->getNullSpace();
-        _obsBasisScaled = linearSolver->getRowSpace();
-        _sigma2ThetaScaled = linearSolver->getCovariance();
-        _sigma2ThetaObsScaled = linearSolver->getRowSpaceCovariance();
-      }
-      else {
-        _singularValuesScaled.resize(0);
-        _nobsBasisScaled.resize(0, 0);
-        _obsBasisScaled.resize(0, 0);
-        _sigma2ThetaScaled.resize(0, 0);
-        _sigma2ThetaObsScaled.resize(0, 0);
-      }
+      ReturnValue ret;
+      computeScaledOutputs(ret);
 
       // analyze the unscaled marginal system
-      linearSolver->analyzeMarginal();
+      {
+        ASLAM_CALIBRATION_PROFILE_PHASE(_profiler, "analyzeMarginal");
+        linearSolver->analyzeMarginal();
+      }
 
       // retrieve informations from the linear solver
+      computeOutputs(ret);
       _informationGain = 0.0;
+      _numIncrementalUpdates = 0;
       _svLog2Sum = linearSolver->getSingularValuesLog2Sum();
-      _nobsBasis = linearSolver->getNullSpace();
-      _obsBasis = linearSolver->getRowSpace();
-      _sigma2Theta = linearSolver->getCovariance();
-      _sigma2ThetaObs = linearSolver->getRowSpaceCovariance();
-      _singularValues = linearSolver->getSingularValues();
+      _nobsBasis = ret.nobsBasis;
+      _nobsBasisScaled = ret.nobsBasisScaled;
+      _obsBasis = ret.obsBasis;
+      _obsBasisScaled = ret.obsBasisScaled;
+      _sigma2Theta = ret.sigma2Theta;
+      _sigma2ThetaScaled = ret.sigma2ThetaScaled;
+      _sigma2ThetaObs = ret.sigma2ThetaObs;
+      _sigma2ThetaObsScaled = ret.sigma2ThetaObsScaled;
+      _singularValues = ret.singularValues;
+      _singularValuesScaled = ret.singularValuesScaled;
       _svdTolerance = linearSolver->getSVDTolerance();
       _qrTolerance = linearSolver->getQRTolerance();
       _rankTheta = linearSolver->getSVDRank();
@@ -290,8 +532,13 @@ namespace aslam {
       _finalCost = srv.JFinal;
 
       // update output structure
-      ReturnValue ret;
       ret.batchAccepted = true;
+      ret.batchScreened = false;
+      ret.batchDropped = false;
+      ret.marginalApproximate = false;
+      ret.numEvictedBatches = 0;
+      ret.memoryUsageBeforeEviction = _memoryUsage;
+      ret.memoryUsageAfterEviction = _memoryUsage;
       ret.informationGain = 0.0;
       ret.rankPsi = _rankPsi;
       ret.rankPsiDeficiency = _rankPsiDeficiency;
@@ -299,52 +546,241 @@ namespace aslam {
       ret.rankThetaDeficiency = _rankThetaDeficiency;
       ret.svdTolerance = _svdTolerance;
       ret.qrTolerance = _qrTolerance;
-      ret.nobsBasis = _nobsBasis;
-      ret.nobsBasisScaled = _nobsBasisScaled;
-      ret.obsBasis = _obsBasis;
-      ret.obsBasisScaled = _obsBasisScaled;
-      ret.sigma2Theta = _sigma2Theta;
-      ret.sigma2ThetaScaled = _sigma2ThetaScaled;
-      ret.sigma2ThetaObs = _sigma2ThetaObs;
-      ret.sigma2ThetaObsScaled = _sigma2ThetaObsScaled;
-      ret.singularValues = _singularValues;
-      ret.singularValuesScaled = _singularValuesScaled;
       ret.numIterations = srv.iterations;
       ret.JStart = _initialCost;
       ret.JFinal = _finalCost;
       ret.elapsedTime = Timestamp::now() - timeStart;
+      ASLAM_CALIBRATION_PROFILE(ret.phaseTimes = profiledBatch.end());
       return ret;
     }
 
     IncrementalEstimator::ReturnValue
         IncrementalEstimator::addBatch(const BatchSP& problem, bool force) {
+      ASLAM_CALIBRATION_PROFILE(Profiler::ScopedBatch profiledBatch(_profiler));
+      ReturnValue ret;
+      {
+        ASLAM_CALIBRATION_PROFILE_PHASE(_profiler, "addBatch");
+
+        // query the time
+        const double timeStart = Timestamp::now();
+
+        // reject obviously uninformative batches without optimizing
+        double estimatedInformationGain;
+        std::ptrdiff_t estimatedRankTheta;
+        if (!force && _options.preScreen && estimateInformationGain(problem,
+            estimatedInformationGain, estimatedRankTheta) &&
+            estimatedRankTheta <= _rankTheta && estimatedInformationGain +
+            _options.preScreenMargin <= _options.infoGainDelta) {
+          _numScreenedBatches++;
+          ret = getRejectedReturnValue();
+          ret.batchScreened = true;
+          ret.informationGain = estimatedInformationGain;
+          ret.rankTheta = estimatedRankTheta;
+          ret.elapsedTime = Timestamp::now() - timeStart;
+        }
+        // test the batch against the full problem
+        else
+          ret = testBatches(std::vector<BatchSP>(1, problem), force,
+            timeStart);
+      }
+      ASLAM_CALIBRATION_PROFILE(ret.phaseTimes = profiledBatch.end());
+      return ret;
+    }
+
+    std::vector<IncrementalEstimator::ReturnValue>
+        IncrementalEstimator::addBatches(const std::vector<BatchSP>& batches,
+        CandidateSelection selection) {
+      ASLAM_CALIBRATION_PROFILE(Profiler::ScopedBatch profiledBatch(_profiler));
+
       // query the time
       const double timeStart = Timestamp::now();
 
-      // insert new batch in the problem
-      _problem->add(problem);
+      // candidates sharing a design variable other than theta write its block
+      // index and evaluate its expressions: they are grouped and estimated
+      // in turn by the same thread, theta is only read
+      const size_t numBatches = batches.size();
+      std::unordered_set<const aslam::backend::DesignVariable*> thetaDVs;
+      if (_problem->isGroupInProblem(_margGroupId)) {
+        const auto& group = _problem->getDesignVariablesGroup(_margGroupId);
+        thetaDVs.insert(group.cbegin(), group.cend());
+      }
+      std::vector<size_t> parents(numBatches);
+      for (size_t i = 0; i < numBatches; ++i)
+        parents[i] = i;
+      auto findRoot = [&parents](size_t i) {
+        while (parents[i] != i)
+          i = parents[i] = parents[parents[i]];
+        return i;
+      };
+      std::unordered_map<const aslam::backend::DesignVariable*, size_t> owners;
+      for (size_t i = 0; i < numBatches; ++i) {
+        const size_t numDVs = batches[i]->numDesignVariables();
+        for (size_t j = 0; j < numDVs; ++j) {
+          const aslam::backend::DesignVariable* dv =
+            batches[i]->designVariable(j);
+          if (thetaDVs.count(dv))
+            continue;
+          auto owner = owners.insert(std::make_pair(dv, i));
+          if (!owner.second)
+            parents[findRoot(i)] = findRoot(owner.first->second);
+        }
+      }
+      std::vector<std::vector<size_t> > groups;
+      std::unordered_map<size_t, size_t> groupsIdx;
+      for (size_t i = 0; i < numBatches; ++i) {
+        auto groupIt = groupsIdx.insert(std::make_pair(findRoot(i),
+          groups.size()));
+        if (groupIt.second)
+          groups.push_back(std::vector<size_t>());
+        groups[groupIt.first->second].push_back(i);
+      }
+
+      // approximate the information gain of the groups in parallel
+      std::vector<double> informationGains(numBatches, 0.0);
+      std::vector<std::ptrdiff_t> ranksTheta(numBatches, -1);
+      std::vector<char> estimated(numBatches, false);
+      std::vector<std::exception_ptr> errors(groups.size());
+      std::atomic<size_t> nextGroup(0);
+      auto estimate = [&]() {
+        for (size_t g = nextGroup++; g < groups.size(); g = nextGroup++) {
+          try {
+            for (auto it = groups[g].cbegin(); it != groups[g].cend(); ++it)
+              estimated[*it] = estimateInformationGain(batches[*it],
+                informationGains[*it], ranksTheta[*it]);
+          }
+          catch (...) {
+            errors[g] = std::current_exception();
+          }
+        }
+      };
+      size_t numThreads = _options.numCandidateThreads > 0 ?
+        _options.numCandidateThreads : std::thread::hardware_concurrency();
+      numThreads = std::max<size_t>(1, std::min(numThreads, groups.size()));
+      std::vector<std::thread> threads;
+      threads.reserve(numThreads - 1);
+      for (size_t i = 1; i < numThreads; ++i)
+        threads.push_back(std::thread(estimate));
+      estimate();
+      for (auto it = threads.begin(); it != threads.end(); ++it)
+        it->join();
+      for (auto it = errors.cbegin(); it != errors.cend(); ++it)
+        if (*it)
+          std::rethrow_exception(*it);
+
+      // without a marginal system to compare against, test them in turn,
+      // each of them reports its own phase times
+      std::vector<ReturnValue> rets;
+      rets.reserve(numBatches);
+      if (std::find(estimated.begin(), estimated.end(), false) !=
+          estimated.end()) {
+        for (auto it = batches.cbegin(); it != batches.cend(); ++it)
+          rets.push_back(addBatch(*it));
+        return rets;
+      }
+      for (size_t i = 0; i < numBatches; ++i) {
+        rets.push_back(getRejectedReturnValue());
+        rets.back().informationGain = informationGains[i];
+        rets.back().rankTheta = ranksTheta[i];
+      }
+
+      // the approximate gain linearizes the candidates at the current
+      // estimate and misses the validity check, a rejected candidate falls
+      // back to the next-ranked one
+      if (selection == CandidateSelection::MostInformative) {
+        std::vector<size_t> ranked(numBatches);
+        for (size_t i = 0; i < numBatches; ++i)
+          ranked[i] = i;
+        std::stable_sort(ranked.begin(), ranked.end(),
+          [&ranksTheta, &informationGains](size_t lhs, size_t rhs) {
+          return ranksTheta[lhs] > ranksTheta[rhs] || (ranksTheta[lhs] ==
+            ranksTheta[rhs] && informationGains[lhs] >
+            informationGains[rhs]);});
+        for (auto it = ranked.cbegin(); it != ranked.cend(); ++it) {
+          rets[*it] = testBatches(std::vector<BatchSP>(1, batches[*it]),
+            false, timeStart);
+          if (rets[*it].batchAccepted)
+            break;
+        }
+      }
+
+      // select the candidates to test together against the full problem
+      std::vector<size_t> selected;
+      if (selection == CandidateSelection::Combined) {
+        for (size_t i = 0; i < numBatches; ++i)
+          if (informationGains[i] > 0.0 || ranksTheta[i] > _rankTheta)
+            selected.push_back(i);
+      }
+      if (!selected.empty()) {
+        std::vector<BatchSP> selectedBatches;
+        selectedBatches.reserve(selected.size());
+        for (auto it = selected.cbegin(); it != selected.cend(); ++it)
+          selectedBatches.push_back(batches[*it]);
+        // the selected candidates are tested together and share the joint
+        // outcome
+        const ReturnValue ret = testBatches(selectedBatches, false,
+          timeStart);
+        for (auto it = selected.cbegin(); it != selected.cend(); ++it)
+          rets[*it] = ret;
+      }
+
+      // all the candidates report the phase times of the whole selection
+      ASLAM_CALIBRATION_PROFILE(const Profiler::PhaseTimes phaseTimes =
+        profiledBatch.end());
+      ASLAM_CALIBRATION_PROFILE(for (auto it = rets.begin(); it != rets.end();
+        ++it) it->phaseTimes = phaseTimes);
+      return rets;
+    }
+
+    IncrementalEstimator::ReturnValue IncrementalEstimator::testBatches(
+        const std::vector<BatchSP>& batches, bool force, double timeStart) {
+      // the incremental update eliminates the nuisance variables of a batch
+      // on their own, only those no other batch shares qualify
+      bool privateNuisances = batches.size() == 1;
+      for (size_t i = 0; privateNuisances &&
+          i < batches.front()->numDesignVariables(); ++i) {
+        const aslam::backend::DesignVariable* dv =
+          batches.front()->designVariable(i);
+        privateNuisances = batches.front()->getGroupId(dv) == _margGroupId ||
+          !_problem->isDesignVariableInProblem(dv);
+      }
+
+      // insert new batches in the problem
+      for (auto it = batches.cbegin(); it != batches.cend(); ++it)
+        _problem->add(*it);
 
       // ensure marginalized design variables are well located
       orderMarginalizedDesignVariables();
 
-      // save design variables in case the batch is rejected
-      if (!force)
-        _problem->saveDesignVariables();
+      // save design variables in case the batch is rejected, the optimizer
+      // only updates the active ones
+      if (!force) {
+        ASLAM_CALIBRATION_PROFILE_PHASE(_profiler, "saveDesignVariables");
+        _problem->saveDesignVariables(_options.saveActiveOnly);
+      }
 
-      // set the marginalization index of the linear solver
-      size_t JCols = 0;
-      for (auto it = _problem->getGroupsOrdering().cbegin();
-          it != _problem->getGroupsOrdering().cend(); ++it)
-        JCols += _problem->getGroupDim(*it);
+      // set the marginalization index of the linear solver and keep the
+      // current Jacobian in case the batch is rejected
+      const size_t JCols = _problem->getTotalDim();
       const size_t dim = _problem->getGroupDim(_margGroupId);
       auto linearSolver = _optimizer->getSolver<LinearSolver>();
+      if (!force)
+        linearSolver->stashJacobianTranspose();
       linearSolver->setMargStartIndex(static_cast<std::ptrdiff_t>(JCols - dim));
 
       // optimize
-      aslam::backend::SolutionReturnValue srv = _optimizer->optimize();
+      ASLAM_CALIBRATION_PROFILE(const LinearSolver::Timings solverTimings =
+        linearSolver->getTimings());
+      aslam::backend::SolutionReturnValue srv;
+      {
+        ASLAM_CALIBRATION_PROFILE_PHASE(_profiler, "optimize");
+        srv = _optimizer->optimize();
+      }
+      ASLAM_CALIBRATION_PROFILE(recordSolverPhases(solverTimings));
 
       // return value
       ReturnValue ret;
+      ret.batchScreened = false;
+      ret.batchDropped = false;
 
       // fill statistics from optimizer
       ret.numIterations = srv.iterations;
@@ -352,36 +788,34 @@ namespace aslam {
       ret.JFinal = srv.JFinal;
 
       // grep the scaled singular values if scaling enabled
-      if (linearSolver->getOptions().columnScaling) {
-        ret.singularValuesScaled = linearSolver->getSingularValues();
-        ret.nobsBasisScaled = linearSolver->getNullSpace();
-        ret.obsBasisScaled = linearSolver->getRowSpace();
-        ret.sigma2ThetaScaled = linearSolver->getCovariance();
-        ret.sigma2ThetaObsScaled = linearSolver->getRowSpaceCovariance();
+      computeScaledOutputs(ret);
+
+      // analyze marginal system (unscaled system), a single batch may only
+      // update the factor of the previous analysis
+      double svLog2Sum = 0.0;
+      bool incremental = false;
+      if (_options.incrementalMarginal && privateNuisances &&
+          _numIncrementalUpdates < _options.refactorizationPeriod) {
+        ASLAM_CALIBRATION_PROFILE_PHASE(_profiler, "updateMarginal");
+        incremental = updateMarginal(batches.front().get(), ret, svLog2Sum);
       }
-      else {
-        ret.singularValuesScaled.resize(0);
-        ret.nobsBasisScaled.resize(0, 0);
-        ret.obsBasisScaled.resize(0, 0);
-        ret.sigma2ThetaScaled.resize(0, 0);
-        ret.sigma2ThetaObsScaled.resize(0, 0);
-      }
-
-      // analyze marginal system (unscaled system)
-      linearSolver->analyzeMarginal();
-
-      // fill statistics from the linear solver
-      ret.rankPsi = linearSolver->getQRRank();
-      ret.rankPsiDeficiency = linearSolver->getQRRankDeficiency();
-      ret.rankTheta = linearSolver->getSVDRank();
-      ret.rankThetaDeficiency = linearSolver->getSVDRankDeficiency();
-      ret.svdTolerance = linearSolver->getSVDTolerance();
-      ret.qrTolerance = linearSolver->getQRTolerance();
-      ret.nobsBasis = linearSolver->getNullSpace();
-      ret.obsBasis = linearSolver->getRowSpace();
-      ret.sigma2Theta = linearSolver->getCovariance();
-      ret.sigma2ThetaObs = linearSolver->getRowSpaceCovariance();
-      ret.singularValues = linearSolver->getSingularValues();
+      if (!incremental) {
+        {
+          ASLAM_CALIBRATION_PROFILE_PHASE(_profiler, "analyzeMarginal");
+          linearSolver->analyzeMarginal();
+        }
+
+        // fill statistics from the linear solver
+        ret.rankPsi = linearSolver->getQRRank();
+        ret.rankPsiDeficiency = linearSolver->getQRRankDeficiency();
+        ret.rankTheta = linearSolver->getSVDRank();
+        ret.rankThetaDeficiency = linearSolver->getSVDRankDeficiency();
+        ret.svdTolerance = linearSolver->getSVDTolerance();
+        ret.qrTolerance = linearSolver->getQRTolerance();
+        computeOutputs(ret);
+        svLog2Sum = linearSolver->getSingularValuesLog2Sum();
+      }
+      ret.marginalApproximate = incremental;
 
       // check if the solution is valid
       bool solutionValid = true;
@@ -390,7 +824,6 @@ namespace aslam {
         solutionValid = false;
 
       // compute the information gain
-      const double svLog2Sum = linearSolver->getSingularValuesLog2Sum();
       ret.informationGain = 0.5 * (svLog2Sum - _svLog2Sum);
 
       // batch is kept? information gain improvement or rank goes up or force
@@ -406,6 +839,7 @@ namespace aslam {
 
         // update internal variables
         _informationGain = ret.informationGain;
+        _numIncrementalUpdates = incremental ? _numIncrementalUpdates + 1 : 0;
         _svLog2Sum = svLog2Sum;
         _nobsBasis = ret.nobsBasis;
         _nobsBasisScaled = ret.nobsBasisScaled;
@@ -434,15 +868,34 @@ namespace aslam {
       // remove batch if necessary
       if (!keepBatch) {
         // restore variables
-        _problem->restoreDesignVariables();
+        {
+          ASLAM_CALIBRATION_PROFILE_PHASE(_profiler, "restoreDesignVariables");
+          _problem->restoreDesignVariables();
+        }
 
-        // kick out the problem from the container
-        _problem->remove(problem);
+        // kick out the batches from the container
+        for (auto it = batches.crbegin(); it != batches.crend(); ++it)
+          _problem->remove(*it);
 
         // restore the linear solver
         if (_problem->getNumOptimizationProblems() > 0)
           restoreLinearSolver();
+        else
+          linearSolver->clearStashedJacobianTranspose();
+      }
+      else if (!force) {
+        // the Jacobian of the previous state is not needed anymore
+        linearSolver->clearStashedJacobianTranspose();
+      }
+
+      // keep the problem within its bounds
+      ret.memoryUsageBeforeEviction = _memoryUsage;
+      ret.numEvictedBatches = 0;
+      if (keepBatch && isBoundExceeded()) {
+        ret.numEvictedBatches = evictBatches(batches);
+        _informationGain = ret.informationGain;
       }
+      ret.memoryUsageAfterEviction = _memoryUsage;
 
       // insert elapsed time
       ret.elapsedTime = Timestamp::now() - timeStart;
@@ -451,6 +904,271 @@ namespace aslam {
       return ret;
     }
 
+    std::future<IncrementalEstimator::ReturnValue>
+        IncrementalEstimator::submitBatch(const BatchSP& batch, bool force) {
+      QueuedBatch queuedBatch;
+      queuedBatch.batch = batch;
+      queuedBatch.force = force;
+      queuedBatch.submitTime = std::chrono::steady_clock::now();
+      std::future<ReturnValue> result = queuedBatch.result.get_future();
+
+      std::unique_lock<std::mutex> lock(_queueMutex);
+      if (!_worker.joinable())
+        _worker = std::thread(&IncrementalEstimator::processBatches, this);
+
+      // apply the back-pressure policy
+      const size_t capacity = _options.queueCapacity;
+      if (capacity > 0 && _batchQueue.size() >= capacity) {
+        switch (_options.queuePolicy) {
+          case QueuePolicy::Block:
+            _numBlockedSubmitters++;
+            _queueNotFull.wait(lock, [this, capacity]() {
+              return _stopWorker || _batchQueue.size() < capacity;});
+            _numBlockedSubmitters--;
+            if (_stopWorker) {
+              _submitterReleased.notify_all();
+              queuedBatch.result.set_exception(std::make_exception_ptr(
+                InvalidOperationException("IncrementalEstimator::"
+                "submitBatch(): estimator destroyed while waiting", __FILE__,
+                __LINE__, __PRETTY_FUNCTION__)));
+              return result;
+            }
+            break;
+          case QueuePolicy::DropOldest:
+            _batchQueue.front().result.set_value(getDroppedReturnValue());
+            _batchQueue.pop_front();
+            _queueStatistics.numDropped++;
+            break;
+          case QueuePolicy::DropNewest:
+            _queueStatistics.numSubmitted++;
+            _queueStatistics.numDropped++;
+            queuedBatch.result.set_value(getDroppedReturnValue());
+            return result;
+        }
+      }
+
+      // queue the batch for the worker
+      _queueStatistics.numSubmitted++;
+      _batchQueue.push_back(std::move(queuedBatch));
+      _queueStatistics.maxQueueDepth = std::max(_queueStatistics.maxQueueDepth,
+        _batchQueue.size());
+      lock.unlock();
+      _queueNotEmpty.notify_one();
+      return result;
+    }
+
+    void IncrementalEstimator::waitForBatches() {
+      std::unique_lock<std::mutex> lock(_queueMutex);
+      _batchProcessed.wait(lock, [this]() {
+        return _batchQueue.empty() && !_processingBatch;});
+    }
+
+    void IncrementalEstimator::saveCheckpoint(const std::string& filename)
+        const {
+      std::ofstream stream(filename.c_str(), std::ios::binary);
+      if (!stream.is_open())
+        throw BadArgumentException<std::string>(filename,
+          "IncrementalEstimator::saveCheckpoint(): cannot open file",
+          __FILE__, __LINE__, __PRETTY_FUNCTION__);
+
+      // header, every field after it is 8-byte aligned
+      stream.write(checkpointMagic, sizeof(checkpointMagic));
+      writeBinary<uint32_t>(stream, checkpointVersion);
+      writeBinary<uint64_t>(stream, checkpointByteOrder);
+      writeBinary<uint64_t>(stream, _margGroupId);
+
+      // state of the estimator
+      writeBinary<double>(stream, _informationGain);
+      writeBinary<double>(stream, _svLog2Sum);
+      writeBinary<double>(stream, _svdTolerance);
+      writeBinary<double>(stream, _qrTolerance);
+      writeBinary<double>(stream, _initialCost);
+      writeBinary<double>(stream, _finalCost);
+      writeBinary<int64_t>(stream, _rankTheta);
+      writeBinary<int64_t>(stream, _rankThetaDeficiency);
+      writeBinary<int64_t>(stream, _rankPsi);
+      writeBinary<int64_t>(stream, _rankPsiDeficiency);
+
+      // active calibration design variables
+      std::vector<const aslam::backend::DesignVariable*> designVariables;
+      if (_problem->isGroupInProblem(_margGroupId)) {
+        const auto& thetaDVs = _problem->getDesignVariablesGroup(_margGroupId);
+        for (auto it = thetaDVs.cbegin(); it != thetaDVs.cend(); ++it)
+          if ((*it)->isActive())
+            designVariables.push_back(*it);
+      }
+      writeBinary<uint64_t>(stream, designVariables.size());
+      for (auto it = designVariables.cbegin(); it != designVariables.cend();
+          ++it) {
+        Eigen::MatrixXd parameters;
+        (*it)->getParameters(parameters);
+        writeBinaryMatrix(stream, parameters);
+      }
+
+      // marginal system
+      writeBinaryMatrix(stream, *_nobsBasis);
+      writeBinaryMatrix(stream, *_nobsBasisScaled);
+      writeBinaryMatrix(stream, *_obsBasis);
+      writeBinaryMatrix(stream, *_obsBasisScaled);
+      writeBinaryMatrix(stream, *_sigma2Theta);
+      writeBinaryMatrix(stream, *_sigma2ThetaScaled);
+      writeBinaryMatrix(stream, *_sigma2ThetaObs);
+      writeBinaryMatrix(stream, *_sigma2ThetaObsScaled);
+      writeBinaryMatrix(stream, *_singularValues);
+      writeBinaryMatrix(stream, *_singularValuesScaled);
+      if (!stream)
+        throw BadArgumentException<std::string>(filename,
+          "IncrementalEstimator::saveCheckpoint(): write failed",
+          __FILE__, __LINE__, __PRETTY_FUNCTION__);
+    }
+
+    void IncrementalEstimator::loadCheckpoint(const std::string& filename,
+        const std::vector<boost::shared_ptr<aslam::backend::DesignVariable> >&
+        designVariables) {
+      if (_problem->getNumOptimizationProblems() > 0)
+        throw InvalidOperationException(
+          "IncrementalEstimator::loadCheckpoint(): estimator must be empty",
+          __FILE__, __LINE__, __PRETTY_FUNCTION__);
+      std::ifstream stream(filename.c_str(), std::ios::binary);
+      if (!stream.is_open())
+        throw BadArgumentException<std::string>(filename,
+          "IncrementalEstimator::loadCheckpoint(): cannot open file",
+          __FILE__, __LINE__, __PRETTY_FUNCTION__);
+
+      stream.seekg(0, std::ios::end);
+      const std::streamoff fileSize = stream.tellg();
+      stream.seekg(0, std::ios::beg);
+
+      // header
+      char magic[sizeof(checkpointMagic)];
+      stream.read(magic, sizeof(magic));
+      const uint32_t version = readBinary<uint32_t>(stream);
+      if (!stream || std::memcmp(magic, checkpointMagic, sizeof(magic)) ||
+          version != checkpointVersion)
+        throw BadArgumentException<std::string>(filename,
+          "IncrementalEstimator::loadCheckpoint(): unknown format",
+          __FILE__, __LINE__, __PRETTY_FUNCTION__);
+      if (readBinary<uint64_t>(stream) != checkpointByteOrder)
+        throw BadArgumentException<std::string>(filename,
+          "IncrementalEstimator::loadCheckpoint(): byte order differs from "
+          "this machine", __FILE__, __LINE__, __PRETTY_FUNCTION__);
+      if (readBinary<uint64_t>(stream) != _margGroupId)
+        throw InvalidOperationException(
+          "IncrementalEstimator::loadCheckpoint(): marginalized group ID "
+          "differs from the checkpoint", __FILE__, __LINE__,
+          __PRETTY_FUNCTION__);
+
+      // state of the estimator, committed once the whole file is validated
+      const double informationGain = readBinary<double>(stream);
+      const double svLog2Sum = readBinary<double>(stream);
+      const double svdTolerance = readBinary<double>(stream);
+      const double qrTolerance = readBinary<double>(stream);
+      const double initialCost = readBinary<double>(stream);
+      const double finalCost = readBinary<double>(stream);
+      const int64_t rankTheta = readBinary<int64_t>(stream);
+      const int64_t rankThetaDeficiency = readBinary<int64_t>(stream);
+      const int64_t rankPsi = readBinary<int64_t>(stream);
+      const int64_t rankPsiDeficiency = readBinary<int64_t>(stream);
+
+      // calibration design variables, in the order they were saved
+      const uint64_t numDesignVariables = readBinary<uint64_t>(stream);
+      if (!stream || numDesignVariables != designVariables.size())
+        throw InvalidOperationException(
+          "IncrementalEstimator::loadCheckpoint(): number of design variables "
+          "differs from the checkpoint", __FILE__, __LINE__,
+          __PRETTY_FUNCTION__);
+      std::vector<Eigen::MatrixXd> parameters;
+      parameters.reserve(designVariables.size());
+      Eigen::MatrixXd::Index dim = 0;
+      for (auto it = designVariables.cbegin(); it != designVariables.cend();
+          ++it) {
+        Eigen::MatrixXd current;
+        (*it)->getParameters(current);
+        parameters.push_back(readBinaryMatrix(stream, fileSize));
+        if (!stream || parameters.back().rows() != current.rows() ||
+            parameters.back().cols() != current.cols())
+          throw InvalidOperationException(
+            "IncrementalEstimator::loadCheckpoint(): design variable "
+            "dimensions differ from the checkpoint", __FILE__, __LINE__,
+            __PRETTY_FUNCTION__);
+        dim += (*it)->minimalDimensions();
+      }
+
+      // marginal system
+      const auto readMatrix = [&stream, fileSize]() {
+        return boost::make_shared<const Eigen::MatrixXd>(
+          readBinaryMatrix(stream, fileSize));};
+      const auto readVector = [&stream, fileSize, &filename]() {
+        const Eigen::MatrixXd vector = readBinaryMatrix(stream, fileSize);
+        if (!stream || vector.cols() != 1)
+          throw BadArgumentException<std::string>(filename,
+            "IncrementalEstimator::loadCheckpoint(): malformed vector",
+            __FILE__, __LINE__, __PRETTY_FUNCTION__);
+        return boost::make_shared<const Eigen::VectorXd>(vector);};
+      const MatrixSP nobsBasis = readMatrix();
+      const MatrixSP nobsBasisScaled = readMatrix();
+      const MatrixSP obsBasis = readMatrix();
+      const MatrixSP obsBasisScaled = readMatrix();
+      const MatrixSP sigma2Theta = readMatrix();
+      const MatrixSP sigma2ThetaScaled = readMatrix();
+      const MatrixSP sigma2ThetaObs = readMatrix();
+      const MatrixSP sigma2ThetaObsScaled = readMatrix();
+      const VectorSP singularValues = readVector();
+      const VectorSP singularValuesScaled = readVector();
+      if (!stream)
+        throw BadArgumentException<std::string>(filename,
+          "IncrementalEstimator::loadCheckpoint(): truncated file",
+          __FILE__, __LINE__, __PRETTY_FUNCTION__);
+      if ((obsBasis->size() > 0 && obsBasis->rows() != dim) ||
+          (nobsBasis->size() > 0 && nobsBasis->rows() != dim))
+        throw InvalidOperationException(
+          "IncrementalEstimator::loadCheckpoint(): dimension of theta "
+          "differs from the checkpoint", __FILE__, __LINE__,
+          __PRETTY_FUNCTION__);
+
+      _informationGain = informationGain;
+      _svLog2Sum = svLog2Sum;
+      _svdTolerance = svdTolerance;
+      _qrTolerance = qrTolerance;
+      _initialCost = initialCost;
+      _finalCost = finalCost;
+      _rankTheta = rankTheta;
+      _rankThetaDeficiency = rankThetaDeficiency;
+      _rankPsi = rankPsi;
+      _rankPsiDeficiency = rankPsiDeficiency;
+      for (size_t i = 0; i < designVariables.size(); ++i)
+        designVariables[i]->setParameters(parameters[i]);
+      _nobsBasis = nobsBasis;
+      _nobsBasisScaled = nobsBasisScaled;
+      _obsBasis = obsBasis;
+      _obsBasisScaled = obsBasisScaled;
+      _sigma2Theta = sigma2Theta;
+      _sigma2ThetaScaled = sigma2ThetaScaled;
+      _sigma2ThetaObs = sigma2ThetaObs;
+      _sigma2ThetaObsScaled = sigma2ThetaObsScaled;
+      _singularValues = singularValues;
+      _singularValuesScaled = singularValuesScaled;
+
+      // the marginal information on theta enters the problem as a prior
+      const Eigen::MatrixXd::Index rank = _obsBasis->cols();
+      if (rank == 0 || _singularValues->size() < rank)
+        return;
+      auto prior = boost::make_shared<OptimizationProblem>();
+      std::vector<aslam::backend::DesignVariable*> priorDVs;
+      priorDVs.reserve(designVariables.size());
+      for (auto it = designVariables.cbegin(); it != designVariables.cend();
+          ++it) {
+        prior->addDesignVariable(*it, _margGroupId);
+        priorDVs.push_back(it->get());
+      }
+      const Eigen::MatrixXd R = _singularValues->head(rank).asDiagonal() *
+        _obsBasis->transpose();
+      prior->addErrorTerm(
+        boost::make_shared<aslam::backend::MarginalizationPriorErrorTerm>(
+        priorDVs, Eigen::VectorXd::Zero(rank), R));
+      _problem->add(prior);
+    }
+
     void IncrementalEstimator::removeBatch(size_t idx) {
       // remove the batch
       _problem->remove(idx);
@@ -460,9 +1178,10 @@ namespace aslam {
     }
 
     void IncrementalEstimator::removeBatch(const BatchSP& batch) {
-      auto it = _problem->getOptimizationProblem(batch);
-      if (it != _problem->getOptimizationProblemEnd())
-        removeBatch(std::distance(_problem->getOptimizationProblemBegin(), it));
+      if (_problem->isOptimizationProblemInProblem(batch.get())) {
+        _problem->remove(batch);
+        reoptimize();
+      }
     }
 
     size_t IncrementalEstimator::getNumBatches() const {
@@ -470,6 +1189,8 @@ namespace aslam {
     }
 
     void IncrementalEstimator::orderMarginalizedDesignVariables() {
+      ASLAM_CALIBRATION_PROFILE_PHASE(_profiler,
+        "orderMarginalizedDesignVariables");
       auto groupsOrdering = _problem->getGroupsOrdering();
       auto margGroupIt = std::find(groupsOrdering.begin(),
         groupsOrdering.end(), _margGroupId);
@@ -487,13 +1208,22 @@ namespace aslam {
     }
 
     void IncrementalEstimator::restoreLinearSolver() {
-      // init the matrix structure
+      ASLAM_CALIBRATION_PROFILE_PHASE(_profiler, "restoreLinearSolver");
+
+      // swap back the Jacobian of the last accepted state if available, the
+      // next optimize() re-indexes the design variables and error terms
+      auto linearSolver = _optimizer->getSolver<LinearSolver>();
+      if (linearSolver->restoreJacobianTranspose())
+        return;
+
+      // otherwise restore the indexing of the design variables and error
+      // terms and rebuild the system
       std::vector<aslam::backend::DesignVariable*> dvs;
-      const size_t numDVS = _problem->numDesignVariables();
-      dvs.reserve(numDVS);
+      const auto& orderedDVS = _problem->getOrderedDesignVariables();
+      dvs.reserve(orderedDVS.size());
       size_t columnBase = 0;
-      for (size_t i = 0; i < numDVS; ++i) {
-        aslam::backend::DesignVariable* dv = _problem->designVariable(i);
+      for (auto it = orderedDVS.cbegin(); it != orderedDVS.cend(); ++it) {
+        aslam::backend::DesignVariable* dv = *it;
         if (dv->isActive()) {
           dvs.push_back(dv);
           dv->setBlockIndex(dvs.size() - 1);
@@ -511,12 +1241,532 @@ namespace aslam {
         dim += et->dimension();
         ets.push_back(et);
       }
-      auto linearSolver = _optimizer->getSolver<LinearSolver>();
       linearSolver->initMatrixStructure(dvs, ets, false);
-
-      // build the system
       linearSolver->buildSystem(_optimizer->options().numThreadsJacobian, true);
     }
 
+    bool IncrementalEstimator::getBatchFactor(OptimizationProblem* batch,
+        Eigen::MatrixXd& factor, std::ptrdiff_t& rankPsi,
+        std::ptrdiff_t& rankPsiDeficiency) const {
+      // a marginal system and the marginalized group are required
+      if (_problem->getNumOptimizationProblems() == 0 || _rankTheta <= 0 ||
+          !_problem->isGroupInProblem(_margGroupId))
+        return false;
+
+      // column offsets of theta in the current marginal system
+      std::unordered_map<const aslam::backend::DesignVariable*, size_t>
+        thetaOffsets;
+      const auto& thetaDVs = _problem->getDesignVariablesGroup(_margGroupId);
+      size_t thetaDim = 0;
+      int thetaBlockIndexMax = -1;
+      for (auto it = thetaDVs.cbegin(); it != thetaDVs.cend(); ++it)
+        if ((*it)->isActive()) {
+          thetaOffsets[*it] = thetaDim;
+          thetaDim += (*it)->minimalDimensions();
+          thetaBlockIndexMax = std::max(thetaBlockIndexMax,
+            (*it)->blockIndex());
+        }
+      if (_obsBasis->rows() == 0 || static_cast<size_t>(_obsBasis->rows()) !=
+          thetaDim || _singularValues->size() < _obsBasis->cols())
+        return false;
+
+      // column offsets of the nuisance variables, the Jacobian container
+      // orders design variables by block index: theta keeps its indices
+      // from the last optimization, the other variables get temporary ones
+      const auto& batchDVs = batch->getOrderedDesignVariables();
+      std::unordered_map<const aslam::backend::DesignVariable*, size_t>
+        psiOffsets;
+      std::vector<std::pair<aslam::backend::DesignVariable*, int> >
+        blockIndices;
+      size_t psiDim = 0;
+      for (auto it = batchDVs.cbegin(); it != batchDVs.cend(); ++it) {
+        if (thetaOffsets.count(*it))
+          continue;
+        if ((*it)->isActive()) {
+          // theta variables unknown to the marginal system
+          if (batch->isGroupInProblem(_margGroupId) &&
+              batch->getGroupId(*it) == _margGroupId)
+            return false;
+          psiOffsets[*it] = psiDim;
+          psiDim += (*it)->minimalDimensions();
+        }
+        blockIndices.push_back(std::make_pair(*it, (*it)->blockIndex()));
+      }
+      // a rejected batch may have left theta with larger indices
+      const size_t blockIndexBase = std::max(_problem->numDesignVariables(),
+        static_cast<size_t>(thetaBlockIndexMax + 1));
+      for (size_t i = 0; i < blockIndices.size(); ++i)
+        blockIndices[i].first->setBlockIndex(blockIndexBase + i);
+
+      // linearize the batch at the current estimate
+      const size_t numErrorTerms = batch->numErrorTerms();
+      size_t rows = 0;
+      for (size_t i = 0; i < numErrorTerms; ++i)
+        rows += batch->errorTerm(i)->dimension();
+      Eigen::MatrixXd JTheta = Eigen::MatrixXd::Zero(rows, thetaDim);
+      Eigen::MatrixXd JPsi = Eigen::MatrixXd::Zero(rows, psiDim);
+      size_t row = 0;
+      for (size_t i = 0; i < numErrorTerms; ++i) {
+        aslam::backend::ErrorTerm* errorTerm = batch->errorTerm(i);
+        const size_t dim = errorTerm->dimension();
+        aslam::backend::JacobianContainer jc(dim);
+        errorTerm->evaluateError();
+        errorTerm->getWeightedJacobians(jc, true);
+        for (auto it = jc.begin(); it != jc.end(); ++it) {
+          auto thetaIt = thetaOffsets.find(it->first);
+          if (thetaIt != thetaOffsets.end())
+            JTheta.block(row, thetaIt->second, dim, it->second.cols()) +=
+              it->second;
+          auto psiIt = psiOffsets.find(it->first);
+          if (psiIt != psiOffsets.end())
+            JPsi.block(row, psiIt->second, dim, it->second.cols()) +=
+              it->second;
+        }
+        row += dim;
+      }
+      for (auto it = blockIndices.cbegin(); it != blockIndices.cend(); ++it)
+        it->first->setBlockIndex(it->second);
+
+      // eliminate the nuisance variables of the batch
+      Eigen::MatrixXd reduced;
+      if (psiDim > 0) {
+        const Eigen::ColPivHouseholderQR<Eigen::MatrixXd> qr(JPsi);
+        const Eigen::MatrixXd QtJTheta = qr.householderQ().transpose() * JTheta;
+        rankPsi = qr.rank();
+        reduced = QtJTheta.bottomRows(rows - rankPsi);
+      }
+      else {
+        rankPsi = 0;
+        reduced = JTheta;
+      }
+      rankPsiDeficiency = psiDim - rankPsi;
+
+      // compress the reduced rows to a triangle
+      if (static_cast<size_t>(reduced.rows()) > thetaDim) {
+        const Eigen::HouseholderQR<Eigen::MatrixXd> qr(reduced);
+        factor = qr.matrixQR().topRows(thetaDim).
+          triangularView<Eigen::Upper>();
+      }
+      else
+        factor = reduced;
+      return true;
+    }
+
+    bool IncrementalEstimator::getBatchInformation(OptimizationProblem* batch,
+        Eigen::MatrixXd& information) const {
+      Eigen::MatrixXd factor;
+      std::ptrdiff_t rankPsi, rankPsiDeficiency;
+      if (!getBatchFactor(batch, factor, rankPsi, rankPsiDeficiency))
+        return false;
+      information = factor.transpose() * factor;
+      return true;
+    }
+
+    bool IncrementalEstimator::updateMarginal(OptimizationProblem* batch,
+        ReturnValue& ret, double& svLog2Sum) const {
+      Eigen::MatrixXd batchFactor;
+      std::ptrdiff_t rankPsi, rankPsiDeficiency;
+      if (!getBatchFactor(batch, batchFactor, rankPsi, rankPsiDeficiency))
+        return false;
+
+      // stack the factor of the last analysis, Sigma * V^T, with the batch
+      // and re-triangularize with Householder reflections
+      const Eigen::MatrixXd::Index rank = _obsBasis->cols();
+      const Eigen::MatrixXd::Index thetaDim = _obsBasis->rows();
+      Eigen::MatrixXd stacked(rank + batchFactor.rows(), thetaDim);
+      stacked.topRows(rank) = _singularValues->head(rank).asDiagonal() *
+        _obsBasis->transpose();
+      stacked.bottomRows(batchFactor.rows()) = batchFactor;
+      const Eigen::HouseholderQR<Eigen::MatrixXd> qr(stacked);
+      const Eigen::MatrixXd R = qr.matrixQR().topRows(
+        std::min(stacked.rows(), thetaDim)).triangularView<Eigen::Upper>();
+
+      // analyze the updated factor as the linear solver would
+      aslam::backend::MarginalSvd svd;
+      aslam::backend::computeMarginalSvd(R,
+        _optimizer->getSolver<LinearSolver>()->getMarginalSvdBackend(), false,
+        &svd);
+      Eigen::VectorXd singularValues = Eigen::VectorXd::Zero(thetaDim);
+      singularValues.head(svd.singular_values.size()) = svd.singular_values;
+      const Eigen::MatrixXd& V = svd.V;
+      std::ptrdiff_t rankTheta = 0;
+      svLog2Sum = 0.0;
+      while (rankTheta < thetaDim &&
+          singularValues(rankTheta) > _svdTolerance)
+        svLog2Sum += std::log2(singularValues(rankTheta++));
+      const Eigen::VectorXd sigma2 = singularValues.head(rankTheta).array().
+        square().inverse().matrix();
+
+      // fill the statistics and the requested quantities
+      ret.rankPsi = _rankPsi + rankPsi;
+      ret.rankPsiDeficiency = _rankPsiDeficiency + rankPsiDeficiency;
+      ret.rankTheta = rankTheta;
+      ret.rankThetaDeficiency = thetaDim - rankTheta;
+      ret.svdTolerance = _svdTolerance;
+      ret.qrTolerance = _qrTolerance;
+      const unsigned int outputs = _options.outputs;
+      ret.singularValues = outputs & OutputSingularValues ?
+        boost::make_shared<const Eigen::VectorXd>(singularValues) :
+        getEmptyVector();
+      ret.nobsBasis = outputs & OutputNobsBasis ?
+        boost::make_shared<const Eigen::MatrixXd>(
+        V.rightCols(thetaDim - rankTheta)) : getEmptyMatrix();
+      ret.obsBasis = outputs & OutputObsBasis ?
+        boost::make_shared<const Eigen::MatrixXd>(V.leftCols(rankTheta)) :
+        getEmptyMatrix();
+      ret.sigma2Theta = outputs & OutputSigma2Theta ?
+        boost::make_shared<const Eigen::MatrixXd>(V.leftCols(rankTheta) *
+        sigma2.asDiagonal() * V.leftCols(rankTheta).transpose()) :
+        getEmptyMatrix();
+      ret.sigma2ThetaObs = outputs & OutputSigma2ThetaObs ?
+        boost::make_shared<const Eigen::MatrixXd>(sigma2.asDiagonal()) :
+        getEmptyMatrix();
+      return true;
+    }
+
+    Eigen::MatrixXd IncrementalEstimator::getMarginalInformation() const {
+      const Eigen::MatrixXd::Index rank = _obsBasis->cols();
+      return *_obsBasis * _singularValues->head(rank).array().square().
+        matrix().asDiagonal() * _obsBasis->transpose();
+    }
+
+    Eigen::MatrixXd IncrementalEstimator::getSigma2ThetaFactor(bool scaled)
+        const {
+      const unsigned int required = OutputObsBasis | OutputSingularValues |
+        (scaled ? OutputScaled : 0);
+      if ((_options.outputs & required) != required)
+        throw InvalidOperationException(
+          "IncrementalEstimator::getSigma2ThetaFactor(): the observable basis "
+          "and the singular values must be reported", __FILE__, __LINE__,
+          __PRETTY_FUNCTION__);
+      const Eigen::MatrixXd& obsBasis = getObsBasis(scaled);
+      return obsBasis * getSingularValues(scaled).head(obsBasis.cols()).
+        cwiseInverse().asDiagonal();
+    }
+
+    double IncrementalEstimator::getSingularValuesLog2Sum(const
+        Eigen::MatrixXd& information, std::ptrdiff_t& rankTheta) const {
+      const Eigen::SelfAdjointEigenSolver<Eigen::MatrixXd> es(information,
+        Eigen::EigenvaluesOnly);
+      double svLog2Sum = 0.0;
+      rankTheta = 0;
+      for (Eigen::MatrixXd::Index i = 0; i < es.eigenvalues().size(); ++i) {
+        const double sv = std::sqrt(std::max(es.eigenvalues()(i), 0.0));
+        if (sv > _svdTolerance) {
+          svLog2Sum += std::log2(sv);
+          rankTheta++;
+        }
+      }
+      return svLog2Sum;
+    }
+
+    bool IncrementalEstimator::estimateInformationGain(const BatchSP& batch,
+        double& informationGain, std::ptrdiff_t& rankTheta) const {
+      Eigen::MatrixXd information;
+      if (!getBatchInformation(batch.get(), information))
+        return false;
+      information += getMarginalInformation();
+      informationGain = 0.5 * (getSingularValuesLog2Sum(information,
+        rankTheta) - _svLog2Sum);
+      return true;
+    }
+
+    void IncrementalEstimator::checkOptions() const {
+      // the eviction scores the batches against the marginal system
+      const unsigned int required = OutputObsBasis | OutputSingularValues;
+      if ((_options.maxNumBatches > 0 || _options.maxMemoryUsage > 0) &&
+          (_options.outputs & required) != required)
+        throw BadArgumentException<unsigned int>(_options.outputs,
+          "IncrementalEstimator::checkOptions(): bounding the problem requires "
+          "the observable basis and the singular values in the outputs",
+          __FILE__, __LINE__, __PRETTY_FUNCTION__);
+    }
+
+    bool IncrementalEstimator::isBoundExceeded() const {
+      return (_options.maxNumBatches > 0 &&
+        _problem->getNumOptimizationProblems() > _options.maxNumBatches) ||
+        (_options.maxMemoryUsage > 0 &&
+        _memoryUsage > _options.maxMemoryUsage);
+    }
+
+    size_t IncrementalEstimator::evictBatches(
+        const std::vector<BatchSP>& batches) {
+      // the options may have changed since the construction
+      const unsigned int required = OutputObsBasis | OutputSingularValues;
+      if ((_options.outputs & required) != required)
+        throw InvalidOperationException(
+          "IncrementalEstimator::evictBatches(): the observable basis and the "
+          "singular values must be reported", __FILE__, __LINE__,
+          __PRETTY_FUNCTION__);
+      size_t numEvicted = 0;
+      // a single round is enough unless the memory estimate falls short
+      while (isBoundExceeded() && _problem->getNumOptimizationProblems() > 1) {
+        // score each batch once by the information it contributes to the
+        // marginal system, and weigh its memory by its number of rows
+        struct Candidate {
+          size_t idx;
+          double information;
+          size_t rows;
+          Eigen::MatrixXd batchInformation;
+        };
+        std::vector<Candidate> candidates;
+        const size_t numBatches = _problem->getNumOptimizationProblems();
+        candidates.reserve(numBatches);
+        const Eigen::MatrixXd information = getMarginalInformation();
+        size_t totalRows = 0;
+        for (size_t i = 0; i < numBatches; ++i) {
+          OptimizationProblem* candidate = _problem->getOptimizationProblem(i);
+          size_t rows = 0;
+          const size_t numErrorTerms = candidate->numErrorTerms();
+          for (size_t j = 0; j < numErrorTerms; ++j)
+            rows += candidate->errorTerm(j)->dimension();
+          totalRows += rows;
+          if (std::find_if(batches.cbegin(), batches.cend(),
+              [candidate](const BatchSP& batch) {
+              return batch.get() == candidate;}) != batches.cend())
+            continue;
+          Candidate c;
+          c.idx = i;
+          c.rows = rows;
+          if (!getBatchInformation(candidate, c.batchInformation))
+            continue;
+          std::ptrdiff_t rankTheta;
+          const double svLog2Sum = getSingularValuesLog2Sum(information -
+            c.batchInformation, rankTheta);
+          if (rankTheta < _rankTheta)
+            continue;
+          c.information = 0.5 * (_svLog2Sum - svLog2Sum);
+          candidates.push_back(std::move(c));
+        }
+        std::sort(candidates.begin(), candidates.end(),
+          [](const Candidate& lhs, const Candidate& rhs) {
+          return lhs.information < rhs.information;});
+
+        // number of batches and rows to drop for the bounds
+        const size_t numBatchesExcess = _options.maxNumBatches > 0 &&
+          numBatches > _options.maxNumBatches ?
+          numBatches - _options.maxNumBatches : 0;
+        const size_t rowsExcess = _options.maxMemoryUsage > 0 &&
+          _memoryUsage > _options.maxMemoryUsage ? static_cast<size_t>(
+          std::ceil(static_cast<double>(_memoryUsage -
+          _options.maxMemoryUsage) / _memoryUsage * totalRows)) : 0;
+
+        // least informative first, as long as theta keeps its rank
+        std::vector<size_t> evictIdx;
+        Eigen::MatrixXd remainingInformation = information;
+        size_t evictedRows = 0;
+        for (auto it = candidates.cbegin(); it != candidates.cend() &&
+            (evictIdx.size() < numBatchesExcess || evictedRows < rowsExcess) &&
+            numBatches - evictIdx.size() > 1; ++it) {
+          std::ptrdiff_t rankTheta;
+          getSingularValuesLog2Sum(remainingInformation -
+            it->batchInformation, rankTheta);
+          if (rankTheta < _rankTheta)
+            continue;
+          remainingInformation -= it->batchInformation;
+          evictedRows += it->rows;
+          evictIdx.push_back(it->idx);
+        }
+        if (evictIdx.empty())
+          break;
+
+        // remove the batches from the back and re-estimate once
+        const size_t memoryUsage = _memoryUsage;
+        std::sort(evictIdx.begin(), evictIdx.end());
+        for (auto it = evictIdx.crbegin(); it != evictIdx.crend(); ++it)
+          _problem->remove(*it);
+        reoptimize();
+        numEvicted += evictIdx.size();
+        if (_options.verbose)
+          std::cout << "IncrementalEstimator::evictBatches(): evicted "
+            << evictIdx.size() << " batches, memory usage " << memoryUsage
+            << " -> " << _memoryUsage << " bytes" << std::endl;
+      }
+      return numEvicted;
+    }
+
+    IncrementalEstimator::TrustRegionPolicySP
+        IncrementalEstimator::createTrustRegionPolicy(TrustRegion trustRegion,
+        LinearSolver& linearSolver) {
+      // only the Gauss-Newton steps do without J^T e
+      linearSolver.setGradientRequired(trustRegion != TrustRegion::GaussNewton);
+      switch (trustRegion) {
+        case TrustRegion::LevenbergMarquardt:
+          return boost::make_shared<
+            aslam::backend::LevenbergMarquardtTrustRegionPolicy>();
+        case TrustRegion::DogLeg:
+          return boost::make_shared<aslam::backend::DogLegTrustRegionPolicy>();
+        default:
+          return boost::make_shared<
+            aslam::backend::GaussNewtonTrustRegionPolicy>();
+      }
+    }
+
+    const IncrementalEstimator::MatrixSP&
+        IncrementalEstimator::getEmptyMatrix() {
+      static const MatrixSP emptyMatrix =
+        boost::make_shared<const Eigen::MatrixXd>();
+      return emptyMatrix;
+    }
+
+    const IncrementalEstimator::VectorSP&
+        IncrementalEstimator::getEmptyVector() {
+      static const VectorSP emptyVector =
+        boost::make_shared<const Eigen::VectorXd>();
+      return emptyVector;
+    }
+
+    void IncrementalEstimator::computeScaledOutputs(ReturnValue& ret) const {
+      auto linearSolver = _optimizer->getSolver<LinearSolver>();
+      const bool scaled = linearSolver->getOptions().columnScaling &&
+        (_options.outputs & OutputScaled);
+      const unsigned int outputs = scaled ? _options.outputs : 0;
+      if (scaled)
+        linearSolver->analyzeScaledSystem();
+      ret.singularValuesScaled = outputs & OutputSingularValues ?
+        boost::make_shared<const Eigen::VectorXd>(
+        linearSolver->getSingularValues()) : getEmptyVector();
+      ret.nobsBasisScaled = outputs & OutputNobsBasis ?
+        boost::make_shared<const Eigen::MatrixXd>(
+        linearSolver->getNullSpace()) : getEmptyMatrix();
+      ret.obsBasisScaled = outputs & OutputObsBasis ?
+        boost::make_shared<const Eigen::MatrixXd>(
+        linearSolver->getRowSpace()) : getEmptyMatrix();
+      ret.sigma2ThetaScaled = outputs & OutputSigma2Theta ?
+        boost::make_shared<const Eigen::MatrixXd>(
+        linearSolver->getCovariance()) : getEmptyMatrix();
+      ret.sigma2ThetaObsScaled = outputs & OutputSigma2ThetaObs ?
+        boost::make_shared<const Eigen::MatrixXd>(
+        linearSolver->getRowSpaceCovariance()) : getEmptyMatrix();
+    }
+
+    void IncrementalEstimator::computeOutputs(ReturnValue& ret) const {
+      auto linearSolver = _optimizer->getSolver<LinearSolver>();
+      const unsigned int outputs = _options.outputs;
+      ret.singularValues = outputs & OutputSingularValues ?
+        boost::make_shared<const Eigen::VectorXd>(
+        linearSolver->getSingularValues()) : getEmptyVector();
+      ret.nobsBasis = outputs & OutputNobsBasis ?
+        boost::make_shared<const Eigen::MatrixXd>(
+        linearSolver->getNullSpace()) : getEmptyMatrix();
+      ret.obsBasis = outputs & OutputObsBasis ?
+        boost::make_shared<const Eigen::MatrixXd>(
+        linearSolver->getRowSpace()) : getEmptyMatrix();
+      ret.sigma2Theta = outputs & OutputSigma2Theta ?
+        boost::make_shared<const Eigen::MatrixXd>(
+        linearSolver->getCovariance()) : getEmptyMatrix();
+      ret.sigma2ThetaObs = outputs & OutputSigma2ThetaObs ?
+        boost::make_shared<const Eigen::MatrixXd>(
+        linearSolver->getRowSpaceCovariance()) : getEmptyMatrix();
+    }
+
+    IncrementalEstimator::ReturnValue
+        IncrementalEstimator::getRejectedReturnValue() const {
+      ReturnValue ret;
+      ret.batchAccepted = false;
+      ret.batchScreened = false;
+      ret.batchDropped = false;
+      ret.marginalApproximate = _numIncrementalUpdates > 0;
+      ret.informationGain = 0.0;
+      ret.rankPsi = _rankPsi;
+      ret.rankPsiDeficiency = _rankPsiDeficiency;
+      ret.rankTheta = _rankTheta;
+      ret.rankThetaDeficiency = _rankThetaDeficiency;
+      ret.svdTolerance = _svdTolerance;
+      ret.qrTolerance = _qrTolerance;
+      ret.nobsBasis = _nobsBasis;
+      ret.nobsBasisScaled = _nobsBasisScaled;
+      ret.obsBasis = _obsBasis;
+      ret.obsBasisScaled = _obsBasisScaled;
+      ret.sigma2Theta = _sigma2Theta;
+      ret.sigma2ThetaScaled = _sigma2ThetaScaled;
+      ret.sigma2ThetaObs = _sigma2ThetaObs;
+      ret.sigma2ThetaObsScaled = _sigma2ThetaObsScaled;
+      ret.singularValues = _singularValues;
+      ret.singularValuesScaled = _singularValuesScaled;
+      ret.numEvictedBatches = 0;
+      ret.memoryUsageBeforeEviction = _memoryUsage;
+      ret.memoryUsageAfterEviction = _memoryUsage;
+      ret.numIterations = 0;
+      ret.JStart = _finalCost;
+      ret.JFinal = _finalCost;
+      ret.elapsedTime = 0.0;
+      return ret;
+    }
+
+    IncrementalEstimator::ReturnValue
+        IncrementalEstimator::getDroppedReturnValue() {
+      ReturnValue ret = ReturnValue();
+      ret.batchAccepted = false;
+      ret.batchScreened = false;
+      ret.batchDropped = true;
+      ret.marginalApproximate = false;
+      ret.nobsBasis = getEmptyMatrix();
+      ret.nobsBasisScaled = getEmptyMatrix();
+      ret.obsBasis = getEmptyMatrix();
+      ret.obsBasisScaled = getEmptyMatrix();
+      ret.sigma2Theta = getEmptyMatrix();
+      ret.sigma2ThetaScaled = getEmptyMatrix();
+      ret.sigma2ThetaObs = getEmptyMatrix();
+      ret.sigma2ThetaObsScaled = getEmptyMatrix();
+      ret.singularValues = getEmptyVector();
+      ret.singularValuesScaled = getEmptyVector();
+      ret.rankPsi = -1;
+      ret.rankPsiDeficiency = -1;
+      ret.rankTheta = -1;
+      ret.rankThetaDeficiency = -1;
+      return ret;
+    }
+
+    void IncrementalEstimator::processBatches() {
+      std::unique_lock<std::mutex> lock(_queueMutex);
+      while (true) {
+        _queueNotEmpty.wait(lock, [this]() {
+          return _stopWorker || !_batchQueue.empty();});
+        if (_stopWorker)
+          break;
+        QueuedBatch queuedBatch = std::move(_batchQueue.front());
+        _batchQueue.pop_front();
+        _processingBatch = true;
+        lock.unlock();
+        _queueNotFull.notify_one();
+
+        // the estimator is only touched by the worker while it runs
+        try {
+          const ReturnValue ret = addBatch(queuedBatch.batch,
+            queuedBatch.force);
+          queuedBatch.result.set_value(ret);
+        }
+        catch (...) {
+          queuedBatch.result.set_exception(std::current_exception());
+        }
+        const double latency = std::chrono::duration<double>(
+          std::chrono::steady_clock::now() - queuedBatch.submitTime).count();
+
+        lock.lock();
+        _queueStatistics.numProcessed++;
+        _queueStatistics.maxLatency = std::max(_queueStatistics.maxLatency,
+          latency);
+        _totalLatency += latency;
+        _processingBatch = false;
+        _batchProcessed.notify_all();
+      }
+    }
+
+    void IncrementalEstimator::recordSolverPhases(const LinearSolver::Timings&
+        timings) {
+      // the solver accumulates its phases, report them as ending now
+      const LinearSolver::Timings& current =
+        _optimizer->getSolver<LinearSolver>()->getTimings();
+      const double now = Profiler::now();
+      const double buildSystem = current.build_system - timings.build_system;
+      const double solveSystem = current.solve_system - timings.solve_system;
+      if (current.num_build_system > timings.num_build_system)
+        _profiler.record("buildSystem", now - buildSystem - solveSystem,
+          buildSystem);
+      if (current.num_solve_system > timings.num_solve_system)
+        _profiler.record("solveSystem", now - solveSystem, solveSystem);
+    }
+
   }
 }
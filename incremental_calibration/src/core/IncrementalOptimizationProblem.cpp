@@ -9,6 +9,7 @@
 #include <utility>
 #include <unordered_set>
 #include <iterator>
+#include <limits>
 
 #include <aslam/backend/DesignVariable.hpp>
 
@@ -25,7 +26,11 @@ namespace aslam {
 /* Constructors and Destructor                                                */
 /******************************************************************************/
 
-    IncrementalOptimizationProblem::IncrementalOptimizationProblem() {
+    IncrementalOptimizationProblem::IncrementalOptimizationProblem() :
+        _numRemovedOptimizationProblems(0),
+        _totalDim(0),
+        _numErrorTerms(0),
+        _numRemovalSteps(0) {
     }
 
     IncrementalOptimizationProblem::~IncrementalOptimizationProblem() {
@@ -36,43 +41,43 @@ namespace aslam {
 /******************************************************************************/
 
     size_t IncrementalOptimizationProblem::getNumOptimizationProblems() const {
-      return _optimizationProblems.size();
-    }
-
-    const OptimizationProblem*
-        IncrementalOptimizationProblem::getOptimizationProblem(
-        const OptimizationProblemsSPCIt& problemIt) const {
-      const size_t idx =
-        std::distance(_optimizationProblems.cbegin(), problemIt);
-      if (idx >= _optimizationProblems.size())
-        throw OutOfBoundException<size_t>(idx, _optimizationProblems.size(),
-          "index out of bounds", __FILE__, __LINE__, __PRETTY_FUNCTION__);
-      return _optimizationProblems.at(idx).get();
+      return _optimizationProblems.size() - _numRemovedOptimizationProblems;
     }
 
     OptimizationProblem* IncrementalOptimizationProblem::getOptimizationProblem(
         const OptimizationProblemsSPIt& problemIt) {
-      const size_t idx =
+      const size_t slot =
         std::distance(_optimizationProblems.begin(), problemIt);
-      if (idx >= _optimizationProblems.size())
-        throw OutOfBoundException<size_t>(idx, _optimizationProblems.size(),
+      if (slot >= _optimizationProblems.size() || !_optimizationProblems[slot])
+        throw OutOfBoundException<size_t>(slot, _optimizationProblems.size(),
           "index out of bounds", __FILE__, __LINE__, __PRETTY_FUNCTION__);
-      return _optimizationProblems.at(idx).get();
+      return _optimizationProblems[slot].get();
     }
 
     const OptimizationProblem* IncrementalOptimizationProblem::
         getOptimizationProblem(size_t idx) const {
-      return getOptimizationProblem(_optimizationProblems.cbegin() + idx);
+      return _optimizationProblems[getOptimizationProblemSlot(idx)].get();
     }
 
     OptimizationProblem* IncrementalOptimizationProblem::
         getOptimizationProblem(size_t idx) {
-      return getOptimizationProblem(_optimizationProblems.begin() + idx);
+      return _optimizationProblems[getOptimizationProblemSlot(idx)].get();
     }
 
-    const IncrementalOptimizationProblem::OptimizationProblemsSP&
+    IncrementalOptimizationProblem::OptimizationProblemsSP
         IncrementalOptimizationProblem::getOptimizationProblems() const {
-      return _optimizationProblems;
+      OptimizationProblemsSP problems;
+      problems.reserve(getNumOptimizationProblems());
+      for (auto it = _optimizationProblems.cbegin();
+          it != _optimizationProblems.cend(); ++it)
+        if (*it)
+          problems.push_back(*it);
+      return problems;
+    }
+
+    bool IncrementalOptimizationProblem::isOptimizationProblemInProblem(
+        const OptimizationProblem* problem) const {
+      return _optimizationProblemsIdx.count(problem);
     }
 
     bool IncrementalOptimizationProblem::
@@ -82,34 +87,38 @@ namespace aslam {
 
     bool IncrementalOptimizationProblem::isErrorTermInProblem(const ErrorTerm*
         errorTerm) const {
-      for (auto it = _optimizationProblems.cbegin();
-          it != _optimizationProblems.cend(); ++it)
-        if ((*it)->isErrorTermInProblem(errorTerm))
-          return true;
-      return false;
+      return _errorTermsBatches.count(errorTerm);
     }
 
-    const IncrementalOptimizationProblem::DesignVariablePGroups&
+    IncrementalOptimizationProblem::DesignVariablePGroups
         IncrementalOptimizationProblem::getDesignVariablesGroups() const {
-      return _designVariables;
+      DesignVariablePGroups groups;
+      for (auto it = _designVariables.cbegin(); it != _designVariables.cend();
+          ++it)
+        groups.insert(std::make_pair(it->first,
+          getDesignVariablesGroup(it->first)));
+      return groups;
     }
 
-    const IncrementalOptimizationProblem::DesignVariablesP&
+    IncrementalOptimizationProblem::DesignVariablesP
         IncrementalOptimizationProblem::
         getDesignVariablesGroup(size_t groupId) const {
-      if (isGroupInProblem(groupId))
-        return _designVariables.at(groupId);
-      else
+      if (!isGroupInProblem(groupId))
         throw OutOfBoundException<size_t>(groupId, "unknown group",
           __FILE__, __LINE__, __PRETTY_FUNCTION__);
+      const DesignVariablesGroup& group = _designVariables.at(groupId);
+      DesignVariablesP designVariables;
+      designVariables.reserve(group.slots.size() - group.numRemoved);
+      for (auto it = group.slots.cbegin(); it != group.slots.cend(); ++it)
+        if (*it)
+          designVariables.push_back(*it);
+      return designVariables;
     }
 
     const IncrementalOptimizationProblem::ErrorTermsSP&
         IncrementalOptimizationProblem::getErrorTerms(size_t idx) const {
-      if (idx >= _optimizationProblems.size())
-        throw OutOfBoundException<size_t>(idx, _optimizationProblems.size(),
-          "index out of bounds", __FILE__, __LINE__, __PRETTY_FUNCTION__);
-      return _optimizationProblems.at(idx)->getErrorTerms();
+      return _optimizationProblems[getOptimizationProblemSlot(idx)]->
+        getErrorTerms();
     }
 
     size_t IncrementalOptimizationProblem::getNumGroups() const {
@@ -134,6 +143,7 @@ namespace aslam {
         groupsLookup.insert(*it);
       }
       _groupsOrdering = groupsOrdering;
+      updateGroupsOffsets();
     }
 
     const std::vector<size_t>&
@@ -141,24 +151,38 @@ namespace aslam {
       return _groupsOrdering;
     }
 
+    IncrementalOptimizationProblem::OrderedDesignVariablesP
+        IncrementalOptimizationProblem::getOrderedDesignVariables() const {
+      OrderedDesignVariablesP designVariables;
+      designVariables.reserve(_designVariablesCounts.size());
+      for (auto it = _orderedGroups.cbegin(); it != _orderedGroups.cend();
+          ++it)
+        for (auto dvIt = (*it)->slots.cbegin(); dvIt != (*it)->slots.cend();
+            ++dvIt)
+          if (*dvIt)
+            designVariables.push_back(const_cast<DesignVariable*>(*dvIt));
+      return designVariables;
+    }
+
     size_t IncrementalOptimizationProblem::
         getGroupId(const DesignVariable* designVariable) const {
       if (isDesignVariableInProblem(designVariable))
-        return _designVariablesCounts.at(designVariable).second;
+        return _designVariablesCounts.at(designVariable).groupId;
       else
         throw InvalidOperationException("design variable is not in the problem",
            __FILE__, __LINE__, __PRETTY_FUNCTION__);
     }
 
     size_t IncrementalOptimizationProblem::getGroupDim(size_t groupId) const {
-      const DesignVariablesP& designVariables =
-        getDesignVariablesGroup(groupId);
-      size_t dim = 0;
-      for (auto it = designVariables.cbegin(); it != designVariables.cend();
-          ++it)
-        if ((*it)->isActive())
-          dim += (*it)->minimalDimensions();
-      return dim;
+      if (isGroupInProblem(groupId))
+        return _groupsDims.at(groupId);
+      else
+        throw OutOfBoundException<size_t>(groupId, "unknown group",
+          __FILE__, __LINE__, __PRETTY_FUNCTION__);
+    }
+
+    size_t IncrementalOptimizationProblem::getTotalDim() const {
+      return _totalDim;
     }
 
     bool IncrementalOptimizationProblem::
@@ -166,6 +190,10 @@ namespace aslam {
       return _designVariables.count(groupId);
     }
 
+    size_t IncrementalOptimizationProblem::getNumRemovalSteps() const {
+      return _numRemovalSteps;
+    }
+
 /******************************************************************************/
 /* Methods                                                                    */
 /******************************************************************************/
@@ -175,88 +203,222 @@ namespace aslam {
       if (!problem)
         throw NullPointerException("problem", __FILE__, __LINE__,
           __PRETTY_FUNCTION__);
+
+      // check that the error terms of this problem are new
+      const size_t numET = problem->numErrorTerms();
+      for (size_t i = 0; i < numET; ++i) {
+        const ErrorTerm* et = problem->errorTerm(i);
+        if (isErrorTermInProblem(et))
+          throw InvalidOperationException("error term already in the problem",
+            __FILE__, __LINE__, __PRETTY_FUNCTION__);
+      }
+
       // update design variable counts, grouping, and storing
       const size_t numDV = problem->numDesignVariables();
       _designVariablesCounts.reserve(_designVariablesCounts.size() + numDV);
       for (size_t i = 0; i < numDV; ++i) {
         const DesignVariable* dv = problem->designVariable(i);
         const size_t groupId = problem->getGroupId(dv);
-        if (!isGroupInProblem(groupId))
+        if (!isGroupInProblem(groupId)) {
+          _groupsPositions.insert(std::make_pair(groupId,
+            _groupsOrdering.size()));
           _groupsOrdering.push_back(groupId);
-        if (!isDesignVariableInProblem(dv)) {
+          _orderedGroups.push_back(&_designVariables[groupId]);
+          _groupsOffsets.push_back(_designVariablesCounts.size());
+        }
+        auto infoIt = _designVariablesCounts.find(dv);
+        if (infoIt == _designVariablesCounts.end()) {
+          DesignVariablesGroup& group = _designVariables[groupId];
+          const size_t dim = dv->isActive() ? dv->minimalDimensions() : 0;
           _designVariablesCounts.insert(std::make_pair(dv,
-            std::make_pair(1, groupId)));
-          _designVariables[groupId].push_back(dv);
+            DesignVariableInfo{1, groupId, group.slots.size(), dim,
+            std::numeric_limits<size_t>::max()}));
+          group.slots.push_back(dv);
+          group.live.pushBack(1);
+          _groupsDims[groupId] += dim;
+          _totalDim += dim;
+
+          // append to its group and shift the offsets of the following groups
+          for (size_t j = _groupsPositions.at(groupId) + 1;
+              j < _groupsOffsets.size(); ++j)
+            _groupsOffsets[j]++;
         }
         else {
-          if (getGroupId(dv) != groupId)
+          if (infoIt->second.groupId != groupId)
             throw InvalidOperationException("group mismatch", __FILE__,
               __LINE__, __PRETTY_FUNCTION__);
-          _designVariablesCounts[dv].first++;
+#ifndef NDEBUG
+          checkDesignVariableDim(dv, infoIt->second);
+#endif
+          infoIt->second.count++;
         }
       }
 
       // keep trace of the error terms of this problem
-      const size_t numET = problem->numErrorTerms();
-      for (size_t i = 0; i < numET; ++i) {
-        const ErrorTerm* et = problem->errorTerm(i);
-        if (isErrorTermInProblem(et))
-          throw InvalidOperationException("error term already in the problem",
-            __FILE__, __LINE__, __PRETTY_FUNCTION__);
-      }
+      _errorTermsBatches.reserve(_errorTermsBatches.size() + numET);
+      for (size_t i = 0; i < numET; ++i)
+        _errorTermsBatches.insert(std::make_pair(problem->errorTerm(i),
+          problem.get()));
 
-      // insert the problem
+      // insert the problem in a new slot
+      _optimizationProblemsIdx[problem.get()] = _optimizationProblems.size();
       _optimizationProblems.push_back(problem);
+      _optimizationProblemsLive.pushBack(1);
+      _errorTermsCounts.pushBack(numET);
+      _numErrorTerms += numET;
     }
 
     void IncrementalOptimizationProblem::remove(
         const OptimizationProblemsSPIt& problemIt) {
-
-      // index bounds check
-      const size_t idx =
+      const size_t slot =
         std::distance(_optimizationProblems.begin(), problemIt);
-      if (idx >= _optimizationProblems.size())
-        throw OutOfBoundException<size_t>(idx, _optimizationProblems.size(),
+      if (slot >= _optimizationProblems.size() || !_optimizationProblems[slot])
+        throw OutOfBoundException<size_t>(slot, _optimizationProblems.size(),
           "index out of bound", __FILE__, __LINE__, __PRETTY_FUNCTION__);
+      removeSlot(slot);
+    }
+
+    void IncrementalOptimizationProblem::remove(size_t idx) {
+      removeSlot(getOptimizationProblemSlot(idx));
+    }
 
+    void IncrementalOptimizationProblem::removeSlot(size_t slot) {
       // get the optimization problem to remove
-      const OptimizationProblemSP& problem = _optimizationProblems.at(idx);
+      const OptimizationProblemSP problem = _optimizationProblems[slot];
 
-      // update design variable counts and remove the pointers if necessary
+      // update design variable counts and leave tombstones for the
+      // unreferenced ones
       const size_t numDV = problem->numDesignVariables();
+      std::unordered_map<size_t, size_t> removedGroups;
       for (size_t i = 0; i < numDV; ++i) {
         const DesignVariable* dv = problem->designVariable(i);
-        _designVariablesCounts[dv].first--;
-        if (_designVariablesCounts[dv].first == 0) {
-          const size_t groupId = getGroupId(dv);
-          _designVariablesCounts.erase(dv);
-          auto it = std::find(_designVariables[groupId].begin(),
-            _designVariables[groupId].end(), dv);
-          _designVariables[groupId].erase(it);
-          if (_designVariables[groupId].empty()) {
-            _designVariables.erase(groupId);
-            auto it = std::find(_groupsOrdering.begin(), _groupsOrdering.end(),
-              groupId);
-            _groupsOrdering.erase(it);
-          }
-          _designVariablesBackup.erase(const_cast<DesignVariable*>(dv));
+        auto infoIt = _designVariablesCounts.find(dv);
+#ifndef NDEBUG
+        checkDesignVariableDim(dv, infoIt->second);
+#endif
+        if (--infoIt->second.count == 0) {
+          const size_t groupId = infoIt->second.groupId;
+          DesignVariablesGroup& group = _designVariables.at(groupId);
+          group.slots[infoIt->second.groupIdx] = nullptr;
+          group.live.subtract(infoIt->second.groupIdx, 1);
+          group.numRemoved++;
+          _designVariablesSnapshot.forget(infoIt->second.snapshotIdx);
+          _groupsDims[groupId] -= infoIt->second.dim;
+          _totalDim -= infoIt->second.dim;
+          _designVariablesCounts.erase(infoIt);
+          removedGroups[groupId]++;
         }
       }
+      _numRemovalSteps += numDV;
 
-      // remove problem from the container
-      // costly if not at the end of the container
-      _optimizationProblems.erase(problemIt);
+      // shift the offsets of the following groups and compact a group once it
+      // holds more tombstones than design variables
+      bool groupsRemoved = false;
+      for (auto it = removedGroups.cbegin(); it != removedGroups.cend();
+          ++it) {
+        const size_t groupId = it->first;
+        DesignVariablesGroup& group = _designVariables.at(groupId);
+        const size_t numLive = group.slots.size() - group.numRemoved;
+        if (numLive == 0) {
+          _designVariables.erase(groupId);
+          _groupsDims.erase(groupId);
+          _groupsOrdering.erase(std::find(_groupsOrdering.begin(),
+            _groupsOrdering.end(), groupId));
+          _numRemovalSteps += _groupsOrdering.size() + 1;
+          groupsRemoved = true;
+          continue;
+        }
+        for (size_t j = _groupsPositions.at(groupId) + 1;
+            j < _groupsOffsets.size(); ++j)
+          _groupsOffsets[j] -= it->second;
+        _numRemovalSteps += _groupsOffsets.size();
+        if (group.numRemoved > numLive) {
+          _numRemovalSteps += group.slots.size();
+          compactDesignVariablesGroup(group);
+        }
+      }
+      if (groupsRemoved)
+        updateGroupsOffsets();
+
+      // forget the error terms owned by this problem
+      const size_t numET = problem->numErrorTerms();
+      for (size_t i = 0; i < numET; ++i) {
+        auto it = _errorTermsBatches.find(problem->errorTerm(i));
+        if (it != _errorTermsBatches.end() && it->second == problem.get())
+          _errorTermsBatches.erase(it);
+      }
+      _numRemovalSteps += numET;
+      _errorTermsCounts.subtract(slot, numET);
+      _numErrorTerms -= numET;
+
+      // leave a tombstone in the slot and compact once they outnumber the
+      // problems
+      _optimizationProblems[slot].reset();
+      _optimizationProblemsLive.subtract(slot, 1);
+      _numRemovedOptimizationProblems++;
+      _optimizationProblemsIdx.erase(problem.get());
+      if (_numRemovedOptimizationProblems > getNumOptimizationProblems()) {
+        _numRemovalSteps += _optimizationProblems.size();
+        compactOptimizationProblems();
+      }
     }
 
-    void IncrementalOptimizationProblem::remove(size_t idx) {
-      remove(_optimizationProblems.begin() + idx);
+    void IncrementalOptimizationProblem::compactOptimizationProblems() {
+      if (_numRemovedOptimizationProblems == 0)
+        return;
+      _optimizationProblems.erase(std::remove(_optimizationProblems.begin(),
+        _optimizationProblems.end(), OptimizationProblemSP()),
+        _optimizationProblems.end());
+      const size_t numBatches = _optimizationProblems.size();
+      std::vector<size_t> numErrorTerms(numBatches);
+      for (size_t i = 0; i < numBatches; ++i) {
+        _optimizationProblemsIdx[_optimizationProblems[i].get()] = i;
+        numErrorTerms[i] = _optimizationProblems[i]->numErrorTerms();
+      }
+      _optimizationProblemsLive.assign(std::vector<size_t>(numBatches, 1));
+      _errorTermsCounts.assign(numErrorTerms);
+      _numRemovedOptimizationProblems = 0;
+    }
+
+    void IncrementalOptimizationProblem::compactDesignVariablesGroup(
+        DesignVariablesGroup& group) {
+      if (group.numRemoved == 0)
+        return;
+      group.slots.erase(std::remove(group.slots.begin(), group.slots.end(),
+        nullptr), group.slots.end());
+      for (size_t i = 0; i < group.slots.size(); ++i)
+        _designVariablesCounts.at(group.slots[i]).groupIdx = i;
+      group.live.assign(std::vector<size_t>(group.slots.size(), 1));
+      group.numRemoved = 0;
+    }
+
+    size_t IncrementalOptimizationProblem::getOptimizationProblemSlot(
+        size_t idx) const {
+      const size_t numBatches = getNumOptimizationProblems();
+      if (idx >= numBatches)
+        throw OutOfBoundException<size_t>(idx, numBatches,
+          "index out of bounds", __FILE__, __LINE__, __PRETTY_FUNCTION__);
+      return _optimizationProblemsLive.find(idx);
     }
 
     void IncrementalOptimizationProblem::clear() {
       _optimizationProblems.clear();
+      _optimizationProblemsLive.clear();
+      _numRemovedOptimizationProblems = 0;
+      _optimizationProblemsIdx.clear();
       _designVariablesCounts.clear();
       _designVariables.clear();
       _groupsOrdering.clear();
+      _groupsDims.clear();
+      _totalDim = 0;
+      _errorTermsBatches.clear();
+      _designVariablesSnapshot.clear();
+      _groupsPositions.clear();
+      _orderedGroups.clear();
+      _groupsOffsets.clear();
+      _errorTermsCounts.clear();
+      _numErrorTerms = 0;
+      _numRemovalSteps = 0;
     }
 
     size_t IncrementalOptimizationProblem::
@@ -267,43 +429,42 @@ namespace aslam {
     IncrementalOptimizationProblem::DesignVariable*
         IncrementalOptimizationProblem::
         designVariableImplementation(size_t idx) {
-      size_t groupId, idxGroup;
-      getGroupId(idx, groupId, idxGroup);
       return const_cast<DesignVariable*>(
-        _designVariables.at(groupId)[idxGroup]);
+        static_cast<const Self*>(this)->designVariableImplementation(idx));
     }
 
     const IncrementalOptimizationProblem::DesignVariable*
         IncrementalOptimizationProblem::
         designVariableImplementation(size_t idx) const {
-      size_t groupId, idxGroup;
-      getGroupId(idx, groupId, idxGroup);
-      return _designVariables.at(groupId)[idxGroup];
-    };
+      if (idx >= _designVariablesCounts.size())
+        throw OutOfBoundException<size_t>(idx, _designVariablesCounts.size(),
+          "index out of bounds", __FILE__, __LINE__, __PRETTY_FUNCTION__);
+      const size_t groupIdx = std::distance(_groupsOffsets.cbegin(),
+        std::upper_bound(_groupsOffsets.cbegin(), _groupsOffsets.cend(), idx))
+        - 1;
+      const DesignVariablesGroup& group = *_orderedGroups[groupIdx];
+      return group.slots[group.live.find(idx - _groupsOffsets[groupIdx])];
+    }
 
     size_t IncrementalOptimizationProblem::IncrementalOptimizationProblem::
         numErrorTermsImplementation() const {
-      size_t numErrorTerms = 0;
-      for (auto it = _optimizationProblems.cbegin();
-          it != _optimizationProblems.cend(); ++it)
-        numErrorTerms += (*it)->numErrorTerms();
-      return numErrorTerms;
+      return _numErrorTerms;
     }
 
     IncrementalOptimizationProblem::ErrorTerm*
         IncrementalOptimizationProblem::errorTermImplementation(size_t idx) {
-      size_t batchIdx, idxBatch;
-      getErrorIdx(idx, batchIdx, idxBatch);
+      size_t slot, idxBatch;
+      getErrorIdx(idx, slot, idxBatch);
       return const_cast<ErrorTerm*>(
-        _optimizationProblems.at(batchIdx)->errorTerm(idxBatch));
+        _optimizationProblems[slot]->errorTerm(idxBatch));
     }
 
     const IncrementalOptimizationProblem::ErrorTerm*
         IncrementalOptimizationProblem::
         errorTermImplementation(size_t idx) const {
-      size_t batchIdx, idxBatch;
-      getErrorIdx(idx, batchIdx, idxBatch);
-      return _optimizationProblems.at(batchIdx)->errorTerm(idxBatch);
+      size_t slot, idxBatch;
+      getErrorIdx(idx, slot, idxBatch);
+      return _optimizationProblems[slot]->errorTerm(idxBatch);
     }
 
     void IncrementalOptimizationProblem::
@@ -315,13 +476,26 @@ namespace aslam {
 
     void IncrementalOptimizationProblem::
         permuteOptimizationProblems(const std::vector<size_t>& permutation) {
+      compactOptimizationProblems();
       permute(_optimizationProblems, permutation);
+      const size_t numBatches = _optimizationProblems.size();
+      std::vector<size_t> numErrorTerms(numBatches);
+      for (size_t i = 0; i < numBatches; ++i) {
+        _optimizationProblemsIdx[_optimizationProblems[i].get()] = i;
+        numErrorTerms[i] = _optimizationProblems[i]->numErrorTerms();
+      }
+      _errorTermsCounts.assign(numErrorTerms);
     }
 
     void IncrementalOptimizationProblem::permuteDesignVariables(
         const std::vector<size_t>& permutation, size_t groupId) {
-      if (isGroupInProblem(groupId))
-        permute(_designVariables.at(groupId), permutation);
+      if (isGroupInProblem(groupId)) {
+        DesignVariablesGroup& group = _designVariables.at(groupId);
+        compactDesignVariablesGroup(group);
+        permute(group.slots, permutation);
+        for (size_t i = 0; i < group.slots.size(); ++i)
+          _designVariablesCounts.at(group.slots[i]).groupIdx = i;
+      }
       else
         throw OutOfBoundException<size_t>(groupId, "unknown group", __FILE__,
           __LINE__, __PRETTY_FUNCTION__);
@@ -332,51 +506,45 @@ namespace aslam {
       if (idx >= _designVariablesCounts.size())
         throw OutOfBoundException<size_t>(idx, _designVariablesCounts.size(),
           "index out of bounds", __FILE__, __LINE__, __PRETTY_FUNCTION__);
-      size_t idxRunning = 0;
-      size_t groupIdRunning = 0;
+      const size_t groupIdx = std::distance(_groupsOffsets.cbegin(),
+        std::upper_bound(_groupsOffsets.cbegin(), _groupsOffsets.cend(), idx))
+        - 1;
+      groupId = _groupsOrdering[groupIdx];
+      idxGroup = idx - _groupsOffsets[groupIdx];
+    }
+
+    void IncrementalOptimizationProblem::updateGroupsOffsets() {
+      _groupsPositions.clear();
+      _orderedGroups.clear();
+      _orderedGroups.reserve(_groupsOrdering.size());
+      _groupsOffsets.clear();
+      _groupsOffsets.reserve(_groupsOrdering.size());
+      size_t offset = 0;
       for (auto it = _groupsOrdering.cbegin(); it != _groupsOrdering.cend();
           ++it) {
-        const DesignVariablesP& designVariables = _designVariables.at(*it);
-        const size_t groupSize = designVariables.size();
-        if ((idxRunning + groupSize) > idx) {
-          groupIdRunning = *it;
-          break;
-        }
-        else
-          idxRunning += groupSize;
+        _groupsPositions.insert(std::make_pair(*it, _orderedGroups.size()));
+        const DesignVariablesGroup& group = _designVariables.at(*it);
+        _orderedGroups.push_back(&group);
+        _groupsOffsets.push_back(offset);
+        offset += group.slots.size() - group.numRemoved;
       }
-      groupId = groupIdRunning;
-      idxGroup = idx - idxRunning;
     }
 
     void IncrementalOptimizationProblem::getErrorIdx(size_t idx,
-        size_t& batchIdx, size_t& idxBatch) const {
-      size_t idxRunning = 0;
-      size_t batchIdxRunning = 0;
-      bool found = false;
-      for (auto it = _optimizationProblems.cbegin();
-          it != _optimizationProblems.cend(); ++it) {
-        const size_t batchSize = (*it)->numErrorTerms();
-        if ((idxRunning + batchSize) > idx) {
-          batchIdxRunning = std::distance(_optimizationProblems.cbegin(), it);
-          found = true;
-          break;
-        }
-        else
-          idxRunning += batchSize;
-      }
-      if (!found)
-        throw OutOfBoundException<size_t>(idx, "index out of bounds", __FILE__,
-          __LINE__, __PRETTY_FUNCTION__);
-      batchIdx = batchIdxRunning;
-      idxBatch = idx - idxRunning;
+        size_t& slot, size_t& idxBatch) const {
+      if (idx >= _numErrorTerms)
+        throw OutOfBoundException<size_t>(idx, _numErrorTerms,
+          "index out of bounds", __FILE__, __LINE__, __PRETTY_FUNCTION__);
+      // empty batches and tombstones hold no error terms and are skipped
+      slot = _errorTermsCounts.find(idx);
+      idxBatch = idx - _errorTermsCounts.getPrefixSum(slot);
     }
 
     void IncrementalOptimizationProblem::remove(const OptimizationProblemSP&
         problem) {
-      auto it = getOptimizationProblem(problem);
-      if (it != _optimizationProblems.end())
-        remove(it);
+      auto it = _optimizationProblemsIdx.find(problem.get());
+      if (it != _optimizationProblemsIdx.end())
+        removeSlot(it->second);
       else
         throw InvalidOperationException("problem not found", __FILE__, __LINE__,
           __PRETTY_FUNCTION__);
@@ -385,31 +553,89 @@ namespace aslam {
     IncrementalOptimizationProblem::OptimizationProblemsSPIt
         IncrementalOptimizationProblem::getOptimizationProblem(const
         OptimizationProblemSP& problem) {
-      return std::find(_optimizationProblems.begin(),
-        _optimizationProblems.end(), problem);
+      compactOptimizationProblems();
+      auto it = _optimizationProblemsIdx.find(problem.get());
+      if (it == _optimizationProblemsIdx.end())
+        return _optimizationProblems.end();
+      return _optimizationProblems.begin() + it->second;
     }
 
     IncrementalOptimizationProblem::OptimizationProblemsSPIt
         IncrementalOptimizationProblem::getOptimizationProblemBegin() {
+      compactOptimizationProblems();
       return _optimizationProblems.begin();
     }
 
     IncrementalOptimizationProblem::OptimizationProblemsSPIt
         IncrementalOptimizationProblem::getOptimizationProblemEnd() {
+      compactOptimizationProblems();
       return _optimizationProblems.end();
     }
 
-    void IncrementalOptimizationProblem::saveDesignVariables() {
-      for (auto it = _designVariablesCounts.cbegin();
-          it != _designVariablesCounts.cend(); ++it)
-        it->first->getParameters(
-          _designVariablesBackup[const_cast<DesignVariable*>(it->first)]);
+    void IncrementalOptimizationProblem::setDesignVariableActive(
+        DesignVariable* designVariable, bool active) {
+      auto infoIt = _designVariablesCounts.find(designVariable);
+      if (infoIt == _designVariablesCounts.end())
+        throw InvalidOperationException("design variable is not in the problem",
+           __FILE__, __LINE__, __PRETTY_FUNCTION__);
+      DesignVariableInfo& info = infoIt->second;
+#ifndef NDEBUG
+      checkDesignVariableDim(designVariable, info);
+#endif
+      designVariable->setActive(active);
+      const size_t dim = active ? designVariable->minimalDimensions() : 0;
+      _groupsDims[info.groupId] -= info.dim;
+      _groupsDims[info.groupId] += dim;
+      _totalDim -= info.dim;
+      _totalDim += dim;
+      info.dim = dim;
+    }
+
+    void IncrementalOptimizationProblem::updateGroupsDims() {
+      _totalDim = 0;
+      for (auto it = _designVariables.cbegin(); it != _designVariables.cend();
+          ++it) {
+        size_t groupDim = 0;
+        for (auto dvIt = it->second.slots.cbegin();
+            dvIt != it->second.slots.cend(); ++dvIt) {
+          if (!*dvIt)
+            continue;
+          const size_t dim = (*dvIt)->isActive() ?
+            (*dvIt)->minimalDimensions() : 0;
+          _designVariablesCounts.at(*dvIt).dim = dim;
+          groupDim += dim;
+        }
+        _groupsDims[it->first] = groupDim;
+        _totalDim += groupDim;
+      }
+    }
+
+    void IncrementalOptimizationProblem::checkDesignVariableDim(
+        const DesignVariable* designVariable, const DesignVariableInfo& info)
+        const {
+      const size_t dim = designVariable->isActive() ?
+        designVariable->minimalDimensions() : 0;
+      if (dim != info.dim)
+        throw InvalidOperationException("design variable activated outside "
+          "setDesignVariableActive(), call updateGroupsDims()", __FILE__,
+          __LINE__, __PRETTY_FUNCTION__);
+    }
+
+    void IncrementalOptimizationProblem::saveDesignVariables(bool activeOnly) {
+      _designVariablesSnapshot.clear();
+      for (auto it = _designVariablesCounts.begin();
+          it != _designVariablesCounts.end(); ++it) {
+        if (activeOnly && !it->first->isActive()) {
+          it->second.snapshotIdx = std::numeric_limits<size_t>::max();
+          continue;
+        }
+        it->second.snapshotIdx = _designVariablesSnapshot.add(
+          const_cast<DesignVariable*>(it->first));
+      }
     }
 
     void IncrementalOptimizationProblem::restoreDesignVariables() {
-      for (auto it = _designVariablesBackup.cbegin();
-          it != _designVariablesBackup.cend(); ++it)
-        it->first->setParameters(_designVariablesBackup[it->first]);
+      _designVariablesSnapshot.restore();
     }
 
   }
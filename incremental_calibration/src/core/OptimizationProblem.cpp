@@ -5,6 +5,8 @@
 
 #include "aslam/calibration/core/OptimizationProblem.h"
 
+#include <algorithm>
+#include <iterator>
 #include <utility>
 
 #include <aslam/backend/DesignVariable.hpp>
@@ -22,7 +24,8 @@ namespace aslam {
 /* Constructors and Destructor                                                */
 /******************************************************************************/
 
-    OptimizationProblem::OptimizationProblem() {
+    OptimizationProblem::OptimizationProblem() :
+        _totalDim(0) {
     }
 
     OptimizationProblem::~OptimizationProblem() {
@@ -73,30 +76,43 @@ namespace aslam {
         groupsLookup.insert(*it);
       }
       _groupsOrdering = groupsOrdering;
+      updateGroupsOffsets();
     }
 
     const std::vector<size_t>& OptimizationProblem::getGroupsOrdering() const {
       return _groupsOrdering;
     }
 
+    OptimizationProblem::OrderedDesignVariablesP
+        OptimizationProblem::getOrderedDesignVariables() const {
+      OrderedDesignVariablesP designVariables;
+      designVariables.reserve(_designVariablesLookup.size());
+      for (auto it = _orderedGroups.cbegin(); it != _orderedGroups.cend();
+          ++it)
+        for (auto dvIt = (*it)->cbegin(); dvIt != (*it)->cend(); ++dvIt)
+          designVariables.push_back(dvIt->get());
+      return designVariables;
+    }
+
     size_t OptimizationProblem::
         getGroupId(const DesignVariable* designVariable) const {
       if (isDesignVariableInProblem(designVariable))
-        return _designVariablesLookup.at(designVariable);
+        return _designVariablesLookup.at(designVariable).groupId;
       else
         throw InvalidOperationException("design variable is not in the problem",
           __FILE__, __LINE__, __PRETTY_FUNCTION__);
     }
 
     size_t OptimizationProblem::getGroupDim(size_t groupId) const {
-      const DesignVariablesSP& designVariables =
-        getDesignVariablesGroup(groupId);
-      size_t dim = 0;
-      for (auto it = designVariables.cbegin(); it != designVariables.cend();
-          ++it)
-        if ((*it)->isActive())
-          dim += (*it)->minimalDimensions();
-      return dim;
+      if (isGroupInProblem(groupId))
+        return _groupsDims.at(groupId);
+      else
+        throw OutOfBoundException<size_t>(groupId, "unknown group", __FILE__,
+          __LINE__, __PRETTY_FUNCTION__);
+    }
+
+    size_t OptimizationProblem::getTotalDim() const {
+      return _totalDim;
     }
 
     bool OptimizationProblem::isGroupInProblem(size_t groupId) const {
@@ -116,11 +132,72 @@ namespace aslam {
       if (isDesignVariableInProblem(designVariable.get()))
         throw InvalidOperationException("design variable already included",
           __FILE__, __LINE__, __PRETTY_FUNCTION__);
+      const size_t numDesignVariables = _designVariablesLookup.size();
+      const size_t dim = designVariable->isActive() ?
+        designVariable->minimalDimensions() : 0;
       _designVariablesLookup.insert(std::make_pair(designVariable.get(),
-        groupId));
-      if (!isGroupInProblem(groupId))
+        DesignVariableInfo{groupId, dim}));
+      if (!isGroupInProblem(groupId)) {
+        _groupsPositions.insert(std::make_pair(groupId,
+          _groupsOrdering.size()));
         _groupsOrdering.push_back(groupId);
+        _orderedGroups.push_back(&_designVariables[groupId]);
+        _groupsOffsets.push_back(numDesignVariables);
+      }
       _designVariables[groupId].push_back(designVariable);
+      _groupsDims[groupId] += dim;
+      _totalDim += dim;
+
+      // append to its group and shift the offsets of the following groups
+      for (size_t i = _groupsPositions.at(groupId) + 1;
+          i < _groupsOffsets.size(); ++i)
+        _groupsOffsets[i]++;
+    }
+
+    void OptimizationProblem::setDesignVariableActive(DesignVariable*
+        designVariable, bool active) {
+      auto infoIt = _designVariablesLookup.find(designVariable);
+      if (infoIt == _designVariablesLookup.end())
+        throw InvalidOperationException("design variable is not in the problem",
+          __FILE__, __LINE__, __PRETTY_FUNCTION__);
+      DesignVariableInfo& info = infoIt->second;
+#ifndef NDEBUG
+      checkDesignVariableDim(designVariable, info);
+#endif
+      designVariable->setActive(active);
+      const size_t dim = active ? designVariable->minimalDimensions() : 0;
+      _groupsDims[info.groupId] -= info.dim;
+      _groupsDims[info.groupId] += dim;
+      _totalDim -= info.dim;
+      _totalDim += dim;
+      info.dim = dim;
+    }
+
+    void OptimizationProblem::updateGroupsDims() {
+      _totalDim = 0;
+      for (auto it = _designVariables.cbegin(); it != _designVariables.cend();
+          ++it) {
+        size_t groupDim = 0;
+        for (auto dvIt = it->second.cbegin(); dvIt != it->second.cend();
+            ++dvIt) {
+          const size_t dim = (*dvIt)->isActive() ?
+            (*dvIt)->minimalDimensions() : 0;
+          _designVariablesLookup.at(dvIt->get()).dim = dim;
+          groupDim += dim;
+        }
+        _groupsDims[it->first] = groupDim;
+        _totalDim += groupDim;
+      }
+    }
+
+    void OptimizationProblem::checkDesignVariableDim(const DesignVariable*
+        designVariable, const DesignVariableInfo& info) const {
+      const size_t dim = designVariable->isActive() ?
+        designVariable->minimalDimensions() : 0;
+      if (dim != info.dim)
+        throw InvalidOperationException("design variable activated outside "
+          "setDesignVariableActive(), call updateGroupsDims()", __FILE__,
+          __LINE__, __PRETTY_FUNCTION__);
     }
 
     bool OptimizationProblem::
@@ -158,7 +235,12 @@ namespace aslam {
       _designVariables.clear();
       _errorTerms.clear();
       _groupsOrdering.clear();
-      _designVariablesBackup.clear();
+      _groupsDims.clear();
+      _totalDim = 0;
+      _designVariablesSnapshot.clear();
+      _groupsPositions.clear();
+      _orderedGroups.clear();
+      _groupsOffsets.clear();
     }
 
     size_t OptimizationProblem::numDesignVariablesImplementation() const {
@@ -167,16 +249,19 @@ namespace aslam {
 
     OptimizationProblem::DesignVariable* OptimizationProblem::
         designVariableImplementation(size_t idx) {
-      size_t groupId, idxGroup;
-      getGroupId(idx, groupId, idxGroup);
-      return _designVariables.at(groupId)[idxGroup].get();
+      return const_cast<DesignVariable*>(
+        static_cast<const Self*>(this)->designVariableImplementation(idx));
     }
 
     const OptimizationProblem::DesignVariable* OptimizationProblem::
         designVariableImplementation(size_t idx) const {
-      size_t groupId, idxGroup;
-      getGroupId(idx, groupId, idxGroup);
-      return _designVariables.at(groupId)[idxGroup].get();
+      if (idx >= _designVariablesLookup.size())
+        throw OutOfBoundException<size_t>(idx, _designVariablesLookup.size(),
+          "index out of bounds", __FILE__, __LINE__, __PRETTY_FUNCTION__);
+      const size_t groupIdx = std::distance(_groupsOffsets.cbegin(),
+        std::upper_bound(_groupsOffsets.cbegin(), _groupsOffsets.cend(), idx))
+        - 1;
+      return (*_orderedGroups[groupIdx])[idx - _groupsOffsets[groupIdx]].get();
     }
 
     size_t OptimizationProblem::OptimizationProblem::
@@ -217,8 +302,9 @@ namespace aslam {
 
     void OptimizationProblem::permuteDesignVariables(const std::vector<size_t>&
         permutation, size_t groupId) {
-      if (isGroupInProblem(groupId))
+      if (isGroupInProblem(groupId)) {
         permute(_designVariables.at(groupId), permutation);
+      }
       else
         throw OutOfBoundException<size_t>(groupId, "unknown group", __FILE__,
           __LINE__, __PRETTY_FUNCTION__);
@@ -229,34 +315,40 @@ namespace aslam {
       if (idx >= _designVariablesLookup.size())
         throw OutOfBoundException<size_t>(idx, _designVariablesLookup.size(),
           "index out of bounds", __FILE__, __LINE__, __PRETTY_FUNCTION__);
-      size_t idxRunning = 0;
-      size_t groupIdRunning = 0;
+      const size_t groupIdx = std::distance(_groupsOffsets.cbegin(),
+        std::upper_bound(_groupsOffsets.cbegin(), _groupsOffsets.cend(), idx))
+        - 1;
+      groupId = _groupsOrdering[groupIdx];
+      idxGroup = idx - _groupsOffsets[groupIdx];
+    }
+
+    void OptimizationProblem::updateGroupsOffsets() {
+      _groupsPositions.clear();
+      _orderedGroups.clear();
+      _orderedGroups.reserve(_groupsOrdering.size());
+      _groupsOffsets.clear();
+      _groupsOffsets.reserve(_groupsOrdering.size());
+      size_t offset = 0;
       for (auto it = _groupsOrdering.cbegin(); it != _groupsOrdering.cend();
           ++it) {
-        const DesignVariablesSP& designVariables = _designVariables.at(*it);
-        const size_t groupSize = designVariables.size();
-        if ((idxRunning + groupSize) > idx) {
-          groupIdRunning = *it;
-          break;
-        }
-        else
-          idxRunning += groupSize;
+        _groupsPositions.insert(std::make_pair(*it, _orderedGroups.size()));
+        _orderedGroups.push_back(&_designVariables.at(*it));
+        _groupsOffsets.push_back(offset);
+        offset += _orderedGroups.back()->size();
       }
-      groupId = groupIdRunning;
-      idxGroup = idx - idxRunning;
     }
 
-    void OptimizationProblem::saveDesignVariables() {
-      for (auto it = _designVariablesLookup.cbegin();
-          it != _designVariablesLookup.cend(); ++it)
-        it->first->getParameters(
-          _designVariablesBackup[const_cast<DesignVariable*>(it->first)]);
+    void OptimizationProblem::saveDesignVariables(bool activeOnly) {
+      _designVariablesSnapshot.clear();
+      for (auto it = _orderedGroups.cbegin(); it != _orderedGroups.cend();
+          ++it)
+        for (auto dvIt = (*it)->cbegin(); dvIt != (*it)->cend(); ++dvIt)
+          if (!activeOnly || (*dvIt)->isActive())
+            _designVariablesSnapshot.add(dvIt->get());
     }
 
     void OptimizationProblem::restoreDesignVariables() {
-      for (auto it = _designVariablesBackup.cbegin();
-          it != _designVariablesBackup.cend(); ++it)
-        it->first->setParameters(_designVariablesBackup[it->first]);
+      _designVariablesSnapshot.restore();
     }
 
   }
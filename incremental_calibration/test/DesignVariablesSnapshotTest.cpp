@@ -0,0 +1,91 @@
+/******************************************************************************
+ * Copyright (C) 2013 by Jerome Maye                                          *
+ * jerome.maye@gmail.com                                                      *
+ ******************************************************************************/
+
+/** \file DesignVariablesSnapshotTest.cpp
+    \brief This file tests the DesignVariablesSnapshot class.
+  */
+
+#include <gtest/gtest.h>
+
+#include "aslam/calibration/core/DesignVariablesSnapshot.h"
+#include "aslam/calibration/data-structures/VectorDesignVariable.h"
+#include "aslam/calibration/exceptions/NullPointerException.h"
+
+using namespace aslam::calibration;
+
+/// Vector design variable recording the buffers it is restored from
+template <int M>
+class RecordingDesignVariable :
+  public VectorDesignVariable<M> {
+public:
+  RecordingDesignVariable(const typename VectorDesignVariable<M>::Container&
+    value) : VectorDesignVariable<M>(value), restoredFrom(nullptr) {};
+  const double* restoredFrom;
+protected:
+  virtual void setParametersImplementation(const Eigen::MatrixXd& value) {
+    restoredFrom = value.data();
+    VectorDesignVariable<M>::setParametersImplementation(value);
+  };
+};
+
+TEST(AslamCalibrationTestSuite, testDesignVariablesSnapshot) {
+  VectorDesignVariable<2> dv1(Eigen::Vector2d(1, 2));
+  VectorDesignVariable<3> dv2(Eigen::Vector3d(3, 4, 5));
+  VectorDesignVariable<2> dv3(Eigen::Vector2d(6, 7));
+  DesignVariablesSnapshot snapshot;
+  snapshot.save({&dv1, &dv2, &dv3});
+  ASSERT_EQ(snapshot.getNumDesignVariables(), 3);
+  ASSERT_EQ(snapshot.getNumParameters(), 7);
+  ASSERT_EQ(snapshot.getParameters(),
+    std::vector<double>({1, 2, 3, 4, 5, 6, 7}));
+  ASSERT_EQ(snapshot.getEntries()[2].offset, 5);
+  ASSERT_EQ(snapshot.getEntries()[1].rows, 3);
+  ASSERT_EQ(snapshot.getEntries()[1].cols, 1);
+  dv1.setValue(Eigen::Vector2d::Zero());
+  dv2.setValue(Eigen::Vector3d::Zero());
+  dv3.setValue(Eigen::Vector2d::Zero());
+  snapshot.forget(2);
+  snapshot.restore();
+  ASSERT_EQ(dv1.getValue(), Eigen::Vector2d(1, 2));
+  ASSERT_EQ(dv2.getValue(), Eigen::Vector3d(3, 4, 5));
+  ASSERT_EQ(dv3.getValue(), Eigen::Vector2d::Zero());
+  snapshot.clear();
+  ASSERT_EQ(snapshot.getNumDesignVariables(), 0);
+  ASSERT_EQ(snapshot.add(&dv3), 0);
+  ASSERT_EQ(snapshot.getNumParameters(), 2);
+  ASSERT_THROW(snapshot.add(nullptr), NullPointerException);
+}
+
+TEST(AslamCalibrationTestSuite, testDesignVariablesSnapshotReuse) {
+  std::vector<RecordingDesignVariable<3> > dvs3(10,
+    RecordingDesignVariable<3>(Eigen::Vector3d(1, 2, 3)));
+  RecordingDesignVariable<2> dv2(Eigen::Vector2d(4, 5));
+  DesignVariablesSnapshot::DesignVariablesP dvs;
+  for (auto it = dvs3.begin(); it != dvs3.end(); ++it)
+    dvs.push_back(&*it);
+  dvs.insert(dvs.begin() + 5, &dv2);
+  DesignVariablesSnapshot snapshot;
+  snapshot.save(dvs);
+  ASSERT_EQ(snapshot.getNumParameters(), 32);
+  snapshot.restore();
+  ASSERT_EQ(dv2.getValue(), Eigen::Vector2d(4, 5));
+
+  // one scratch matrix per shape, kept across snapshots
+  const double* parameters = snapshot.getParameters().data();
+  const double* transfer3 = dvs3.front().restoredFrom;
+  const double* transfer2 = dv2.restoredFrom;
+  ASSERT_NE(transfer3, transfer2);
+  for (size_t i = 0; i < 3; ++i) {
+    dvs3.back().setValue(Eigen::Vector3d::Constant(i));
+    snapshot.save(dvs);
+    dvs3.back().setValue(Eigen::Vector3d::Zero());
+    snapshot.restore();
+    ASSERT_EQ(dvs3.back().getValue(), Eigen::Vector3d::Constant(i));
+    ASSERT_EQ(snapshot.getParameters().data(), parameters);
+    for (auto it = dvs3.cbegin(); it != dvs3.cend(); ++it)
+      ASSERT_EQ(it->restoredFrom, transfer3);
+    ASSERT_EQ(dv2.restoredFrom, transfer2);
+  }
+}
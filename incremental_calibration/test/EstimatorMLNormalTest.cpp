@@ -0,0 +1,72 @@
+/******************************************************************************
+ * Copyright (C) 2013 by Jerome Maye                                          *
+ * jerome.maye@gmail.com                                                      *
+ ******************************************************************************/
+
+/** \file EstimatorMLNormalTest.cpp
+    \brief This file tests the ML estimator of multivariate normal
+           distributions.
+  */
+
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include <Eigen/Core>
+#include <Eigen/StdVector>
+
+#include "aslam/calibration/statistics/EstimatorML.h"
+#include "aslam/calibration/statistics/NormalDistribution.h"
+
+using namespace aslam::calibration;
+
+TEST(AslamCalibrationTestSuite, testEstimatorMLNormal) {
+  typedef EstimatorML<NormalDistribution<2> > Estimator;
+  Estimator::Container points;
+  for (size_t i = 0; i < 1000; ++i)
+    points.push_back(Eigen::Vector2d::Random() +
+      Eigen::Vector2d(1e6, -1e6));
+
+  // two-pass reference
+  Eigen::Vector2d mean = Eigen::Vector2d::Zero();
+  for (auto it = points.cbegin(); it != points.cend(); ++it)
+    mean += *it;
+  mean /= points.size();
+  Eigen::Matrix2d covariance = Eigen::Matrix2d::Zero();
+  for (auto it = points.cbegin(); it != points.cend(); ++it)
+    covariance += (*it - mean) * (*it - mean).transpose();
+  covariance /= points.size();
+
+  // incremental estimation
+  Estimator estimator;
+  ASSERT_FALSE(estimator.getValid());
+  estimator.addPoints(points);
+  ASSERT_EQ(estimator.getNumPoints(), points.size());
+  ASSERT_TRUE(estimator.getValid());
+  ASSERT_TRUE(estimator.getDistribution().getMean().isApprox(mean, 1e-12));
+  ASSERT_TRUE(estimator.getDistribution().getCovariance().isApprox(
+    covariance, 1e-9));
+
+  // merging partial estimators
+  Estimator first;
+  Estimator second;
+  first.addPoints(points.cbegin(), points.cbegin() + 300);
+  second.addPoints(points.cbegin() + 300, points.cend());
+  first.merge(second);
+  first.merge(Estimator());
+  ASSERT_EQ(first.getNumPoints(), points.size());
+  ASSERT_TRUE(first.getValid());
+  ASSERT_TRUE(first.getDistribution().getMean().isApprox(mean, 1e-12));
+  ASSERT_TRUE(first.getDistribution().getCovariance().isApprox(covariance,
+    1e-9));
+  Estimator empty;
+  empty.merge(estimator);
+  ASSERT_EQ(empty.getNumPoints(), points.size());
+
+  // reset
+  estimator.reset();
+  ASSERT_EQ(estimator.getNumPoints(), 0);
+  ASSERT_FALSE(estimator.getValid());
+  estimator.addPoint(Eigen::Vector2d::Ones());
+  ASSERT_EQ(estimator.getDistribution().getMean(), Eigen::Vector2d::Ones());
+}
@@ -0,0 +1,446 @@
+/******************************************************************************
+ * Copyright (C) 2013 by Jerome Maye                                          *
+ * jerome.maye@gmail.com                                                      *
+ ******************************************************************************/
+
+/** \file IncrementalEstimatorTest.cpp
+    \brief This file tests the IncrementalEstimator class.
+  */
+
+#include <cstdio>
+#include <fstream>
+#include <future>
+#include <iterator>
+#include <string>
+#include <vector>
+
+#include <boost/shared_ptr.hpp>
+#include <boost/make_shared.hpp>
+
+#include <gtest/gtest.h>
+
+#include <Eigen/Core>
+
+#include <sm/BoostPropertyTree.hpp>
+
+#include <aslam/backend/DesignVariable.hpp>
+#include <aslam/backend/ErrorTerm.hpp>
+#include <aslam/backend/JacobianContainer.hpp>
+
+#include "aslam/calibration/core/IncrementalEstimator.h"
+#include "aslam/calibration/core/IncrementalOptimizationProblem.h"
+#include "aslam/calibration/core/OptimizationProblem.h"
+#include "aslam/calibration/data-structures/VectorDesignVariable.h"
+#include "aslam/calibration/exceptions/BadArgumentException.h"
+#include "aslam/calibration/exceptions/Exception.h"
+#include "aslam/calibration/exceptions/InvalidOperationException.h"
+#include "aslam/calibration/exceptions/OutOfBoundException.h"
+
+using namespace aslam::calibration;
+
+/// Scalar measurement z = a^T theta + psi
+class LinearErrorTerm :
+  public aslam::backend::ErrorTermFs<1> {
+public:
+  LinearErrorTerm(VectorDesignVariable<2>* theta,
+      VectorDesignVariable<1>* psi, const Eigen::Vector2d& a, double z) :
+      _theta(theta),
+      _psi(psi),
+      _a(a),
+      _z(z) {
+    setDesignVariables(theta, psi);
+    setInvR(inverse_covariance_t::Identity());
+  }
+  LinearErrorTerm(const LinearErrorTerm& other) = delete;
+  LinearErrorTerm& operator = (const LinearErrorTerm& other) = delete;
+  virtual ~LinearErrorTerm() {};
+protected:
+  virtual double evaluateErrorImplementation() {
+    error_t error;
+    error(0) = _a.dot(_theta->getValue()) + _psi->getValue()(0) - _z;
+    setError(error);
+    return evaluateChiSquaredError();
+  };
+  virtual void evaluateJacobiansImplementation(
+      aslam::backend::JacobianContainer& J) {
+    J.add(_theta, _a.transpose());
+    J.add(_psi, Eigen::MatrixXd::Identity(1, 1));
+  };
+private:
+  VectorDesignVariable<2>* _theta;
+  VectorDesignVariable<1>* _psi;
+  Eigen::Vector2d _a;
+  double _z;
+};
+
+/// Builds a batch of measurements sharing one nuisance variable, the scale
+/// of the regressors sets how much the batch observes theta
+IncrementalEstimator::BatchSP createBatch(
+    const boost::shared_ptr<VectorDesignVariable<2> >& theta, size_t seed,
+    double scale = 1.0) {
+  auto batch = boost::make_shared<IncrementalEstimator::Batch>();
+  auto psi = boost::make_shared<VectorDesignVariable<1> >();
+  psi->setActive(true);
+  batch->addDesignVariable(theta, 1);
+  batch->addDesignVariable(psi, 0);
+  const Eigen::Vector2d trueTheta(1.0, 2.0);
+  const double truePsi = 0.1 * seed;
+  for (size_t i = 0; i < 4; ++i) {
+    const Eigen::Vector2d a = scale * Eigen::Vector2d(1.0 + seed + i,
+      1.0 - 0.5 * i * i);
+    batch->addErrorTerm(boost::make_shared<LinearErrorTerm>(theta.get(),
+      psi.get(), a, a.dot(trueTheta) + truePsi));
+  }
+  return batch;
+}
+
+TEST(AslamCalibrationTestSuite, testIncrementalEstimatorCheckpoint) {
+  const std::string filename = "IncrementalEstimatorTest.ickp";
+  auto theta1 = boost::make_shared<VectorDesignVariable<2> >();
+  theta1->setActive(true);
+  IncrementalEstimator estimator1(1);
+  for (size_t i = 0; i < 3; ++i)
+    estimator1.addBatch(createBatch(theta1, i), true);
+  estimator1.saveCheckpoint(filename);
+
+  auto theta2 = boost::make_shared<VectorDesignVariable<2> >();
+  theta2->setActive(true);
+  IncrementalEstimator estimator2(1);
+  estimator2.loadCheckpoint(filename,
+    std::vector<boost::shared_ptr<aslam::backend::DesignVariable> >(
+    {theta2}));
+  ASSERT_EQ(theta1->getValue(), theta2->getValue());
+  ASSERT_EQ(estimator1.getRankTheta(), estimator2.getRankTheta());
+  ASSERT_EQ(estimator1.getRankThetaDeficiency(),
+    estimator2.getRankThetaDeficiency());
+  ASSERT_EQ(estimator1.getRankPsi(), estimator2.getRankPsi());
+  ASSERT_EQ(estimator1.getRankPsiDeficiency(),
+    estimator2.getRankPsiDeficiency());
+  ASSERT_EQ(estimator1.getInformationGain(), estimator2.getInformationGain());
+  ASSERT_EQ(estimator1.getSVDTolerance(), estimator2.getSVDTolerance());
+  ASSERT_EQ(estimator1.getNobsBasis(), estimator2.getNobsBasis());
+  ASSERT_EQ(estimator1.getObsBasis(), estimator2.getObsBasis());
+  ASSERT_EQ(estimator1.getObsBasis(true), estimator2.getObsBasis(true));
+  ASSERT_EQ(estimator1.getSingularValues(),
+    estimator2.getSingularValues());
+
+  // the information gain of a new batch is relative to the restored
+  // log2 sum of the singular values
+  const auto ret1 = estimator1.addBatch(createBatch(theta1, 3), true);
+  const auto ret2 = estimator2.addBatch(createBatch(theta2, 3), true);
+  ASSERT_NEAR(ret1.informationGain, ret2.informationGain, 1e-6);
+
+  // mismatching design variables leave the estimator untouched
+  IncrementalEstimator estimator3(1);
+  auto theta3 = boost::make_shared<VectorDesignVariable<3> >();
+  theta3->setActive(true);
+  ASSERT_THROW(estimator3.loadCheckpoint(filename,
+    std::vector<boost::shared_ptr<aslam::backend::DesignVariable> >(
+    {theta3})), InvalidOperationException);
+  ASSERT_THROW(estimator3.loadCheckpoint(filename,
+    std::vector<boost::shared_ptr<aslam::backend::DesignVariable> >(
+    {theta2, theta2})), InvalidOperationException);
+  ASSERT_EQ(estimator3.getRankTheta(), -1);
+
+  // truncated files are rejected before allocating their matrices
+  std::ifstream input(filename.c_str(), std::ios::binary);
+  const std::string content((std::istreambuf_iterator<char>(input)),
+    std::istreambuf_iterator<char>());
+  input.close();
+  std::ofstream output(filename.c_str(), std::ios::binary);
+  output.write(content.data(), content.size() - 16);
+  output.close();
+  ASSERT_THROW(estimator3.loadCheckpoint(filename,
+    std::vector<boost::shared_ptr<aslam::backend::DesignVariable> >(
+    {theta2})), Exception);
+  std::remove(filename.c_str());
+}
+
+TEST(AslamCalibrationTestSuite, testIncrementalEstimatorPreScreen) {
+  auto theta = boost::make_shared<VectorDesignVariable<2> >();
+  theta->setActive(true);
+  IncrementalEstimator::Options options;
+  options.preScreen = true;
+  IncrementalEstimator estimator(1, options);
+  for (size_t i = 0; i < 3; ++i)
+    estimator.addBatch(createBatch(theta, i), true);
+  ASSERT_EQ(estimator.getRankTheta(), 2);
+  const Eigen::Vector2d thetaValue = theta->getValue();
+  const size_t numBatches = estimator.getNumBatches();
+
+  // a batch barely observing theta is rejected without optimizing
+  auto redundant = createBatch(theta, 3, 1e-3);
+  const auto retRedundant = estimator.addBatch(redundant);
+  ASSERT_TRUE(retRedundant.batchScreened);
+  ASSERT_FALSE(retRedundant.batchAccepted);
+  ASSERT_LE(retRedundant.informationGain + options.preScreenMargin,
+    options.infoGainDelta);
+  ASSERT_EQ(estimator.getNumScreenedBatches(), 1);
+  ASSERT_EQ(estimator.getNumBatches(), numBatches);
+  ASSERT_EQ(theta->getValue(), thetaValue);
+  Eigen::MatrixXd psi;
+  redundant->getDesignVariablesGroup(0).front()->getParameters(psi);
+  ASSERT_EQ(psi, Eigen::MatrixXd::Zero(1, 1));
+
+  // an informative batch passes the screen and is tested on the full problem
+  const auto retInformative = estimator.addBatch(createBatch(theta, 4, 10.0));
+  ASSERT_FALSE(retInformative.batchScreened);
+  ASSERT_TRUE(retInformative.batchAccepted);
+  ASSERT_GT(retInformative.informationGain, options.infoGainDelta);
+  ASSERT_EQ(estimator.getNumScreenedBatches(), 1);
+  ASSERT_EQ(estimator.getNumBatches(), numBatches + 1);
+}
+
+TEST(AslamCalibrationTestSuite, testIncrementalEstimatorCandidates) {
+  // the state agrees exactly with the batches of seed 0, these batches leave
+  // the cost at zero and fail the validity check
+  auto theta = boost::make_shared<VectorDesignVariable<2> >();
+  theta->setActive(true);
+  theta->setValue(Eigen::Vector2d(1.0, 2.0));
+  IncrementalEstimator::Options options;
+  options.checkValidity = true;
+  IncrementalEstimator estimator(1, options);
+  for (size_t i = 0; i < 3; ++i)
+    estimator.addBatch(createBatch(theta, 0), true);
+  ASSERT_EQ(estimator.getRankTheta(), 2);
+  const size_t numBatches = estimator.getNumBatches();
+
+  // the candidate ranked first is rejected by the full test, the next-ranked
+  // one is tested in turn and accepted
+  const std::vector<IncrementalEstimator::BatchSP> candidates{
+    createBatch(theta, 0, 10.0), createBatch(theta, 1, 2.0)};
+  const auto rets = estimator.addBatches(candidates);
+  ASSERT_EQ(rets.size(), candidates.size());
+  ASSERT_FALSE(rets[0].batchAccepted);
+  ASSERT_TRUE(rets[1].batchAccepted);
+  ASSERT_GT(rets[1].informationGain, options.infoGainDelta);
+  ASSERT_EQ(estimator.getNumBatches(), numBatches + 1);
+  ASSERT_TRUE(estimator.getProblem()->isOptimizationProblemInProblem(
+    candidates[1].get()));
+  ASSERT_FALSE(estimator.getProblem()->isOptimizationProblemInProblem(
+    candidates[0].get()));
+}
+
+TEST(AslamCalibrationTestSuite, testIncrementalEstimatorDampedOutputs) {
+  // the problem is linear, the Jacobians of both estimators are the same at
+  // any solution and only the damping of the steps differs
+  LinearSolverOptions linearSolverOptions;
+  linearSolverOptions.columnScaling = true;
+  std::vector<IncrementalEstimator::ReturnValue> rets;
+  for (auto trustRegion : {IncrementalEstimator::TrustRegion::GaussNewton,
+      IncrementalEstimator::TrustRegion::LevenbergMarquardt}) {
+    auto theta = boost::make_shared<VectorDesignVariable<2> >();
+    theta->setActive(true);
+    IncrementalEstimator::Options options;
+    options.trustRegion = trustRegion;
+    IncrementalEstimator estimator(1, options, linearSolverOptions);
+    for (size_t i = 0; i < 2; ++i)
+      estimator.addBatch(createBatch(theta, i), true);
+    rets.push_back(estimator.addBatch(createBatch(theta, 2, 3.0), true));
+  }
+  const auto& gn = rets[0];
+  const auto& lm = rets[1];
+  ASSERT_EQ(lm.singularValuesScaled->size(), gn.singularValuesScaled->size());
+  ASSERT_TRUE(lm.singularValuesScaled->isApprox(*gn.singularValuesScaled,
+    1e-9));
+  ASSERT_TRUE(lm.sigma2ThetaScaled->isApprox(*gn.sigma2ThetaScaled, 1e-9));
+  ASSERT_TRUE(lm.singularValues->isApprox(*gn.singularValues, 1e-9));
+}
+
+TEST(AslamCalibrationTestSuite, testIncrementalEstimatorIncrementalMarginal) {
+  // the problem is linear, the old batches keep an exact linearization point
+  // and the updated factor matches a full analysis up to round-off
+  const size_t refactorizationPeriod = 2;
+  std::vector<std::vector<IncrementalEstimator::ReturnValue> > rets(2);
+  for (size_t k = 0; k < rets.size(); ++k) {
+    auto theta = boost::make_shared<VectorDesignVariable<2> >();
+    theta->setActive(true);
+    IncrementalEstimator::Options options;
+    options.incrementalMarginal = k == 1;
+    options.refactorizationPeriod = refactorizationPeriod;
+    IncrementalEstimator estimator(1, options);
+    for (size_t i = 0; i < 8; ++i)
+      rets[k].push_back(estimator.addBatch(createBatch(theta, i, 1.0 + i),
+        true));
+  }
+  size_t numUpdates = 0;
+  size_t numRefactorizations = 0;
+  for (size_t i = 0; i < rets[0].size(); ++i) {
+    const auto& full = rets[0][i];
+    const auto& approximate = rets[1][i];
+    ASSERT_FALSE(full.marginalApproximate);
+    ASSERT_EQ(approximate.rankTheta, full.rankTheta);
+    ASSERT_TRUE(approximate.singularValues->isApprox(*full.singularValues,
+      1e-8));
+    ASSERT_TRUE(approximate.sigma2Theta->isApprox(*full.sigma2Theta, 1e-8));
+    ASSERT_NEAR(approximate.informationGain, full.informationGain, 1e-8);
+
+    // at most refactorizationPeriod updates between two full analyses
+    if (approximate.marginalApproximate) {
+      ++numUpdates;
+      ASSERT_LE(numUpdates, refactorizationPeriod);
+    }
+    else {
+      if (numUpdates == refactorizationPeriod)
+        ++numRefactorizations;
+      numUpdates = 0;
+    }
+  }
+  ASSERT_GT(numRefactorizations, 0);
+}
+
+TEST(AslamCalibrationTestSuite, testIncrementalEstimatorSigma2Theta) {
+  // the reference reports the covariance, the other estimators only the
+  // quantities listed in their outputs
+  LinearSolverOptions linearSolverOptions;
+  linearSolverOptions.columnScaling = true;
+  const std::vector<unsigned int> outputs{IncrementalEstimator::OutputAll,
+    IncrementalEstimator::OutputObsBasis |
+    IncrementalEstimator::OutputSingularValues |
+    IncrementalEstimator::OutputScaled,
+    IncrementalEstimator::OutputObsBasis | IncrementalEstimator::OutputScaled,
+    IncrementalEstimator::OutputSingularValues |
+    IncrementalEstimator::OutputScaled};
+  std::vector<boost::shared_ptr<IncrementalEstimator> > estimators;
+  for (auto it = outputs.cbegin(); it != outputs.cend(); ++it) {
+    auto theta = boost::make_shared<VectorDesignVariable<2> >();
+    theta->setActive(true);
+    IncrementalEstimator::Options options;
+    options.outputs = *it;
+    estimators.push_back(boost::make_shared<IncrementalEstimator>(1, options,
+      linearSolverOptions));
+    for (size_t i = 0; i < 3; ++i)
+      estimators.back()->addBatch(createBatch(theta, i, 1.0 + i), true);
+  }
+  const auto& reference = estimators[0];
+  const auto& factored = estimators[1];
+  ASSERT_EQ(factored->getSigma2Theta().size(), 0);
+
+  // the diagonal and the blocks match the covariance, scaled and unscaled
+  for (auto scaled : {false, true}) {
+    const Eigen::MatrixXd& sigma2Theta = reference->getSigma2Theta(scaled);
+    ASSERT_EQ(sigma2Theta.rows(), 2);
+    for (auto estimator : {reference, factored}) {
+      ASSERT_TRUE(estimator->getSigma2ThetaDiagonal(scaled).isApprox(
+        sigma2Theta.diagonal(), 1e-9));
+      ASSERT_TRUE(estimator->getSigma2ThetaBlock(0, 2, scaled).isApprox(
+        sigma2Theta, 1e-9));
+      ASSERT_TRUE(estimator->getSigma2ThetaBlock(1, 1, scaled).isApprox(
+        sigma2Theta.block(1, 1, 1, 1), 1e-9));
+      ASSERT_EQ(estimator->getSigma2ThetaBlock(2, 0, scaled).size(), 0);
+      ASSERT_THROW(estimator->getSigma2ThetaBlock(1, 2, scaled),
+        OutOfBoundException<size_t>);
+      ASSERT_THROW(estimator->getSigma2ThetaBlock(3, 0, scaled),
+        OutOfBoundException<size_t>);
+    }
+  }
+
+  // the factor needs both the observable basis and the singular values
+  for (size_t i = 2; i < estimators.size(); ++i) {
+    ASSERT_THROW(estimators[i]->getSigma2ThetaDiagonal(),
+      InvalidOperationException);
+    ASSERT_THROW(estimators[i]->getSigma2ThetaBlock(0, 1),
+      InvalidOperationException);
+  }
+}
+
+TEST(AslamCalibrationTestSuite, testIncrementalEstimatorEviction) {
+  // the eviction needs the marginal system in the outputs
+  IncrementalEstimator::Options options;
+  options.maxNumBatches = 3;
+  options.outputs = IncrementalEstimator::OutputAll &
+    ~IncrementalEstimator::OutputSingularValues;
+  ASSERT_THROW(IncrementalEstimator(1, options),
+    BadArgumentException<unsigned int>);
+  options.outputs = IncrementalEstimator::OutputAll &
+    ~IncrementalEstimator::OutputObsBasis;
+  ASSERT_THROW(IncrementalEstimator(1, options),
+    BadArgumentException<unsigned int>);
+
+  // the number of batches stays bounded
+  options.outputs = IncrementalEstimator::OutputAll;
+  auto theta = boost::make_shared<VectorDesignVariable<2> >();
+  theta->setActive(true);
+  IncrementalEstimator estimator(1, options);
+  size_t numEvicted = 0;
+  for (size_t i = 0; i < 8; ++i) {
+    const auto ret = estimator.addBatch(createBatch(theta, i), true);
+    numEvicted += ret.numEvictedBatches;
+    ASSERT_LE(estimator.getNumBatches(), options.maxNumBatches);
+  }
+  ASSERT_EQ(numEvicted, 8 - options.maxNumBatches);
+  ASSERT_EQ(estimator.getRankTheta(), 2);
+
+  // unless the outputs were changed afterwards
+  estimator.getOptions().outputs = IncrementalEstimator::OutputObsBasis;
+  ASSERT_THROW(estimator.addBatch(createBatch(theta, 8), true),
+    InvalidOperationException);
+}
+
+/// Submits a burst of batches and checks the queue bookkeeping
+void testQueuePolicy(IncrementalEstimator::QueuePolicy policy,
+    std::vector<IncrementalEstimator::ReturnValue>& rets) {
+  auto theta = boost::make_shared<VectorDesignVariable<2> >();
+  theta->setActive(true);
+  IncrementalEstimator::Options options;
+  options.queueCapacity = 1;
+  options.queuePolicy = policy;
+  IncrementalEstimator estimator(1, options);
+  std::vector<std::future<IncrementalEstimator::ReturnValue> > results;
+  const size_t numBatches = 10;
+  for (size_t i = 0; i < numBatches; ++i)
+    results.push_back(estimator.submitBatch(createBatch(theta, i), true));
+  estimator.waitForBatches();
+
+  // every result is available once the queue is drained
+  rets.clear();
+  size_t numDropped = 0;
+  for (auto it = results.begin(); it != results.end(); ++it) {
+    ASSERT_EQ(it->wait_for(std::chrono::seconds(0)),
+      std::future_status::ready);
+    rets.push_back(it->get());
+    numDropped += rets.back().batchDropped;
+  }
+  const auto statistics = estimator.getQueueStatistics();
+  ASSERT_EQ(statistics.numSubmitted, numBatches);
+  ASSERT_EQ(statistics.numSubmitted, statistics.numProcessed +
+    statistics.numDropped);
+  ASSERT_EQ(statistics.numDropped, numDropped);
+  ASSERT_EQ(statistics.queueDepth, 0);
+  ASSERT_LE(statistics.maxQueueDepth, options.queueCapacity);
+  ASSERT_EQ(estimator.getNumBatches(), statistics.numProcessed);
+  ASSERT_GE(statistics.meanLatency, 0.0);
+  ASSERT_GE(statistics.maxLatency, statistics.meanLatency);
+}
+
+TEST(AslamCalibrationTestSuite, testIncrementalEstimatorQueue) {
+  std::vector<IncrementalEstimator::ReturnValue> rets;
+
+  // blocking submitters never lose a batch
+  testQueuePolicy(IncrementalEstimator::QueuePolicy::Block, rets);
+  for (auto it = rets.cbegin(); it != rets.cend(); ++it) {
+    ASSERT_FALSE(it->batchDropped);
+    ASSERT_TRUE(it->batchAccepted);
+  }
+
+  // the last submitted batch is never the oldest one
+  testQueuePolicy(IncrementalEstimator::QueuePolicy::DropOldest, rets);
+  ASSERT_FALSE(rets.back().batchDropped);
+
+  // the first submitted batch finds an empty queue
+  testQueuePolicy(IncrementalEstimator::QueuePolicy::DropNewest, rets);
+  ASSERT_FALSE(rets.front().batchDropped);
+  for (auto it = rets.cbegin(); it != rets.cend(); ++it)
+    ASSERT_FALSE(it->batchDropped && it->batchAccepted);
+
+  // unknown policies are rejected
+  sm::BoostPropertyTree config;
+  config.setInt("groupId", 1);
+  config.setString("queuePolicy", "dropRandom");
+  ASSERT_THROW(IncrementalEstimator estimator(config),
+    BadArgumentException<std::string>);
+  config.setString("queuePolicy", "dropNewest");
+  IncrementalEstimator estimator(config);
+  ASSERT_EQ(estimator.getOptions().queuePolicy,
+    IncrementalEstimator::QueuePolicy::DropNewest);
+}
@@ -157,6 +157,22 @@ TEST(AslamCalibrationTestSuite, testIncrementalOptimizationProblem) {
   ASSERT_EQ(incProblem.getGroupDim(0), 16);
   ASSERT_EQ(incProblem.getGroupDim(1), 4);
   ASSERT_THROW(incProblem.getGroupDim(2), OutOfBoundException<size_t>);
+  ASSERT_EQ(incProblem.getTotalDim(), 20);
+  incProblem.setDesignVariableActive(dv6.get(), false);
+  ASSERT_EQ(incProblem.getGroupDim(0), 10);
+  ASSERT_EQ(incProblem.getTotalDim(), 14);
+  incProblem.setDesignVariableActive(dv6.get(), true);
+  ASSERT_EQ(incProblem.getGroupDim(0), 16);
+  dv6->setActive(false);
+#ifndef NDEBUG
+  ASSERT_THROW(incProblem.setDesignVariableActive(dv6.get(), true),
+    InvalidOperationException);
+#endif
+  incProblem.updateGroupsDims();
+  ASSERT_EQ(incProblem.getTotalDim(), 14);
+  dv6->setActive(true);
+  incProblem.updateGroupsDims();
+  ASSERT_EQ(incProblem.getGroupDim(0), 16);
   ASSERT_TRUE(incProblem.isGroupInProblem(0));
   ASSERT_TRUE(incProblem.isGroupInProblem(1));
   ASSERT_FALSE(incProblem.isGroupInProblem(2));
@@ -168,10 +184,14 @@ TEST(AslamCalibrationTestSuite, testIncrementalOptimizationProblem) {
   ASSERT_EQ(incProblem.designVariable(3), dv5.get());
   ASSERT_EQ(incProblem.designVariable(4), dv6.get());
   ASSERT_EQ(incProblem.designVariable(5), dv3.get());
+  ASSERT_EQ(incProblem.getOrderedDesignVariables(),
+    IncrementalOptimizationProblem::OrderedDesignVariablesP({dv1.get(),
+    dv2.get(), dv4.get(), dv5.get(), dv6.get(), dv3.get()}));
 //  ASSERT_THROW(incProblem.designVariable(7), OutOfBoundException<size_t>);
   incProblem.setGroupsOrdering({1, 0});
   ASSERT_EQ(incProblem.getGroupsOrdering(), std::vector<size_t>({1, 0}));
   ASSERT_EQ(incProblem.designVariable(0), dv3.get());
+  ASSERT_EQ(incProblem.designVariable(5), dv6.get());
   ASSERT_THROW(incProblem.setGroupsOrdering({1, 0, 2}),
     OutOfBoundException<size_t>);
   ASSERT_THROW(incProblem.setGroupsOrdering({1, 2}),
@@ -187,6 +207,8 @@ TEST(AslamCalibrationTestSuite, testIncrementalOptimizationProblem) {
   ASSERT_TRUE(incProblem.isDesignVariableInProblem(dv4.get()));
   auto dvs0update = incProblem.getDesignVariablesGroup(0);
   ASSERT_EQ(dvs0update.size(), 4);
+  ASSERT_EQ(incProblem.getGroupDim(0), 10);
+  ASSERT_EQ(incProblem.getTotalDim(), 14);
   ASSERT_EQ(dvs0update, IncrementalOptimizationProblem::DesignVariablesP(
     {dv2.get(), dv1.get(), dv4.get(), dv5.get()}));
   ASSERT_THROW(incProblem.remove(4), OutOfBoundException<size_t>);
@@ -211,4 +233,175 @@ TEST(AslamCalibrationTestSuite, testIncrementalOptimizationProblem) {
   dv6->getParameters(dv6Param);
   ASSERT_EQ(dv1Param, Eigen::Vector2d::Zero());
   ASSERT_EQ(dv6Param, Eigen::MatrixXd::Ones(6, 1));
+  dv2->setActive(false);
+  incProblem.saveDesignVariables(true);
+  dv1->setParameters(Eigen::Vector2d::Ones());
+  dv2->setParameters(Eigen::Vector3d::Ones());
+  incProblem.restoreDesignVariables();
+  dv1->getParameters(dv1Param);
+  Eigen::MatrixXd dv2Param;
+  dv2->getParameters(dv2Param);
+  ASSERT_EQ(dv1Param, Eigen::Vector2d::Zero());
+  ASSERT_EQ(dv2Param, Eigen::Vector3d::Ones());
+}
+
+TEST(AslamCalibrationTestSuite, testIncrementalOptimizationProblemErrorTerms) {
+  auto dv = boost::make_shared<VectorDesignVariable<2> >();
+  dv->setActive(true);
+  std::vector<boost::shared_ptr<DummyErrorTerm> > ets;
+  IncrementalOptimizationProblem incProblem;
+  const size_t numBatches = 5;
+  for (size_t i = 0; i < numBatches; ++i) {
+    auto problem = boost::make_shared<OptimizationProblem>();
+    problem->addDesignVariable(dv, 0);
+    // batch i holds i error terms, the first batch is empty
+    for (size_t j = 0; j < i; ++j) {
+      auto et = boost::make_shared<DummyErrorTerm>();
+      problem->addErrorTerm(et);
+      ets.push_back(et);
+    }
+    incProblem.add(problem);
+  }
+  ASSERT_EQ(incProblem.numErrorTerms(), ets.size());
+  for (size_t i = 0; i < ets.size(); ++i)
+    ASSERT_EQ(incProblem.errorTerm(i), ets[i].get());
+  ASSERT_THROW(incProblem.errorTerm(ets.size()), OutOfBoundException<size_t>);
+  incProblem.permuteOptimizationProblems({4, 3, 2, 1, 0});
+  ASSERT_EQ(incProblem.numErrorTerms(), ets.size());
+  ASSERT_EQ(incProblem.errorTerm(0), ets[6].get());
+  ASSERT_EQ(incProblem.errorTerm(4), ets[3].get());
+  ASSERT_EQ(incProblem.errorTerm(9), ets[0].get());
+  incProblem.remove(1);
+  ASSERT_EQ(incProblem.numErrorTerms(), ets.size() - 3);
+  ASSERT_EQ(incProblem.errorTerm(4), ets[1].get());
+  ASSERT_EQ(incProblem.errorTerm(6), ets[0].get());
+  auto duplicate = boost::make_shared<OptimizationProblem>();
+  duplicate->addDesignVariable(dv, 0);
+  duplicate->addErrorTerm(ets[6]);
+  ASSERT_THROW(incProblem.add(duplicate), InvalidOperationException);
+  ASSERT_EQ(incProblem.getNumOptimizationProblems(), numBatches - 1);
+  ASSERT_FALSE(incProblem.isErrorTermInProblem(ets[3].get()));
+  ASSERT_TRUE(incProblem.isErrorTermInProblem(ets[6].get()));
+  incProblem.remove(0);
+  ASSERT_FALSE(incProblem.isErrorTermInProblem(ets[6].get()));
+  incProblem.add(duplicate);
+  ASSERT_TRUE(incProblem.isErrorTermInProblem(ets[6].get()));
+  ASSERT_EQ(incProblem.numErrorTerms(), 4);
+  incProblem.clear();
+  ASSERT_EQ(incProblem.numErrorTerms(), 0);
+  ASSERT_FALSE(incProblem.isErrorTermInProblem(ets[0].get()));
+}
+
+TEST(AslamCalibrationTestSuite, testIncrementalOptimizationProblemRemove) {
+  auto theta = boost::make_shared<VectorDesignVariable<2> >();
+  theta->setActive(true);
+  std::vector<boost::shared_ptr<OptimizationProblem> > problems;
+  std::vector<boost::shared_ptr<VectorDesignVariable<3> > > dvs;
+  IncrementalOptimizationProblem incProblem;
+  for (size_t i = 0; i < 4; ++i) {
+    auto problem = boost::make_shared<OptimizationProblem>();
+    auto dv = boost::make_shared<VectorDesignVariable<3> >();
+    dv->setActive(true);
+    problem->addDesignVariable(dv, 0);
+    problem->addDesignVariable(theta, 1);
+    problem->addErrorTerm(boost::make_shared<DummyErrorTerm>());
+    incProblem.add(problem);
+    problems.push_back(problem);
+    dvs.push_back(dv);
+  }
+  incProblem.remove(problems[1]);
+  ASSERT_EQ(incProblem.getNumOptimizationProblems(), 3);
+  ASSERT_EQ(incProblem.getOptimizationProblem(1), problems[2].get());
+  ASSERT_EQ(incProblem.getDesignVariablesGroup(0),
+    IncrementalOptimizationProblem::DesignVariablesP({dvs[0].get(),
+    dvs[2].get(), dvs[3].get()}));
+  ASSERT_EQ(incProblem.designVariable(1), dvs[2].get());
+  ASSERT_EQ(incProblem.designVariable(3), theta.get());
+  ASSERT_EQ(incProblem.getOptimizationProblem(problems[3]) -
+    incProblem.getOptimizationProblemBegin(), 2);
+  ASSERT_EQ(incProblem.getOptimizationProblem(problems[1]),
+    incProblem.getOptimizationProblemEnd());
+  ASSERT_THROW(incProblem.remove(problems[1]), InvalidOperationException);
+  incProblem.remove(problems[2]);
+  incProblem.remove(problems[0]);
+  ASSERT_EQ(incProblem.getOptimizationProblem(0), problems[3].get());
+  ASSERT_EQ(incProblem.numDesignVariables(), 2);
+  ASSERT_EQ(incProblem.errorTerm(0), problems[3]->errorTerm(0));
+  incProblem.remove(problems[3]);
+  ASSERT_EQ(incProblem.getNumGroups(), 0);
+  ASSERT_EQ(incProblem.getTotalDim(), 0);
+  ASSERT_EQ(incProblem.numDesignVariables(), 0);
+  ASSERT_EQ(incProblem.numErrorTerms(), 0);
+
+  // removing the first problem repeatedly evicts the oldest ones
+  for (auto it = problems.cbegin(); it != problems.cend(); ++it)
+    incProblem.add(*it);
+  incProblem.remove(0);
+  ASSERT_EQ(incProblem.getOptimizationProblem(0), problems[1].get());
+  ASSERT_EQ(incProblem.errorTerm(0), problems[1]->errorTerm(0));
+  incProblem.remove(0);
+  ASSERT_EQ(incProblem.getOptimizationProblem(0), problems[2].get());
+  ASSERT_EQ(incProblem.getOptimizationProblem(1), problems[3].get());
+  ASSERT_EQ(incProblem.getDesignVariablesGroup(0),
+    IncrementalOptimizationProblem::DesignVariablesP({dvs[2].get(),
+    dvs[3].get()}));
+  incProblem.remove(1);
+  incProblem.remove(0);
+  ASSERT_EQ(incProblem.getNumGroups(), 0);
+  ASSERT_EQ(incProblem.getTotalDim(), 0);
+  ASSERT_EQ(incProblem.numDesignVariables(), 0);
+  ASSERT_EQ(incProblem.numErrorTerms(), 0);
+}
+
+TEST(AslamCalibrationTestSuite, testIncrementalOptimizationProblemRemoveCost) {
+  auto theta = boost::make_shared<VectorDesignVariable<2> >();
+  theta->setActive(true);
+  std::vector<boost::shared_ptr<OptimizationProblem> > problems;
+  IncrementalOptimizationProblem incProblem;
+  const size_t numBatches = 1000;
+  for (size_t i = 0; i < numBatches; ++i) {
+    auto problem = boost::make_shared<OptimizationProblem>();
+    auto dv = boost::make_shared<VectorDesignVariable<3> >();
+    dv->setActive(true);
+    problem->addDesignVariable(dv, 0);
+    problem->addDesignVariable(theta, 1);
+    problem->addErrorTerm(boost::make_shared<DummyErrorTerm>());
+    incProblem.add(problem);
+    problems.push_back(problem);
+  }
+
+  // evicting the oldest batches must not walk the remaining ones
+  for (size_t i = 0; i < numBatches - 1; ++i) {
+    incProblem.remove(0);
+    ASSERT_EQ(incProblem.getOptimizationProblem(0), problems[i + 1].get());
+    ASSERT_EQ(incProblem.designVariable(0),
+      problems[i + 1]->designVariable(0));
+    ASSERT_EQ(incProblem.errorTerm(0), problems[i + 1]->errorTerm(0));
+  }
+  ASSERT_LE(incProblem.getNumRemovalSteps(), 10 * numBatches);
+  ASSERT_EQ(incProblem.getNumOptimizationProblems(), 1);
+  ASSERT_EQ(incProblem.numDesignVariables(), 2);
+  ASSERT_EQ(incProblem.getTotalDim(), 5);
+
+  // interleaved removals keep the order of the remaining batches
+  incProblem.clear();
+  for (size_t i = 0; i < numBatches; ++i)
+    incProblem.add(problems[i]);
+  std::vector<boost::shared_ptr<OptimizationProblem> > remaining = problems;
+  for (size_t i = 0; remaining.size() > 1; ++i) {
+    const size_t idx = (7 * i) % remaining.size();
+    incProblem.remove(idx);
+    remaining.erase(remaining.begin() + idx);
+    if (i % 50 == 0) {
+      ASSERT_EQ(incProblem.getOptimizationProblems(), remaining);
+      ASSERT_EQ(incProblem.numErrorTerms(), remaining.size());
+      for (size_t j = 0; j < remaining.size(); ++j) {
+        ASSERT_EQ(incProblem.errorTerm(j), remaining[j]->errorTerm(0));
+        ASSERT_EQ(incProblem.designVariable(j),
+          remaining[j]->designVariable(0));
+      }
+      ASSERT_EQ(incProblem.designVariable(remaining.size()), theta.get());
+    }
+  }
+  ASSERT_LE(incProblem.getNumRemovalSteps(), 10 * numBatches);
 }
@@ -0,0 +1,180 @@
+/******************************************************************************
+ * Copyright (C) 2013 by Jerome Maye                                          *
+ * jerome.maye@gmail.com                                                      *
+ ******************************************************************************/
+
+/** \file LinearSolverTest.cpp
+    \brief This file tests the block-wise linear solver against the sparse
+           one.
+  */
+
+#include <vector>
+
+#include <boost/shared_ptr.hpp>
+#include <boost/make_shared.hpp>
+
+#include <gtest/gtest.h>
+
+#include <Eigen/Core>
+
+#include <aslam/backend/ErrorTerm.hpp>
+#include <aslam/backend/JacobianContainer.hpp>
+#include <aslam/backend/Optimizer2Options.hpp>
+#include <aslam/backend/Optimizer2.hpp>
+#include <aslam/backend/GaussNewtonTrustRegionPolicy.hpp>
+
+#include <aslam-tsvd-solver/aslam-tsvd-solver.h>
+#include <aslam-tsvd-solver/aslam-block-tsvd-solver.h>
+
+#include "aslam/calibration/core/OptimizationProblem.h"
+#include "aslam/calibration/data-structures/VectorDesignVariable.h"
+
+using namespace aslam::calibration;
+using namespace aslam::backend;
+
+/// Nuisance design variable type
+typedef VectorDesignVariable<3> Nuisance;
+/// Calibration design variable type
+typedef VectorDesignVariable<4> Calibration;
+
+/// Measures y = A psi + B theta
+class LinearErrorTerm :
+  public aslam::backend::ErrorTermFs<3> {
+public:
+  LinearErrorTerm(Nuisance* psi, Calibration* theta, const Eigen::Matrix3d& A,
+      const Eigen::Matrix<double, 3, 4>& B, const Eigen::Vector3d& y) :
+      _psi(psi),
+      _theta(theta),
+      _A(A),
+      _B(B),
+      _y(y) {
+    setInvR(Eigen::Matrix3d::Identity());
+    setDesignVariables(psi, theta);
+  }
+protected:
+  virtual double evaluateErrorImplementation() {
+    setError(_y - _A * _psi->getValue() - _B * _theta->getValue());
+    return evaluateChiSquaredError();
+  }
+  virtual void evaluateJacobiansImplementation(
+      aslam::backend::JacobianContainer& jacobians) {
+    jacobians.add(_psi, -_A);
+    jacobians.add(_theta, -_B);
+  }
+private:
+  Nuisance* _psi;
+  Calibration* _theta;
+  Eigen::Matrix3d _A;
+  Eigen::Matrix<double, 3, 4> _B;
+  Eigen::Vector3d _y;
+};
+
+/// Measurements of a nuisance variable
+struct Measurement {
+  Eigen::Matrix3d A;
+  Eigen::Matrix<double, 3, 4> B;
+  Eigen::Vector3d y;
+};
+
+/// Runs one Gauss-Newton step and returns theta followed by the nuisances
+Eigen::VectorXd solve(const boost::shared_ptr<AslamTruncatedSvdSolver>&
+    linearSolver, const std::vector<std::vector<Measurement> >& batches,
+    size_t numRuns) {
+  auto problem = boost::make_shared<OptimizationProblem>();
+  auto theta = boost::make_shared<Calibration>();
+  theta->setActive(true);
+  problem->addDesignVariable(theta, 1);
+  std::vector<boost::shared_ptr<Nuisance> > nuisances;
+  for (auto it = batches.cbegin(); it != batches.cend(); ++it) {
+    nuisances.push_back(boost::make_shared<Nuisance>());
+    nuisances.back()->setActive(true);
+    problem->addDesignVariable(nuisances.back(), 0);
+    for (auto mit = it->cbegin(); mit != it->cend(); ++mit)
+      problem->addErrorTerm(boost::make_shared<LinearErrorTerm>(
+        nuisances.back().get(), theta.get(), mit->A, mit->B, mit->y));
+  }
+  problem->setGroupsOrdering({0, 1});
+  Optimizer2Options options;
+  options.maxIterations = 1;
+  options.verbose = false;
+  options.linearSystemSolver = linearSolver;
+  options.trustRegionPolicy =
+    boost::make_shared<GaussNewtonTrustRegionPolicy>();
+  Optimizer2 optimizer(options);
+  optimizer.setProblem(problem);
+  linearSolver->setMargStartIndex(problem->getGroupDim(0));
+  for (size_t run = 0; run < numRuns; ++run) {
+    theta->setValue(Calibration::Container::Zero());
+    for (auto it = nuisances.begin(); it != nuisances.end(); ++it)
+      (*it)->setValue(Nuisance::Container::Zero());
+    optimizer.optimize();
+  }
+  Eigen::VectorXd x(4 + 3 * nuisances.size());
+  x.head<4>() = theta->getValue();
+  for (size_t i = 0; i < nuisances.size(); ++i)
+    x.segment<3>(4 + 3 * i) = nuisances[i]->getValue();
+  return x;
+}
+
+TEST(AslamCalibrationTestSuite, testBlockLinearSolver) {
+  // the last column of theta copies the first one and is unobservable
+  std::vector<std::vector<Measurement> > batches(6);
+  for (auto it = batches.begin(); it != batches.end(); ++it) {
+    it->resize(3);
+    for (auto mit = it->begin(); mit != it->end(); ++mit) {
+      mit->A = Eigen::Matrix3d::Random();
+      mit->B = Eigen::Matrix<double, 3, 4>::Random();
+      mit->B.col(3) = mit->B.col(0);
+      mit->y = Eigen::Vector3d::Random();
+    }
+  }
+  auto linearSolver = boost::make_shared<AslamTruncatedSvdSolver>();
+  const Eigen::VectorXd x = solve(linearSolver, batches, 1);
+  auto blockLinearSolver = boost::make_shared<AslamBlockTruncatedSvdSolver>(
+    AslamTruncatedSvdSolver::Options(), 2);
+  const Eigen::VectorXd xBlock = solve(blockLinearSolver, batches, 2);
+  ASSERT_EQ(blockLinearSolver->getNumBlocks(), batches.size());
+  ASSERT_EQ(x.size(), xBlock.size());
+  for (std::ptrdiff_t i = 0; i < x.size(); ++i)
+    ASSERT_NEAR(x(i), xBlock(i), 1e-6);
+
+  // the truncated step leaves the unobservable direction of theta alone
+  ASSERT_NEAR(xBlock(0), xBlock(3), 1e-6);
+  ASSERT_TRUE(blockLinearSolver->analyzeScaledSystem());
+  ASSERT_EQ(blockLinearSolver->getSVDRank(), linearSolver->getSVDRank());
+  ASSERT_EQ(blockLinearSolver->getSVDRankDeficiency(), 1);
+}
+
+TEST(AslamCalibrationTestSuite, testBlockLinearSolverTolerance) {
+  std::vector<std::vector<Measurement> > batches(6);
+  for (auto it = batches.begin(); it != batches.end(); ++it) {
+    it->resize(3);
+    for (auto mit = it->begin(); mit != it->end(); ++mit) {
+      mit->A = Eigen::Matrix3d::Random();
+      mit->B = Eigen::Matrix<double, 3, 4>::Random();
+      mit->y = Eigen::Vector3d::Random();
+    }
+  }
+  auto linearSolver = boost::make_shared<AslamTruncatedSvdSolver>();
+  solve(linearSolver, batches, 1);
+  const Eigen::VectorXd singularValues = linearSolver->getSingularValues();
+  ASSERT_EQ(linearSolver->getSVDRank(), 4);
+
+  // the smallest singular value falls just below the tolerance of the m -
+  // qrRank reduced rows, and above one counting the compressed block rows
+  const std::ptrdiff_t numReducedRows = 3 * 3 * batches.size() -
+    linearSolver->getQRRank();
+  AslamTruncatedSvdSolver::Options options;
+  options.epsSVD = singularValues(3) / ((numReducedRows - 1) *
+    singularValues(0));
+  linearSolver = boost::make_shared<AslamTruncatedSvdSolver>(options);
+  solve(linearSolver, batches, 1);
+  auto blockLinearSolver = boost::make_shared<AslamBlockTruncatedSvdSolver>(
+    options, 2);
+  solve(blockLinearSolver, batches, 1);
+  ASSERT_EQ(blockLinearSolver->getNumBlocks(), batches.size());
+  ASSERT_EQ(linearSolver->getSVDRank(), 3);
+  ASSERT_EQ(blockLinearSolver->getBlockSVDRank(), linearSolver->getSVDRank());
+  ASSERT_NEAR(blockLinearSolver->getBlockSVDTolerance(),
+    linearSolver->getSVDTolerance(), 1e-12 * linearSolver->getSVDTolerance());
+}
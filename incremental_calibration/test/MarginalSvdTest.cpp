@@ -0,0 +1,146 @@
+/******************************************************************************
+ * Copyright (C) 2013 by Jerome Maye                                          *
+ * jerome.maye@gmail.com                                                      *
+ ******************************************************************************/
+
+/** \file MarginalSvdTest.cpp
+    \brief This file tests the dense SVD backends of the marginal analysis
+           against the Jacobi SVD.
+  */
+
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include <Eigen/Core>
+#include <Eigen/SVD>
+
+#include <aslam-tsvd-solver/marginal-svd.h>
+
+using namespace aslam::backend;
+
+/// Returns the number of singular values above the tolerance, the normal
+/// equations resolve them down to sqrt(eps) times the largest one only
+std::ptrdiff_t getRank(const Eigen::VectorXd& singularValues) {
+  if (singularValues.size() == 0)
+    return 0;
+  const double tolerance = 1e-6 * singularValues(0);
+  std::ptrdiff_t rank = 0;
+  while (rank < singularValues.size() && singularValues(rank) > tolerance)
+    ++rank;
+  return rank;
+}
+
+/// Compares a backend against the Jacobi SVD of A
+void testBackend(const Eigen::MatrixXd& A, MarginalSvdBackend backend) {
+  SCOPED_TRACE(marginalSvdBackendToString(backend) + " on " +
+    std::to_string(A.rows()) + "x" + std::to_string(A.cols()));
+  const Eigen::JacobiSVD<Eigen::MatrixXd> reference(A, Eigen::ComputeFullV);
+  const Eigen::VectorXd& singularValues = reference.singularValues();
+  const std::ptrdiff_t n = A.cols();
+  const std::ptrdiff_t k = std::min(A.rows(), A.cols());
+  const double scale = singularValues(0);
+  const double tolerance = backend == MarginalSvdBackend::kNormalEquations ?
+    1e-6 : 1e-10;
+  MarginalSvd svd;
+  computeMarginalSvd(A, backend, true, &svd);
+
+  // singular values and rank
+  ASSERT_EQ(svd.singular_values.size(), k);
+  for (std::ptrdiff_t i = 0; i < k; ++i)
+    ASSERT_NEAR(svd.singular_values(i), singularValues(i), tolerance * scale);
+  const std::ptrdiff_t rank = getRank(singularValues);
+  ASSERT_EQ(getRank(svd.singular_values), rank);
+
+  // right singular vectors up to sign, the null space up to a rotation
+  ASSERT_EQ(svd.V.rows(), n);
+  ASSERT_EQ(svd.V.cols(), n);
+  ASSERT_TRUE(svd.V.isUnitary(1e-8));
+  for (std::ptrdiff_t i = 0; i < rank; ++i)
+    ASSERT_NEAR(std::fabs(svd.V.col(i).dot(reference.matrixV().col(i))), 1.0,
+      1e-6);
+  if (rank < n) {
+    const Eigen::MatrixXd nullSpace = svd.V.rightCols(n - rank);
+    const Eigen::MatrixXd nullSpaceReference =
+      reference.matrixV().rightCols(n - rank);
+    ASSERT_TRUE((nullSpace * nullSpace.transpose()).isApprox(
+      nullSpaceReference * nullSpaceReference.transpose(), 1e-6));
+  }
+
+  // left singular vectors rebuild A
+  ASSERT_EQ(svd.U.rows(), A.rows());
+  ASSERT_EQ(svd.U.cols(), k);
+  ASSERT_LE((svd.U * svd.singular_values.asDiagonal() *
+    svd.V.leftCols(k).transpose() - A).norm(), 1e-6 * scale);
+}
+
+/// Compares all the backends against the Jacobi SVD of A
+void testBackends(const Eigen::MatrixXd& A) {
+  for (auto backend : {MarginalSvdBackend::kAuto,
+      MarginalSvdBackend::kFixedSize, MarginalSvdBackend::kJacobi,
+      MarginalSvdBackend::kDivideAndConquer,
+      MarginalSvdBackend::kNormalEquations})
+    testBackend(A, backend);
+}
+
+TEST(AslamCalibrationTestSuite, testMarginalSvdBackends) {
+  std::srand(0);
+  // random square and tall systems, on both sides of the fixed-size limit
+  testBackends(Eigen::MatrixXd::Random(5, 5));
+  testBackends(Eigen::MatrixXd::Random(12, kMaxFixedSizeMarginalSvd));
+  testBackends(Eigen::MatrixXd::Random(40, 12));
+  testBackends(Eigen::MatrixXd::Random(60, kMaxJacobiMarginalSvd + 4));
+
+  // rank-deficient systems
+  testBackends(Eigen::MatrixXd::Random(10, 4) * Eigen::MatrixXd::Random(4, 6));
+  testBackends(Eigen::MatrixXd::Random(30, 5) *
+    Eigen::MatrixXd::Random(5, 9));
+  Eigen::MatrixXd A = Eigen::MatrixXd::Random(8, 3);
+  A.col(2) = A.col(0) - 2.0 * A.col(1);
+  testBackends(A);
+
+  // wide systems fall back to the dynamic backends
+  testBackends(Eigen::MatrixXd::Random(3, 5));
+}
+
+TEST(AslamCalibrationTestSuite, testMarginalSvdAuto) {
+  // thresholds of the automatic selection
+  ASSERT_EQ(selectMarginalSvdBackend(1), MarginalSvdBackend::kFixedSize);
+  ASSERT_EQ(selectMarginalSvdBackend(kMaxFixedSizeMarginalSvd),
+    MarginalSvdBackend::kFixedSize);
+  ASSERT_EQ(selectMarginalSvdBackend(kMaxFixedSizeMarginalSvd + 1),
+    MarginalSvdBackend::kJacobi);
+  ASSERT_EQ(selectMarginalSvdBackend(kMaxJacobiMarginalSvd),
+    MarginalSvdBackend::kJacobi);
+  ASSERT_EQ(selectMarginalSvdBackend(kMaxJacobiMarginalSvd + 1),
+    MarginalSvdBackend::kDivideAndConquer);
+
+  // kAuto runs the selected backend around each threshold
+  std::srand(1);
+  const std::vector<std::ptrdiff_t> cols{kMaxFixedSizeMarginalSvd,
+    kMaxFixedSizeMarginalSvd + 1, kMaxJacobiMarginalSvd,
+    kMaxJacobiMarginalSvd + 1};
+  for (auto it = cols.cbegin(); it != cols.cend(); ++it) {
+    const Eigen::MatrixXd A = Eigen::MatrixXd::Random(2 * *it, *it);
+    MarginalSvd svdAuto, svdSelected;
+    computeMarginalSvd(A, MarginalSvdBackend::kAuto, true, &svdAuto);
+    computeMarginalSvd(A, selectMarginalSvdBackend(*it), true, &svdSelected);
+    ASSERT_EQ(svdAuto.singular_values, svdSelected.singular_values);
+    ASSERT_EQ(svdAuto.U, svdSelected.U);
+    ASSERT_EQ(svdAuto.V, svdSelected.V);
+  }
+
+  // names
+  for (auto backend : {MarginalSvdBackend::kAuto,
+      MarginalSvdBackend::kFixedSize, MarginalSvdBackend::kJacobi,
+      MarginalSvdBackend::kDivideAndConquer,
+      MarginalSvdBackend::kNormalEquations})
+    ASSERT_EQ(marginalSvdBackendFromString(
+      marginalSvdBackendToString(backend)), backend);
+  ASSERT_THROW(marginalSvdBackendFromString("qr"), std::invalid_argument);
+}
@@ -85,10 +85,29 @@ TEST(AslamCalibrationTestSuite, testOptimizationProblem) {
 //  ASSERT_THROW(problem.designVariable(3), OutOfBoundException<size_t>);
   problem.permuteDesignVariables({1, 0}, 1);
   ASSERT_EQ(problem.designVariable(0), dv3.get());
+  ASSERT_EQ(problem.getOrderedDesignVariables(),
+    OptimizationProblem::OrderedDesignVariablesP({dv3.get(), dv2.get(),
+    dv1.get()}));
   ASSERT_THROW(problem.permuteDesignVariables({1, 0}, 2),
     OutOfBoundException<size_t>);
   ASSERT_EQ(problem.getGroupDim(0), 2);
   ASSERT_EQ(problem.getGroupDim(1), 7);
+  ASSERT_EQ(problem.getTotalDim(), 9);
+  ASSERT_THROW(problem.getGroupDim(2), OutOfBoundException<size_t>);
+  problem.setDesignVariableActive(dv2.get(), false);
+  ASSERT_FALSE(dv2->isActive());
+  ASSERT_EQ(problem.getGroupDim(1), 4);
+  ASSERT_EQ(problem.getTotalDim(), 6);
+  ASSERT_THROW(problem.setDesignVariableActive(dv4.get(), false),
+    InvalidOperationException);
+  dv2->setActive(true);
+#ifndef NDEBUG
+  ASSERT_THROW(problem.setDesignVariableActive(dv2.get(), false),
+    InvalidOperationException);
+#endif
+  problem.updateGroupsDims();
+  ASSERT_EQ(problem.getGroupDim(1), 7);
+  ASSERT_EQ(problem.getTotalDim(), 9);
   ASSERT_TRUE(problem.isGroupInProblem(0));
   ASSERT_TRUE(problem.isGroupInProblem(1));
   ASSERT_FALSE(problem.isGroupInProblem(2));
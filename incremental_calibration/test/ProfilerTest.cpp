@@ -0,0 +1,103 @@
+/******************************************************************************
+ * Copyright (C) 2013 by Jerome Maye                                          *
+ * jerome.maye@gmail.com                                                      *
+ ******************************************************************************/
+
+/** \file ProfilerTest.cpp
+    \brief This file tests the Profiler class.
+  */
+
+#include <cstdio>
+
+#include <fstream>
+#include <sstream>
+
+#include <gtest/gtest.h>
+
+#include "aslam/calibration/base/Profiler.h"
+
+using namespace aslam::calibration;
+
+TEST(AslamCalibrationTestSuite, testProfiler) {
+  Profiler profiler(2, 3);
+  profiler.beginBatch();
+  profiler.record("optimize", 1.0, 0.5);
+  profiler.record("optimize", 2.0, 2e-3);
+  profiler.record("analyzeMarginal", 3.0, 1e-5);
+  const Profiler::PhaseTimes phaseTimes = profiler.endBatch();
+  ASSERT_EQ(phaseTimes.size(), 2);
+  ASSERT_DOUBLE_EQ(phaseTimes.at("optimize"), 0.502);
+  ASSERT_TRUE(profiler.endBatch().empty());
+
+  // nested batches keep the outer one and count in it
+  profiler.beginBatch();
+  profiler.record("addBatch", 1.0, 1.0);
+  {
+    Profiler::ScopedBatch batch(profiler);
+    profiler.record("optimize", 1.0, 0.25);
+    const Profiler::PhaseTimes innerPhaseTimes = batch.end();
+    ASSERT_EQ(innerPhaseTimes.size(), 1);
+    ASSERT_DOUBLE_EQ(innerPhaseTimes.at("optimize"), 0.25);
+    ASSERT_TRUE(batch.end().empty());
+  }
+  {
+    Profiler::ScopedBatch batch(profiler);
+    profiler.record("optimize", 2.0, 0.25);
+  }
+  const Profiler::PhaseTimes outerPhaseTimes = profiler.endBatch();
+  ASSERT_EQ(outerPhaseTimes.size(), 2);
+  ASSERT_DOUBLE_EQ(outerPhaseTimes.at("addBatch"), 1.0);
+  ASSERT_DOUBLE_EQ(outerPhaseTimes.at("optimize"), 0.5);
+  ASSERT_TRUE(profiler.endBatch().empty());
+  profiler.clear();
+  profiler.record("optimize", 1.0, 0.5);
+  profiler.record("optimize", 2.0, 2e-3);
+  profiler.record("analyzeMarginal", 3.0, 1e-5);
+  ASSERT_EQ(profiler.getPhases(),
+    std::vector<std::string>({"analyzeMarginal", "optimize"}));
+
+  profiler.record("optimize", 4.0, 1e-3);
+  const Profiler::PhaseStatistics statistics =
+    profiler.getPhaseStatistics("optimize");
+  ASSERT_EQ(statistics.count, 3);
+  ASSERT_DOUBLE_EQ(statistics.total, 0.503);
+  ASSERT_DOUBLE_EQ(statistics.min, 1e-3);
+  ASSERT_DOUBLE_EQ(statistics.max, 0.5);
+  ASSERT_DOUBLE_EQ(statistics.windowMean, 1.5e-3);
+  const Profiler::Histogram& histogram = statistics.histogram;
+  ASSERT_EQ(histogram.edges.size(), histogram.counts.size() + 1);
+  size_t numCounts = 0;
+  for (size_t i = 0; i < histogram.counts.size(); ++i) {
+    numCounts += histogram.counts[i];
+    if (histogram.counts[i] > 0) {
+      ASSERT_LE(histogram.edges[i], 1e-3);
+      ASSERT_GT(histogram.edges[i + 1], 2e-3);
+    }
+  }
+  ASSERT_EQ(numCounts, 2);
+  ASSERT_EQ(profiler.getPhaseStatistics("unknown").count, 0);
+
+  const std::vector<Profiler::Event> events = profiler.getEvents();
+  ASSERT_EQ(events.size(), 3);
+  ASSERT_EQ(events.front().phase, "optimize");
+  ASSERT_DOUBLE_EQ(events.front().start, 2.0);
+
+  const std::string filename = "ProfilerTest.json";
+  profiler.writeChromeTrace(filename);
+  std::ifstream file(filename.c_str());
+  std::stringstream content;
+  content << file.rdbuf();
+  std::remove(filename.c_str());
+  ASSERT_NE(content.str().find("\"traceEvents\""), std::string::npos);
+  ASSERT_NE(content.str().find("\"name\":\"analyzeMarginal\",\"ph\":\"X\","
+    "\"ts\":1000000,\"dur\":10"), std::string::npos);
+
+  {
+    Profiler::ScopedPhase phase(profiler, "scoped");
+  }
+  ASSERT_EQ(profiler.getPhaseStatistics("scoped").count, 1);
+  ASSERT_GE(profiler.getPhaseStatistics("scoped").total, 0.0);
+  profiler.clear();
+  ASSERT_TRUE(profiler.getPhases().empty());
+  ASSERT_TRUE(profiler.getEvents().empty());
+}
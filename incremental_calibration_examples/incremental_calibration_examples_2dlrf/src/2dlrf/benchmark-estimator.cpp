@@ -0,0 +1,239 @@
+/******************************************************************************
+ * Copyright (C) 2013 by Jerome Maye                                          *
+ * jerome.maye@gmail.com                                                      *
+ ******************************************************************************/
+
+/** \file benchmark-estimator.cpp
+    \brief This file streams batches of the 2D-LRF calibration problem into
+           the incremental estimator and records the per-batch latency and
+           memory usage.
+  */
+
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include <boost/shared_ptr.hpp>
+#include <boost/make_shared.hpp>
+
+#include <Eigen/Core>
+
+#include <sm/kinematics/rotations.hpp>
+
+#include <sm/BoostPropertyTree.hpp>
+
+#include <aslam/calibration/statistics/UniformDistribution.h>
+#include <aslam/calibration/statistics/NormalDistribution.h>
+#include <aslam/calibration/data-structures/VectorDesignVariable.h>
+#include <aslam/calibration/core/IncrementalEstimator.h>
+#include <aslam/calibration/core/OptimizationProblem.h>
+#include <aslam/calibration/base/Profiler.h>
+
+#include "aslam/calibration/2dlrf/utils.h"
+#include "aslam/calibration/2dlrf/ErrorTermMotion.h"
+#include "aslam/calibration/2dlrf/ErrorTermObservation.h"
+
+using namespace aslam::calibration;
+using namespace sm::kinematics;
+using namespace sm;
+
+/// Returns the nearest-rank percentile of sorted values
+double percentile(const std::vector<double>& sorted, double p) {
+  if (sorted.empty())
+    return 0.0;
+  const size_t rank = static_cast<size_t>(std::ceil(p / 100.0 *
+    sorted.size()));
+  return sorted[std::min(sorted.size(), std::max<size_t>(rank, 1)) - 1];
+}
+
+/// Writes the latency percentiles of a path as a JSON object
+void writeLatencyJson(std::ostream& stream, std::vector<double> latencies) {
+  std::sort(latencies.begin(), latencies.end());
+  double sum = 0.0;
+  for (auto it = latencies.cbegin(); it != latencies.cend(); ++it)
+    sum += *it;
+  stream << "{\"count\":" << latencies.size()
+    << ",\"mean\":" << (latencies.empty() ? 0.0 : sum / latencies.size())
+    << ",\"p50\":" << percentile(latencies, 50)
+    << ",\"p90\":" << percentile(latencies, 90)
+    << ",\"p99\":" << percentile(latencies, 99)
+    << ",\"max\":" << (latencies.empty() ? 0.0 : latencies.back()) << "}";
+}
+
+int main(int argc, char** argv) {
+  if (argc < 2 || argc > 6) {
+    std::cerr << "Usage: " << argv[0] << " <conf_file> [num_batches]"
+      " [batch_size] [num_threads] [output_prefix]" << std::endl;
+    return -1;
+  }
+
+  // load configuration file, the command line overrides the sizes
+  BoostPropertyTree propertyTree;
+  propertyTree.loadXml(argv[1]);
+  const size_t numBatches = argc > 2 ? std::atol(argv[2]) : 1000;
+  const size_t batchSize = argc > 3 ? std::atol(argv[3]) :
+    propertyTree.getInt("lrf/estimator/batchSize");
+  if (argc > 4) {
+    const int numThreads = std::atoi(argv[4]);
+    propertyTree.setInt("lrf/estimator/optimizer/nThreads", numThreads);
+    propertyTree.setInt("lrf/estimator/numSolverThreads", numThreads);
+    propertyTree.setInt("lrf/estimator/numCandidateThreads", numThreads);
+  }
+  const std::string outputPrefix = argc > 5 ? argv[5] : "benchmark-estimator";
+  const size_t steps = numBatches * batchSize;
+  const double T = propertyTree.getDouble("lrf/problem/timestep");
+
+  // simulate the whole run as simulate-online does
+  std::vector<Eigen::Vector3d> u_true;
+  genSineWavePath(u_true, steps,
+    propertyTree.getDouble("lrf/problem/sineWaveAmplitude"),
+    propertyTree.getDouble("lrf/problem/sineWaveFrequency"), T);
+  const size_t nl = propertyTree.getInt("lrf/problem/numLandmarks");
+  const Eigen::Vector2d min(propertyTree.getDouble("lrf/problem/groundMinX"),
+    propertyTree.getDouble("lrf/problem/groundMinY"));
+  const Eigen::Vector2d max(propertyTree.getDouble("lrf/problem/groundMaxX"),
+    propertyTree.getDouble("lrf/problem/groundMaxY"));
+  Eigen::Matrix3d Q = Eigen::Matrix3d::Zero();
+  Q(0, 0) = propertyTree.getDouble("lrf/problem/motion/sigma2_x");
+  Q(1, 1) = propertyTree.getDouble("lrf/problem/motion/sigma2_y");
+  Q(2, 2) = propertyTree.getDouble("lrf/problem/motion/sigma2_t");
+  Eigen::Matrix2d R = Eigen::Matrix2d::Zero();
+  R(0, 0) = propertyTree.getDouble("lrf/problem/observation/sigma2_r");
+  R(1, 1) = propertyTree.getDouble("lrf/problem/observation/sigma2_b");
+  std::vector<Eigen::Vector2d> x_l;
+  UniformDistribution<double, 2>(min, max).getSamples(x_l, nl);
+  const Eigen::Vector3d Theta(propertyTree.getDouble("lrf/problem/thetaTrue/x"),
+    propertyTree.getDouble("lrf/problem/thetaTrue/y"),
+    propertyTree.getDouble("lrf/problem/thetaTrue/t"));
+  const Eigen::Vector3d Theta_hat(
+    propertyTree.getDouble("lrf/problem/thetaHat/x"),
+    propertyTree.getDouble("lrf/problem/thetaHat/y"),
+    propertyTree.getDouble("lrf/problem/thetaHat/t"));
+  const Eigen::Vector3d x_0(propertyTree.getDouble("lrf/problem/x0/x"),
+    propertyTree.getDouble("lrf/problem/x0/y"),
+    propertyTree.getDouble("lrf/problem/x0/t"));
+  std::vector<Eigen::Vector3d> x_true(1, x_0);
+  std::vector<Eigen::Vector3d> x_odom(1, x_0);
+  std::vector<Eigen::Vector3d> u_noise(1, Eigen::Vector3d::Zero());
+  std::vector<std::vector<double> > r(1, std::vector<double>(nl, 0));
+  std::vector<std::vector<double> > b(1, std::vector<double>(nl, 0));
+  x_true.reserve(steps);
+  x_odom.reserve(steps);
+  u_noise.reserve(steps);
+  r.reserve(steps);
+  b.reserve(steps);
+  for (size_t i = 1; i < steps; ++i) {
+    Eigen::Matrix3d B = Eigen::Matrix3d::Identity();
+    B(0, 0) = cos(x_true[i - 1](2));
+    B(0, 1) = -sin(x_true[i - 1](2));
+    B(1, 0) = sin(x_true[i - 1](2));
+    B(1, 1) = cos(x_true[i - 1](2));
+    Eigen::Vector3d xk = x_true[i - 1] + T * B * u_true[i];
+    xk(2) = angleMod(xk(2));
+    x_true.push_back(xk);
+    u_noise.push_back(u_true[i] +
+      NormalDistribution<3>(Eigen::Vector3d::Zero(), Q).getSample());
+    B(0, 0) = cos(x_odom[i - 1](2));
+    B(0, 1) = -sin(x_odom[i - 1](2));
+    B(1, 0) = sin(x_odom[i - 1](2));
+    B(1, 1) = cos(x_odom[i - 1](2));
+    xk = x_odom[i - 1] + T * B * u_noise[i];
+    xk(2) = angleMod(xk(2));
+    x_odom.push_back(xk);
+    const double ct = cos(x_true[i](2));
+    const double st = sin(x_true[i](2));
+    std::vector<double> rk(nl, 0);
+    std::vector<double> bk(nl, 0);
+    for (size_t j = 0; j < nl; ++j) {
+      const double aa = x_l[j](0) - x_true[i](0) - Theta(0) * ct +
+        Theta(1) * st;
+      const double bb = x_l[j](1) - x_true[i](1) - Theta(0) * st -
+        Theta(1) * ct;
+      rk[j] = sqrt(aa * aa + bb * bb) +
+        NormalDistribution<1>(0, R(0, 0)).getSample();
+      bk[j] = angleMod(atan2(bb, aa) - x_true[i](2) - Theta(2) +
+        NormalDistribution<1>(0, R(1, 1)).getSample());
+    }
+    r.push_back(rk);
+    b.push_back(bk);
+  }
+  std::vector<Eigen::Vector2d> x_l_hat;
+  initLandmarks(x_l_hat, x_odom, Theta_hat, r, b);
+  std::vector<boost::shared_ptr<VectorDesignVariable<2> > > dv_x_l;
+  dv_x_l.reserve(nl);
+  for (size_t i = 0; i < nl; ++i) {
+    dv_x_l.push_back(boost::make_shared<VectorDesignVariable<2> >(x_l_hat[i]));
+    dv_x_l[i]->setActive(true);
+  }
+  auto dv_Theta = boost::make_shared<VectorDesignVariable<3> >(Theta_hat);
+  dv_Theta->setActive(true);
+
+  // stream the batches, one CSV line per batch
+  IncrementalEstimator incrementalEstimator(PropertyTree(propertyTree,
+    "lrf/estimator"));
+  std::ofstream csv((outputPrefix + ".csv").c_str());
+  csv << "batch,accepted,latency,elapsedTime,numBatches,memoryUsage,"
+    "peakMemoryUsage,informationGain,numIterations" << std::endl;
+  std::vector<double> acceptedLatencies;
+  std::vector<double> rejectedLatencies;
+  acceptedLatencies.reserve(numBatches);
+  rejectedLatencies.reserve(numBatches);
+  const double runStart = Profiler::now();
+  for (size_t i = 0, batchIdx = 0; i < steps; i += batchSize, ++batchIdx) {
+    auto batch = boost::make_shared<IncrementalEstimator::Batch>();
+    auto dv_xkm1 = boost::make_shared<VectorDesignVariable<3> >(x_odom[i]);
+    dv_xkm1->setActive(true);
+    batch->addDesignVariable(dv_xkm1, 0);
+    batch->addDesignVariable(dv_Theta, 2);
+    for (size_t k = 0; k < nl; ++k)
+      batch->addDesignVariable(dv_x_l[k], 1);
+    for (size_t j = i + 1; j < i + batchSize && j < steps; ++j) {
+      auto dv_xk = boost::make_shared<VectorDesignVariable<3> >(x_odom[j]);
+      dv_xk->setActive(true);
+      batch->addDesignVariable(dv_xk, 0);
+      batch->addErrorTerm(boost::make_shared<ErrorTermMotion>(dv_xkm1.get(),
+        dv_xk.get(), T, u_noise[j], Q));
+      for (size_t k = 0; k < nl; ++k)
+        batch->addErrorTerm(boost::make_shared<ErrorTermObservation>(
+          dv_xk.get(), dv_x_l[k].get(), dv_Theta.get(), r[j][k], b[j][k], R));
+      dv_xkm1 = dv_xk;
+    }
+
+    const double timeStart = Profiler::now();
+    const IncrementalEstimator::ReturnValue ret =
+      incrementalEstimator.addBatch(batch);
+    const double latency = Profiler::now() - timeStart;
+    (ret.batchAccepted ? acceptedLatencies : rejectedLatencies).push_back(
+      latency);
+    csv << batchIdx << "," << ret.batchAccepted << "," << latency << ","
+      << ret.elapsedTime << "," << incrementalEstimator.getNumBatches() << ","
+      << incrementalEstimator.getMemoryUsage() << ","
+      << incrementalEstimator.getPeakMemoryUsage() << ","
+      << ret.informationGain << "," << ret.numIterations << std::endl;
+  }
+  const double runTime = Profiler::now() - runStart;
+
+  // summary with the latency percentiles of both paths
+  std::ofstream json((outputPrefix + ".json").c_str());
+  json << "{\"numBatches\":" << numBatches << ",\"batchSize\":" << batchSize
+    << ",\"numThreads\":" << propertyTree.getInt(
+    "lrf/estimator/optimizer/nThreads", 1)
+    << ",\"numAcceptedBatches\":" << acceptedLatencies.size()
+    << ",\"totalTime\":" << runTime
+    << ",\"peakMemoryUsage\":" << incrementalEstimator.getPeakMemoryUsage()
+    << ",\"accepted\":";
+  writeLatencyJson(json, acceptedLatencies);
+  json << ",\"rejected\":";
+  writeLatencyJson(json, rejectedLatencies);
+  json << ",\"calibration\":[" << dv_Theta->getValue()(0) << ","
+    << dv_Theta->getValue()(1) << "," << dv_Theta->getValue()(2) << "]}"
+    << std::endl;
+  std::cout << "accepted " << acceptedLatencies.size() << ", rejected "
+    << rejectedLatencies.size() << ", total time [s]: " << runTime
+    << ", results in " << outputPrefix << ".{csv,json}" << std::endl;
+  return 0;
+}
@@ -224,10 +224,7 @@ int main(int argc, char** argv) {
     boost::make_shared<GaussNewtonTrustRegionPolicy>());
   optimizer.setProblem(problem);
 
-  size_t JCols = 0;
-  for (auto it = problem->getGroupsOrdering().cbegin();
-      it != problem->getGroupsOrdering().cend(); ++it)
-    JCols += problem->getGroupDim(*it);
+  const size_t JCols = problem->getTotalDim();
   const size_t dim = problem->getGroupDim(2);
   auto linearSolver = optimizer.getSolver<LinearSolver>();
   linearSolver->setMargStartIndex(JCols - dim);
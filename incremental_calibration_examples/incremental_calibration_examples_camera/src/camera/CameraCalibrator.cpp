@@ -161,7 +161,7 @@ namespace aslam {
 
     Eigen::VectorXd CameraCalibrator::getProjectionVariance() const {
       if (_estimator->getNumBatches())
-        return _estimator->getSigma2Theta().diagonal().head(
+        return _estimator->getSigma2ThetaDiagonal().head(
           _geometry->minimalDimensionsProjection());
       else
         return Eigen::VectorXd::Zero(0);
@@ -182,7 +182,7 @@ namespace aslam {
 
     Eigen::VectorXd CameraCalibrator::getDistortionVariance() const {
       if (_estimator->getNumBatches())
-        return _estimator->getSigma2Theta().diagonal().tail(
+        return _estimator->getSigma2ThetaDiagonal().tail(
           _geometry->minimalDimensionsDistortion());
       else
         return Eigen::VectorXd::Zero(0);
@@ -475,14 +475,14 @@ namespace aslam {
         ret.batchAccepted ? std::cout << "ACCEPTED" : std::cout << "REJECTED";
         std::cout << std::endl;
         std::cout << "information gain: " << ret.informationGain << std::endl;
-        std::cout << "unobservable basis: " << std::endl << ret.nobsBasis
+        std::cout << "unobservable basis: " << std::endl << *ret.nobsBasis
           << std::endl;
         std::cout << "singular values: "
-          << ret.singularValues.transpose() << std::endl;
+          << ret.singularValues->transpose() << std::endl;
         std::cout << "unobservable basis (scaled): " << std::endl
-          << ret.nobsBasisScaled << std::endl;
+          << *ret.nobsBasisScaled << std::endl;
         std::cout << "singular values (scaled): "
-          << ret.singularValuesScaled.transpose() << std::endl;
+          << ret.singularValuesScaled->transpose() << std::endl;
         std::cout << "projection: " << getProjection().transpose() << std::endl;
         std::cout << "projection standard deviation: "
           << getProjectionStandardDeviation().transpose() << std::endl;
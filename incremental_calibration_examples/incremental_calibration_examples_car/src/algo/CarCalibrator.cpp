@@ -129,7 +129,7 @@ namespace aslam {
     }
 
     Eigen::VectorXd CarCalibrator::getOdometryVariablesVariance() const {
-      return _estimator->getSigma2Theta().diagonal();
+      return _estimator->getSigma2ThetaDiagonal();
     }
 
     const CarCalibrator::TranslationSplineSP&
@@ -372,37 +372,38 @@ namespace aslam {
         std::cout << "calibration after batch: " << std::endl;
         std::cout << *_odometryDesignVariables << std::endl;
         std::cout << "singular values: " << std::endl
-          << ret.singularValuesScaled << std::endl;
+          << *ret.singularValuesScaled << std::endl;
         std::cout << "observability: " << std::endl;
-        std::cout << "e_r: " << ret.obsBasisScaled.row(0).norm() << std::endl;
-        std::cout << "e_f: " << ret.obsBasisScaled.row(1).norm() << std::endl;
-        std::cout << "L: " << ret.obsBasisScaled.row(2).norm() << std::endl;
-        std::cout << "a0: " << ret.obsBasisScaled.row(3).norm() << std::endl;
-        std::cout << "a1: " << ret.obsBasisScaled.row(4).norm() << std::endl;
-        std::cout << "a2: " << ret.obsBasisScaled.row(5).norm() << std::endl;
-        std::cout << "a3: " << ret.obsBasisScaled.row(6).norm() << std::endl;
-        std::cout << "k_rl: " << ret.obsBasisScaled.row(7).norm() << std::endl;
-        std::cout << "k_rr: " << ret.obsBasisScaled.row(8).norm() << std::endl;
-        std::cout << "k_fl: " << ret.obsBasisScaled.row(9).norm() << std::endl;
-        std::cout << "k_fr: " << ret.obsBasisScaled.row(10).norm() << std::endl;
-        std::cout << "k_dmi: " << ret.obsBasisScaled.row(11).norm()
+        std::cout << "e_r: " << ret.obsBasisScaled->row(0).norm() << std::endl;
+        std::cout << "e_f: " << ret.obsBasisScaled->row(1).norm() << std::endl;
+        std::cout << "L: " << ret.obsBasisScaled->row(2).norm() << std::endl;
+        std::cout << "a0: " << ret.obsBasisScaled->row(3).norm() << std::endl;
+        std::cout << "a1: " << ret.obsBasisScaled->row(4).norm() << std::endl;
+        std::cout << "a2: " << ret.obsBasisScaled->row(5).norm() << std::endl;
+        std::cout << "a3: " << ret.obsBasisScaled->row(6).norm() << std::endl;
+        std::cout << "k_rl: " << ret.obsBasisScaled->row(7).norm() << std::endl;
+        std::cout << "k_rr: " << ret.obsBasisScaled->row(8).norm() << std::endl;
+        std::cout << "k_fl: " << ret.obsBasisScaled->row(9).norm() << std::endl;
+        std::cout << "k_fr: " << ret.obsBasisScaled->row(10).norm()
           << std::endl;
-        std::cout << "v_r_vr_1: " << ret.obsBasisScaled.row(12).norm()
+        std::cout << "k_dmi: " << ret.obsBasisScaled->row(11).norm()
           << std::endl;
-        std::cout << "v_r_vr_2: " << ret.obsBasisScaled.row(13).norm()
+        std::cout << "v_r_vr_1: " << ret.obsBasisScaled->row(12).norm()
           << std::endl;
-        std::cout << "v_r_vr_3: " << ret.obsBasisScaled.row(14).norm()
+        std::cout << "v_r_vr_2: " << ret.obsBasisScaled->row(13).norm()
           << std::endl;
-        std::cout << "v_R_r_1: " << ret.obsBasisScaled.row(15).norm()
+        std::cout << "v_r_vr_3: " << ret.obsBasisScaled->row(14).norm()
           << std::endl;
-        std::cout << "v_R_r_2: " << ret.obsBasisScaled.row(16).norm()
+        std::cout << "v_R_r_1: " << ret.obsBasisScaled->row(15).norm()
           << std::endl;
-        std::cout << "v_R_r_3: " << ret.obsBasisScaled.row(17).norm()
+        std::cout << "v_R_r_2: " << ret.obsBasisScaled->row(16).norm()
           << std::endl;
-        std::cout << "t_r: " << ret.obsBasisScaled.row(18).norm() << std::endl;
-        std::cout << "t_f: " << ret.obsBasisScaled.row(19).norm() << std::endl;
-        std::cout << "t_s: " << ret.obsBasisScaled.row(20).norm() << std::endl;
-        std::cout << "t_dmi: " << ret.obsBasisScaled.row(21).norm()
+        std::cout << "v_R_r_3: " << ret.obsBasisScaled->row(17).norm()
+          << std::endl;
+        std::cout << "t_r: " << ret.obsBasisScaled->row(18).norm() << std::endl;
+        std::cout << "t_f: " << ret.obsBasisScaled->row(19).norm() << std::endl;
+        std::cout << "t_s: " << ret.obsBasisScaled->row(20).norm() << std::endl;
+        std::cout << "t_dmi: " << ret.obsBasisScaled->row(21).norm()
           << std::endl;
       }
       _infoGainHistory.push_back(ret.informationGain);
@@ -120,25 +120,25 @@ namespace aslam {
         std::cout << "calibration after batch: " << std::endl;
         std::cout << *designVariables_ << std::endl;
         std::cout << "singular values: " << std::endl
-          << ret.singularValuesScaled << std::endl;
+          << *ret.singularValuesScaled << std::endl;
         std::cout << "observability: " << std::endl;
         size_t idx = 0;
         for (const auto& designVariable :
             designVariables_->calibrationVariables_) {
           std::cout << "t_" << designVariable.first << ": "
-            << ret.obsBasisScaled.row(idx++).norm() << std::endl;
+            << ret.obsBasisScaled->row(idx++).norm() << std::endl;
           std::cout << "r_" << designVariable.first << "_1 : "
-            << ret.obsBasisScaled.row(idx++).norm() << std::endl;
+            << ret.obsBasisScaled->row(idx++).norm() << std::endl;
           std::cout << "r_" << designVariable.first << "_2 : "
-            << ret.obsBasisScaled.row(idx++).norm() << std::endl;
+            << ret.obsBasisScaled->row(idx++).norm() << std::endl;
           std::cout << "r_" << designVariable.first << "_3 : "
-            << ret.obsBasisScaled.row(idx++).norm() << std::endl;
+            << ret.obsBasisScaled->row(idx++).norm() << std::endl;
           std::cout << "R_" << designVariable.first << "_1 : "
-            << ret.obsBasisScaled.row(idx++).norm() << std::endl;
+            << ret.obsBasisScaled->row(idx++).norm() << std::endl;
           std::cout << "R_" << designVariable.first << "_2 : "
-            << ret.obsBasisScaled.row(idx++).norm() << std::endl;
+            << ret.obsBasisScaled->row(idx++).norm() << std::endl;
           std::cout << "R_" << designVariable.first << "_3 : "
-            << ret.obsBasisScaled.row(idx++).norm() << std::endl;
+            << ret.obsBasisScaled->row(idx++).norm() << std::endl;
         }
       }
       for (const auto& designVariable : designVariables_->calibrationVariables_)
@@ -120,7 +120,7 @@ namespace aslam {
     }
 
     Eigen::VectorXd Calibrator::getOdometryVariablesVariance() const {
-      return _estimator->getSigma2Theta().diagonal();
+      return _estimator->getSigma2ThetaDiagonal();
     }
 
     const Calibrator::TranslationSplineSP&
@@ -270,24 +270,24 @@ namespace aslam {
         std::cout << "calibration after batch: " << std::endl;
         std::cout << *_odometryDesignVariables << std::endl;
         std::cout << "singular values: " << std::endl
-          << ret.singularValuesScaled << std::endl;
+          << *ret.singularValuesScaled << std::endl;
         std::cout << "observability: " << std::endl;
-        std::cout << "b: " << ret.obsBasisScaled.row(0).norm() << std::endl;
-        std::cout << "k_l: " << ret.obsBasisScaled.row(1).norm() << std::endl;
-        std::cout << "t_l: " << ret.obsBasisScaled.row(2).norm() << std::endl;
-        std::cout << "k_r: " << ret.obsBasisScaled.row(3).norm() << std::endl;
-        std::cout << "t_r: " << ret.obsBasisScaled.row(4).norm() << std::endl;
-        std::cout << "v_r_vp_1: " << ret.obsBasisScaled.row(5).norm()
+        std::cout << "b: " << ret.obsBasisScaled->row(0).norm() << std::endl;
+        std::cout << "k_l: " << ret.obsBasisScaled->row(1).norm() << std::endl;
+        std::cout << "t_l: " << ret.obsBasisScaled->row(2).norm() << std::endl;
+        std::cout << "k_r: " << ret.obsBasisScaled->row(3).norm() << std::endl;
+        std::cout << "t_r: " << ret.obsBasisScaled->row(4).norm() << std::endl;
+        std::cout << "v_r_vp_1: " << ret.obsBasisScaled->row(5).norm()
           << std::endl;
-        std::cout << "v_r_vp_2: " << ret.obsBasisScaled.row(6).norm()
+        std::cout << "v_r_vp_2: " << ret.obsBasisScaled->row(6).norm()
           << std::endl;
-        std::cout << "v_r_vp_3: " << ret.obsBasisScaled.row(7).norm()
+        std::cout << "v_r_vp_3: " << ret.obsBasisScaled->row(7).norm()
           << std::endl;
-        std::cout << "v_R_p_1: " << ret.obsBasisScaled.row(8).norm()
+        std::cout << "v_R_p_1: " << ret.obsBasisScaled->row(8).norm()
           << std::endl;
-        std::cout << "v_R_p_2: " << ret.obsBasisScaled.row(9).norm()
+        std::cout << "v_R_p_2: " << ret.obsBasisScaled->row(9).norm()
           << std::endl;
-        std::cout << "v_R_p_3: " << ret.obsBasisScaled.row(10).norm()
+        std::cout << "v_R_p_3: " << ret.obsBasisScaled->row(10).norm()
           << std::endl;
       }
       _infoGainHistory.push_back(ret.informationGain);
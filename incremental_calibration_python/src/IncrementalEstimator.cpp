@@ -63,6 +63,28 @@ Eigen::MatrixXd getSigma2ThetaObsScaled(const IncrementalEstimator* ie) {
   return ie->getSigma2ThetaObs(true);
 }
 
+/// This functions gets rid of the default argument
+Eigen::MatrixXd getSigma2ThetaDiagonal(const IncrementalEstimator* ie) {
+  return ie->getSigma2ThetaDiagonal();
+}
+
+/// This functions gets rid of the default argument
+Eigen::MatrixXd getSigma2ThetaDiagonalScaled(const IncrementalEstimator* ie) {
+  return ie->getSigma2ThetaDiagonal(true);
+}
+
+/// This functions gets rid of the default argument
+Eigen::MatrixXd getSigma2ThetaBlock(const IncrementalEstimator* ie,
+    size_t start, size_t size) {
+  return ie->getSigma2ThetaBlock(start, size);
+}
+
+/// This functions gets rid of the default argument
+Eigen::MatrixXd getSigma2ThetaBlockScaled(const IncrementalEstimator* ie,
+    size_t start, size_t size) {
+  return ie->getSigma2ThetaBlock(start, size, true);
+}
+
 /// This functions gets rid of the reference
 Eigen::MatrixXd getSingularValues(const IncrementalEstimator* ie) {
   return ie->getSingularValues();
@@ -73,13 +95,111 @@ Eigen::MatrixXd getScaledSingularValues(const IncrementalEstimator* ie) {
   return ie->getSingularValues(true);
 }
 
+/// This functions copies the shared nobsBasis of a return value
+Eigen::MatrixXd getReturnValueNobsBasis(
+    const IncrementalEstimator::ReturnValue& rv) {
+  return *rv.nobsBasis;
+}
+
+/// This functions copies the shared nobsBasisScaled of a return value
+Eigen::MatrixXd getReturnValueNobsBasisScaled(
+    const IncrementalEstimator::ReturnValue& rv) {
+  return *rv.nobsBasisScaled;
+}
+
+/// This functions copies the shared obsBasis of a return value
+Eigen::MatrixXd getReturnValueObsBasis(
+    const IncrementalEstimator::ReturnValue& rv) {
+  return *rv.obsBasis;
+}
+
+/// This functions copies the shared obsBasisScaled of a return value
+Eigen::MatrixXd getReturnValueObsBasisScaled(
+    const IncrementalEstimator::ReturnValue& rv) {
+  return *rv.obsBasisScaled;
+}
+
+/// This functions copies the shared sigma2Theta of a return value
+Eigen::MatrixXd getReturnValueSigma2Theta(
+    const IncrementalEstimator::ReturnValue& rv) {
+  return *rv.sigma2Theta;
+}
+
+/// This functions copies the shared sigma2ThetaScaled of a return value
+Eigen::MatrixXd getReturnValueSigma2ThetaScaled(
+    const IncrementalEstimator::ReturnValue& rv) {
+  return *rv.sigma2ThetaScaled;
+}
+
+/// This functions copies the shared sigma2ThetaObs of a return value
+Eigen::MatrixXd getReturnValueSigma2ThetaObs(
+    const IncrementalEstimator::ReturnValue& rv) {
+  return *rv.sigma2ThetaObs;
+}
+
+/// This functions copies the shared sigma2ThetaObsScaled of a return value
+Eigen::MatrixXd getReturnValueSigma2ThetaObsScaled(
+    const IncrementalEstimator::ReturnValue& rv) {
+  return *rv.sigma2ThetaObsScaled;
+}
+
+/// This functions copies the shared singularValues of a return value
+Eigen::VectorXd getReturnValueSingularValues(
+    const IncrementalEstimator::ReturnValue& rv) {
+  return *rv.singularValues;
+}
+
+/// This functions copies the shared singularValuesScaled of a return value
+Eigen::VectorXd getReturnValueSingularValuesScaled(
+    const IncrementalEstimator::ReturnValue& rv) {
+  return *rv.singularValuesScaled;
+}
+
 void exportIncrementalEstimator() {
+  /// Export back-pressure policy for the IncrementalEstimator class
+  enum_<IncrementalEstimator::QueuePolicy>("IncrementalEstimatorQueuePolicy")
+    .value("Block", IncrementalEstimator::QueuePolicy::Block)
+    .value("DropOldest", IncrementalEstimator::QueuePolicy::DropOldest)
+    .value("DropNewest", IncrementalEstimator::QueuePolicy::DropNewest)
+    ;
+
+  /// Export trust region policies for the IncrementalEstimator class
+  enum_<IncrementalEstimator::TrustRegion>("IncrementalEstimatorTrustRegion")
+    .value("GaussNewton", IncrementalEstimator::TrustRegion::GaussNewton)
+    .value("LevenbergMarquardt",
+      IncrementalEstimator::TrustRegion::LevenbergMarquardt)
+    .value("DogLeg", IncrementalEstimator::TrustRegion::DogLeg)
+    ;
+
   /// Export options for the IncrementalEstimator class
   class_<IncrementalEstimator::Options>("IncrementalEstimatorOptions", init<>())
     .def_readwrite("infoGainDelta",
       &IncrementalEstimator::Options::infoGainDelta)
     .def_readwrite("checkValidity",
       &IncrementalEstimator::Options::checkValidity)
+    .def_readwrite("saveActiveOnly",
+      &IncrementalEstimator::Options::saveActiveOnly)
+    .def_readwrite("preScreen", &IncrementalEstimator::Options::preScreen)
+    .def_readwrite("preScreenMargin",
+      &IncrementalEstimator::Options::preScreenMargin)
+    .def_readwrite("maxNumBatches",
+      &IncrementalEstimator::Options::maxNumBatches)
+    .def_readwrite("maxMemoryUsage",
+      &IncrementalEstimator::Options::maxMemoryUsage)
+    .def_readwrite("queueCapacity",
+      &IncrementalEstimator::Options::queueCapacity)
+    .def_readwrite("queuePolicy", &IncrementalEstimator::Options::queuePolicy)
+    .def_readwrite("trustRegion", &IncrementalEstimator::Options::trustRegion)
+    .def_readwrite("numCandidateThreads",
+      &IncrementalEstimator::Options::numCandidateThreads)
+    .def_readwrite("blockElimination",
+      &IncrementalEstimator::Options::blockElimination)
+    .def_readwrite("numSolverThreads",
+      &IncrementalEstimator::Options::numSolverThreads)
+    .def_readwrite("incrementalMarginal",
+      &IncrementalEstimator::Options::incrementalMarginal)
+    .def_readwrite("refactorizationPeriod",
+      &IncrementalEstimator::Options::refactorizationPeriod)
     .def_readwrite("verbose", &IncrementalEstimator::Options::verbose)
     ;
 
@@ -88,6 +208,18 @@ void exportIncrementalEstimator() {
     init<>())
     .def_readwrite("batchAccepted",
       &IncrementalEstimator::ReturnValue::batchAccepted)
+    .def_readwrite("batchScreened",
+      &IncrementalEstimator::ReturnValue::batchScreened)
+    .def_readwrite("batchDropped",
+      &IncrementalEstimator::ReturnValue::batchDropped)
+    .def_readwrite("marginalApproximate",
+      &IncrementalEstimator::ReturnValue::marginalApproximate)
+    .def_readwrite("numEvictedBatches",
+      &IncrementalEstimator::ReturnValue::numEvictedBatches)
+    .def_readwrite("memoryUsageBeforeEviction",
+      &IncrementalEstimator::ReturnValue::memoryUsageBeforeEviction)
+    .def_readwrite("memoryUsageAfterEviction",
+      &IncrementalEstimator::ReturnValue::memoryUsageAfterEviction)
     .def_readwrite("informationGain",
       &IncrementalEstimator::ReturnValue::informationGain)
     .def_readwrite("rankPsi", &IncrementalEstimator::ReturnValue::rankPsi)
@@ -101,25 +233,18 @@ void exportIncrementalEstimator() {
       &IncrementalEstimator::ReturnValue::svdTolerance)
     .def_readwrite("qrTolerance",
       &IncrementalEstimator::ReturnValue::qrTolerance)
-    .def_readwrite("nobsBasis", &IncrementalEstimator::ReturnValue::nobsBasis)
-    .def_readwrite("nobsBasisScaled",
-      &IncrementalEstimator::ReturnValue::nobsBasisScaled)
-    .def_readwrite("obsBasis",
-      &IncrementalEstimator::ReturnValue::obsBasis)
-    .def_readwrite("obsBasisScaled",
-      &IncrementalEstimator::ReturnValue::obsBasisScaled)
-    .def_readwrite("sigma2Theta",
-      &IncrementalEstimator::ReturnValue::sigma2Theta)
-    .def_readwrite("sigma2ThetaScaled",
-      &IncrementalEstimator::ReturnValue::sigma2ThetaScaled)
-    .def_readwrite("sigma2ThetaObs",
-      &IncrementalEstimator::ReturnValue::sigma2ThetaObs)
-    .def_readwrite("sigma2ThetaObsScaled",
-      &IncrementalEstimator::ReturnValue::sigma2ThetaObsScaled)
-    .def_readwrite("singularValues",
-      &IncrementalEstimator::ReturnValue::singularValues)
-    .def_readwrite("singularValuesScaled",
-      &IncrementalEstimator::ReturnValue::singularValuesScaled)
+    .add_property("nobsBasis", &getReturnValueNobsBasis)
+    .add_property("nobsBasisScaled", &getReturnValueNobsBasisScaled)
+    .add_property("obsBasis", &getReturnValueObsBasis)
+    .add_property("obsBasisScaled", &getReturnValueObsBasisScaled)
+    .add_property("sigma2Theta", &getReturnValueSigma2Theta)
+    .add_property("sigma2ThetaScaled", &getReturnValueSigma2ThetaScaled)
+    .add_property("sigma2ThetaObs", &getReturnValueSigma2ThetaObs)
+    .add_property("sigma2ThetaObsScaled",
+      &getReturnValueSigma2ThetaObsScaled)
+    .add_property("singularValues", &getReturnValueSingularValues)
+    .add_property("singularValuesScaled",
+      &getReturnValueSingularValuesScaled)
     .def_readwrite("numIterations",
       &IncrementalEstimator::ReturnValue::numIterations)
     .def_readwrite("JStart", &IncrementalEstimator::ReturnValue::JStart)
@@ -128,6 +253,25 @@ void exportIncrementalEstimator() {
       &IncrementalEstimator::ReturnValue::elapsedTime)
     ;
 
+  /// Export queue statistics for the IncrementalEstimator class
+  class_<IncrementalEstimator::QueueStatistics>(
+    "IncrementalEstimatorQueueStatistics", init<>())
+    .def_readwrite("numSubmitted",
+      &IncrementalEstimator::QueueStatistics::numSubmitted)
+    .def_readwrite("numProcessed",
+      &IncrementalEstimator::QueueStatistics::numProcessed)
+    .def_readwrite("numDropped",
+      &IncrementalEstimator::QueueStatistics::numDropped)
+    .def_readwrite("queueDepth",
+      &IncrementalEstimator::QueueStatistics::queueDepth)
+    .def_readwrite("maxQueueDepth",
+      &IncrementalEstimator::QueueStatistics::maxQueueDepth)
+    .def_readwrite("meanLatency",
+      &IncrementalEstimator::QueueStatistics::meanLatency)
+    .def_readwrite("maxLatency",
+      &IncrementalEstimator::QueueStatistics::maxLatency)
+    ;
+
   /// Functions for querying the options
   IncrementalEstimator::Options& (IncrementalEstimator::*getOptions)() = 
     &IncrementalEstimator::getOptions;
@@ -163,6 +307,9 @@ void exportIncrementalEstimator() {
     .def("removeBatch", removeBatch2)
     .def("getMargGroupId", &IncrementalEstimator::getMargGroupId)
     .def("getInformationGain", &IncrementalEstimator::getInformationGain)
+    .def("getNumScreenedBatches", &IncrementalEstimator::getNumScreenedBatches)
+    .def("waitForBatches", &IncrementalEstimator::waitForBatches)
+    .def("getQueueStatistics", &IncrementalEstimator::getQueueStatistics)
     .def("getJacobianTranspose", &IncrementalEstimator::getJacobianTranspose,
       return_internal_reference<>())
     .def("getRankPsi", &IncrementalEstimator::getRankPsi)
@@ -183,6 +330,10 @@ void exportIncrementalEstimator() {
     .def("getSigma2ThetaScaled", &getSigma2ThetaScaled)
     .def("getSigma2ThetaObs", &getSigma2ThetaObs)
     .def("getSigma2ThetaObsScaled", &getSigma2ThetaObsScaled)
+    .def("getSigma2ThetaDiagonal", &getSigma2ThetaDiagonal)
+    .def("getSigma2ThetaDiagonalScaled", &getSigma2ThetaDiagonalScaled)
+    .def("getSigma2ThetaBlock", &getSigma2ThetaBlock)
+    .def("getSigma2ThetaBlockScaled", &getSigma2ThetaBlockScaled)
     .def("getSingularValues", &getSingularValues)
     .def("getScaledSingularValues", &getScaledSingularValues)
     .def("getProblem", &IncrementalEstimator::getProblem,